@@ -0,0 +1,75 @@
+/*
+  MySQL Connector/Arduino Example : batch insert
+
+  This example demonstrates how to send several INSERT statements in one
+  round trip. The statements are coalesced in the connection's outgoing
+  buffer and leave in as few TCP segments as possible. The write counters
+  show how many packets were queued and how many writes (segments) were
+  needed to send them.
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  INSTRUCTIONS FOR USE
+
+  1) Create the test_arduino database and hello_arduino table (see
+     the basic_insert example)
+  2) Change the address of the server to the IP address of the MySQL server
+  3) Change the user and password to a valid MySQL user and password
+  4) Connect a USB cable to your Arduino
+  5) Select the correct board and port
+  6) Compile and upload the sketch to your Arduino
+  7) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+
+  Note: The MAC address can be anything so long as it is unique on your network.
+*/
+#include <Ethernet.h>
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+
+byte mac_addr[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED };
+
+IPAddress server_addr(10,0,1,35);  // IP of the MySQL *server* here
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+// Sample statements
+const char *INSERTS[] = {
+  "INSERT INTO test_arduino.hello_arduino (message) VALUES ('batch 1')",
+  "INSERT INTO test_arduino.hello_arduino (message) VALUES ('batch 2')",
+  "INSERT INTO test_arduino.hello_arduino (message) VALUES ('batch 3')",
+  "INSERT INTO test_arduino.hello_arduino (message) VALUES ('batch 4')",
+};
+
+EthernetClient client;
+MySQL_Connection conn((Client *)&client);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+  Ethernet.begin(mac_addr);
+  Serial.println("Connecting...");
+  if (conn.connect(server_addr, 3306, user, password)) {
+    delay(1000);
+  }
+  else
+    Serial.println("Connection failed.");
+}
+
+
+void loop() {
+  delay(2000);
+
+  MySQL_Cursor *cur_mem = new MySQL_Cursor(&conn);
+  conn.reset_write_stats();
+  int ok = cur_mem->execute_batch(INSERTS, 4);
+  delete cur_mem;
+
+  Serial.print(ok);
+  Serial.print(" statements succeeded. Packets: ");
+  Serial.print(conn.get_packets_sent());
+  Serial.print(", segments: ");
+  Serial.print(conn.get_segments_sent());
+  Serial.print(", bytes: ");
+  Serial.println(conn.get_bytes_sent());
+}
@@ -0,0 +1,65 @@
+/*
+  MySQL Connector/Arduino Example : cached select
+
+  This example demonstrates how to cache the result of a small SELECT that
+  is read on every pass of the loop, such as configuration or threshold
+  rows. The server is queried once per time to live (TTL); the other
+  passes are answered from memory through the same cursor methods.
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  INSTRUCTIONS FOR USE
+
+  1) Change the address of the server to the IP address of the MySQL server
+  2) Change the user and password to a valid MySQL user and password
+  3) Connect a USB cable to your Arduino
+  4) Select the correct board and port
+  5) Compile and upload the sketch to your Arduino
+  6) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+
+  Note: The MAC address can be anything so long as it is unique on your network.
+*/
+#include <Ethernet.h>
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+
+byte mac_addr[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED };
+
+IPAddress server_addr(10,0,1,35);  // IP of the MySQL *server* here
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+// Sample query
+char query[] = "SELECT Name, Population FROM world.city WHERE ID = 1";
+
+EthernetClient client;
+MySQL_Connection conn((Client *)&client);
+MySQL_Cache cache(512, 60000);     // 512 bytes, results live for a minute
+MySQL_Cursor cur(&conn);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+  Ethernet.begin(mac_addr);
+  Serial.println("Connecting...");
+  if (conn.connect(server_addr, 3306, user, password)) {
+    delay(1000);
+  }
+  else
+    Serial.println("Connection failed.");
+  cur.set_cache(&cache);
+}
+
+
+void loop() {
+  delay(2000);
+
+  cur.execute(query);
+  cur.show_results();
+
+  Serial.print("Cache hits: ");
+  Serial.print(cache.get_hits());
+  Serial.print(", misses: ");
+  Serial.println(cache.get_misses());
+}
@@ -0,0 +1,80 @@
+/*
+  MySQL Connector/Arduino Example : connection pool
+
+  This example demonstrates how to share a pool of connections between
+  two FreeRTOS tasks on an ESP32. Each task checks out its own connection,
+  so the queries of both cores run in parallel on separate sockets. The
+  connections are opened on first use and validated on each checkout.
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  INSTRUCTIONS FOR USE
+
+  1) Change the address of the server to the IP address of the MySQL server
+  2) Change the user and password to a valid MySQL user and password
+  3) Change the SSID and pass to match your WiFi network
+  4) Connect a USB cable to your ESP32
+  5) Select the correct board and port
+  6) Compile and upload the sketch to your ESP32
+  7) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+*/
+#include <WiFi.h>
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+#include <MySQL_Pool.h>
+
+IPAddress server_addr(10,0,1,35);  // IP of the MySQL *server* here
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+// WiFi card example
+char ssid[] = "your-ssid";         // your SSID
+char pass[] = "ssid-password";     // your SSID Password
+
+// Sample query
+char INSERT_SQL[] = "INSERT INTO test_arduino.hello_arduino (message) VALUES ('Hello from a pooled connection')";
+
+// One client (socket) per pooled connection
+WiFiClient client1;
+WiFiClient client2;
+Client *clients[] = { &client1, &client2 };
+
+MySQL_Pool_Sync_FreeRTOS pool_sync(2);
+MySQL_Pool pool(clients, 2, &pool_sync);
+
+void insert_task(void *param) {
+  for (;;) {
+    MySQL_Connection *conn = pool.checkout();
+    if (conn != NULL) {
+      MySQL_Cursor cur(conn);
+      cur.execute(INSERT_SQL);
+      pool.checkin(conn);
+    }
+    vTaskDelay(pdMS_TO_TICKS(1000));
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+
+  WiFi.begin(ssid, pass);
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(500);
+    Serial.print(".");
+  }
+  Serial.println("\nConnected to network");
+
+  pool.begin(server_addr, 3306, user, password);
+
+  // One writer per core
+  xTaskCreatePinnedToCore(insert_task, "insert0", 8192, NULL, 1, NULL, 0);
+  xTaskCreatePinnedToCore(insert_task, "insert1", 8192, NULL, 1, NULL, 1);
+}
+
+void loop() {
+  Serial.print("Free connections: ");
+  Serial.println(pool.available());
+  delay(5000);
+}
@@ -0,0 +1,115 @@
+/*
+  MySQL Connector/Arduino Example : failover routing
+
+  This example demonstrates how to connect to a list of servers instead
+  of a single address. The primary is given by name and a standby by
+  address; when the primary cannot be reached the sketch connects to the
+  standby and tries the primary again later. Names are resolved with the
+  DNS client of the Ethernet library and kept for 5 minutes.
+
+  The router sends the INSERTs to the primary and the SELECTs to the two
+  replicas in turn. If no replica answers the SELECTs run on the primary.
+
+  CREATE DATABASE test_arduino;
+  CREATE TABLE test_arduino.samples (
+    num integer primary key auto_increment,
+    value integer,
+    recorded timestamp
+  );
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  INSTRUCTIONS FOR USE
+
+  1) Create the database and table as shown above on the primary.
+  2) Change the names and addresses of the servers to those of your servers
+  3) Change the user and password to a valid MySQL user and password
+  4) Connect a USB cable to your Arduino
+  5) Select the correct board and port
+  6) Compile and upload the sketch to your Arduino
+  7) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+
+  Note: The MAC address can be anything so long as it is unique on your network.
+*/
+#include <Ethernet.h>
+#include <Dns.h>
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+#include <MySQL_Hosts.h>
+
+byte mac_addr[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED };
+
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+char INSERT_SQL[] = "INSERT INTO test_arduino.samples (value) VALUES (%d)";
+char SELECT_SQL[] = "SELECT COUNT(*) FROM test_arduino.samples";
+char query[64];
+
+EthernetClient primary_client;
+EthernetClient replica_client1;
+EthernetClient replica_client2;
+MySQL_Connection primary_conn((Client *)&primary_client);
+MySQL_Connection replica_conn1((Client *)&replica_client1);
+MySQL_Connection replica_conn2((Client *)&replica_client2);
+MySQL_Connection *replica_conns[] = { &replica_conn1, &replica_conn2 };
+
+MySQL_Hosts hosts;
+MySQL_Router router(&hosts, &primary_conn, replica_conns, 2);
+
+boolean resolve(const char *name, IPAddress *address, void *arg) {
+  DNSClient dns_client;
+  dns_client.begin(Ethernet.dnsServerIP());
+  return dns_client.getHostByName(name, *address) == 1;
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+  Ethernet.begin(mac_addr);
+
+  hosts.set_resolver(resolve);
+  hosts.add("db-primary.example.com");                  // primary
+  hosts.add(IPAddress(10,0,1,36));                      // standby
+  hosts.add(IPAddress(10,0,1,37), 3306, MYSQL_HOST_REPLICA);
+  hosts.add(IPAddress(10,0,1,38), 3306, MYSQL_HOST_REPLICA);
+  router.begin(user, password);
+}
+
+
+void loop() {
+  MySQL_Connection *conn;
+
+  delay(2000);
+
+  sprintf(query, INSERT_SQL, analogRead(0));
+  conn = router.route(query);
+  if (conn == NULL) {
+    Serial.println("No server reachable.");
+    return;
+  }
+  MySQL_Cursor *cur_mem = new MySQL_Cursor(conn);
+  cur_mem->execute(query);
+  delete cur_mem;
+
+  conn = router.route(SELECT_SQL);
+  if (conn == NULL)
+    return;
+  cur_mem = new MySQL_Cursor(conn);
+  cur_mem->execute(SELECT_SQL);
+  cur_mem->get_columns();
+  row_values *row;
+  while ((row = cur_mem->get_next_row()) != NULL) {
+    Serial.print("Samples: ");
+    Serial.println(row->values[0]);
+  }
+  delete cur_mem;
+
+  Serial.print("Reads on replicas: ");
+  Serial.print(router.get_replica_reads());
+  Serial.print(" of ");
+  Serial.print(router.get_reads());
+  Serial.print(", failovers: ");
+  Serial.println(hosts.get_failovers());
+}
@@ -0,0 +1,116 @@
+/*
+  MySQL Connector/Arduino Example : fetch a result into column arrays
+
+  This example demonstrates how to read a whole result set into one array
+  per column for analysis on the board: here the moving average of the
+  last readings and how many of them are over a threshold. fetch_all()
+  converts each value to the type of its array (int32_t, float or a
+  fixed length string) as the rows arrive, so no strings are allocated
+  per value and each column can be scanned as a plain array.
+
+  The arrays are laid out in a block of the sketch; fetch_all() reads no
+  more rows than fit, so a large result cannot run the board out of
+  memory. The rest of the result is read by the next call.
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  NOTICE: You must create the table below and store readings in it to run
+          this sketch unaltered.
+
+    CREATE TABLE test_arduino.readings (
+      id int primary key auto_increment,
+      value float,
+      sensor char(8)
+    );
+
+  INSTRUCTIONS FOR USE
+
+  1) Change the address of the server to the IP address of the MySQL server
+  2) Change the user and password to a valid MySQL user and password
+  3) Connect a USB cable to your Arduino
+  4) Select the correct board and port
+  5) Compile and upload the sketch to your Arduino
+  6) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+
+  Note: The MAC address can be anything so long as it is unique on your network.
+*/
+#include <Ethernet.h>
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+
+byte mac_addr[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED };
+
+IPAddress server_addr(10,0,1,35);  // IP of the MySQL *server* here
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+// Sample query: the last 100 readings
+char query[] = "SELECT id, value, sensor FROM test_arduino.readings "
+               "ORDER BY id DESC LIMIT 100";
+
+#define MAX_ROWS   100
+#define THRESHOLD  30.0
+
+// Room for MAX_ROWS rows of 4 + 4 + 9 bytes (and alignment)
+byte block[MAX_ROWS * 17 + 16];
+
+mysql_column_array arrays[] = {
+  // name, index, type, width, array, data
+  { "id", -1, MYSQL_ARRAY_INT32, 0, NULL, NULL },
+  { "value", -1, MYSQL_ARRAY_FLOAT, 0, NULL, NULL },
+  { "sensor", -1, MYSQL_ARRAY_STRING, 9, NULL, NULL },
+};
+
+EthernetClient client;
+MySQL_Connection conn((Client *)&client);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+  Ethernet.begin(mac_addr);
+  Serial.println("Connecting...");
+  if (conn.connect(server_addr, 3306, user, password)) {
+    delay(1000);
+  }
+  else
+    Serial.println("Connection failed.");
+}
+
+
+void loop() {
+  int rows;
+
+  delay(5000);
+
+  MySQL_Cursor *cur_mem = new MySQL_Cursor(&conn);
+  cur_mem->execute(query);
+  rows = cur_mem->fetch_all(arrays, 3, MAX_ROWS, block, sizeof(block));
+  cur_mem->discard_results();
+  delete cur_mem;
+  if (rows <= 0) {
+    Serial.println("No readings.");
+    return;
+  }
+
+  int32_t *id = (int32_t *)arrays[0].data;
+  float *value = (float *)arrays[1].data;
+  char *sensor = (char *)arrays[2].data;
+  float sum = 0;
+  int over = 0;
+  for (int r = 0; r < rows; r++) {
+    sum += value[r];
+    if (value[r] > THRESHOLD)
+      over++;
+  }
+  Serial.print("Average of ");
+  Serial.print(rows);
+  Serial.print(" readings: ");
+  Serial.print(sum / rows);
+  Serial.print(", over threshold: ");
+  Serial.println(over);
+  Serial.print("Latest: ");
+  Serial.print(id[0]);
+  Serial.print(" from ");
+  Serial.println(sensor);   // row r is at sensor + r * 9
+}
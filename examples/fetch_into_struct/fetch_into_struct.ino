@@ -0,0 +1,84 @@
+/*
+  MySQL Connector/Arduino Example : fetch rows into a struct
+
+  This example demonstrates how to read the rows of a result set directly
+  into a struct. The columns of the struct are declared once with
+  MYSQL_ROW_MAP and fetch_into() converts each value to the type of its
+  member. The map is checked against the columns of the result set before
+  the first row is decoded.
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  NOTICE: You must download and install the World sample database to run
+          this sketch unaltered. See http://dev.mysql.com/doc/index-other.html.
+
+  INSTRUCTIONS FOR USE
+
+  1) Change the address of the server to the IP address of the MySQL server
+  2) Change the user and password to a valid MySQL user and password
+  3) Connect a USB cable to your Arduino
+  4) Select the correct board and port
+  5) Compile and upload the sketch to your Arduino
+  6) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+
+  Note: The MAC address can be anything so long as it is unique on your network.
+*/
+#include <Ethernet.h>
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+
+byte mac_addr[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED };
+
+IPAddress server_addr(10,0,1,35);  // IP of the MySQL *server* here
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+// Sample query
+char query[] = "SELECT ID, Name, Population FROM world.city LIMIT 12";
+
+// Struct for one row and its column map
+struct City {
+  long id;
+  char name[36];
+  long population;
+};
+
+MYSQL_ROW_MAP(City,
+  MYSQL_COLUMN(City, id, "ID"),
+  MYSQL_COLUMN(City, name, "Name"),
+  MYSQL_COLUMN(City, population, "Population")
+)
+
+EthernetClient client;
+MySQL_Connection conn((Client *)&client);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+  Ethernet.begin(mac_addr);
+  Serial.println("Connecting...");
+  if (conn.connect(server_addr, 3306, user, password)) {
+    delay(1000);
+  }
+  else
+    Serial.println("Connection failed.");
+}
+
+
+void loop() {
+  City city;
+
+  delay(2000);
+
+  MySQL_Cursor *cur_mem = new MySQL_Cursor(&conn);
+  cur_mem->execute(query);
+  while (cur_mem->fetch_into(city)) {
+    Serial.print(city.id);
+    Serial.print(", ");
+    Serial.print(city.name);
+    Serial.print(", ");
+    Serial.println(city.population);
+  }
+  delete cur_mem;
+}
@@ -0,0 +1,107 @@
+/*
+  MySQL Connector/Arduino Example : group commit
+
+  This example demonstrates how to group INSERTs into transactions. Each
+  autocommitted INSERT makes the server flush its log to disk; with a
+  write scheduler on the connection the INSERTs go into a transaction
+  that is committed every 20 samples or every 5 seconds, so the server
+  flushes once per group. The sketch itself runs its INSERTs as usual.
+
+  If a group is rolled back (a failed INSERT or COMMIT) the handler is
+  told which samples were lost so they could be sent again. If the
+  connection is closed while a result set is read, the group is abandoned
+  and the handler is told its outcome is unknown.
+
+  CREATE DATABASE test_arduino;
+  CREATE TABLE test_arduino.samples (
+    num integer primary key auto_increment,
+    value integer,
+    recorded timestamp
+  );
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  INSTRUCTIONS FOR USE
+
+  1) Create the database and table as shown above.
+  2) Change the address of the server to the IP address of the MySQL server
+  3) Change the user and password to a valid MySQL user and password
+  4) Connect a USB cable to your Arduino
+  5) Select the correct board and port
+  6) Compile and upload the sketch to your Arduino
+  7) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+
+  Note: The MAC address can be anything so long as it is unique on your network.
+*/
+#include <Ethernet.h>
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+#include <MySQL_Group_Commit.h>
+
+byte mac_addr[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED };
+
+IPAddress server_addr(10,0,1,35);  // IP of the MySQL *server* here
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+char INSERT_SQL[] = "INSERT INTO test_arduino.samples (value) VALUES (%d)";
+char query[64];
+
+EthernetClient client;
+MySQL_Connection conn((Client *)&client);
+MySQL_Group_Commit group(20, 5000);   // 20 INSERTs or 5 seconds per COMMIT
+
+void lost(unsigned long first, int count, int error, void *arg) {
+  // An abandoned group (connection closed during a result) may or may
+  // not have been committed
+  if (error == MYSQL_GROUP_OUTCOME_UNKNOWN)
+    Serial.print("Unknown outcome for samples ");
+  else
+    Serial.print("Lost samples ");
+  Serial.print(first);
+  Serial.print(" to ");
+  Serial.println(first + count - 1);
+  if (error != MYSQL_GROUP_OUTCOME_UNKNOWN) {
+    Serial.print("Error ");
+    Serial.println(error);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+  Ethernet.begin(mac_addr);
+  Serial.println("Connecting...");
+  if (conn.connect(server_addr, 3306, user, password)) {
+    group.set_failed_handler(lost);
+    conn.set_group_commit(&group);
+    delay(1000);
+  }
+  else
+    Serial.println("Connection failed.");
+}
+
+
+void loop() {
+  const mysql_group_stats *stats;
+
+  delay(200);
+
+  MySQL_Cursor *cur_mem = new MySQL_Cursor(&conn);
+  sprintf(query, INSERT_SQL, analogRead(0));
+  cur_mem->execute(query);
+  delete cur_mem;
+
+  // Commit on time when samples stop coming
+  group.poll();
+
+  stats = group.get_stats();
+  if (stats->commits > 0 && group.pending() == 0) {
+    Serial.print("Committed ");
+    Serial.print(stats->last_size);
+    Serial.print(" samples in ");
+    Serial.print(stats->last_us);
+    Serial.println(" us.");
+  }
+}
@@ -0,0 +1,72 @@
+/*
+  MySQL Connector/Arduino Example : load data local infile
+
+  This example demonstrates how to upload readings buffered in a CSV file
+  on an SD card with a single LOAD DATA LOCAL INFILE statement instead of
+  one INSERT per reading. The file is streamed to the server in small
+  packets so the memory used does not depend on the size of the file.
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  INSTRUCTIONS FOR USE
+
+  1) Create the table on the server:
+     CREATE TABLE test_arduino.readings (id INT, value FLOAT);
+  2) Enable local infile on the server (SET GLOBAL local_infile = 1)
+  3) Save readings as lines of "id,value" in READINGS.CSV on the SD card
+  4) Change the address of the server to the IP address of the MySQL server
+  5) Change the user and password to a valid MySQL user and password
+  6) Connect a USB cable to your Arduino
+  7) Select the correct board and port
+  8) Compile and upload the sketch to your Arduino
+  9) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+
+  Note: The MAC address can be anything so long as it is unique on your network.
+*/
+#include <Ethernet.h>
+#include <SD.h>
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+
+byte mac_addr[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED };
+
+IPAddress server_addr(10,0,1,35);  // IP of the MySQL *server* here
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+// The file name in the statement is not used, the data comes from the SD file
+char LOAD_SQL[] = "LOAD DATA LOCAL INFILE 'readings.csv' "
+                  "INTO TABLE test_arduino.readings "
+                  "FIELDS TERMINATED BY ','";
+
+EthernetClient client;
+MySQL_Connection conn((Client *)&client);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+  Ethernet.begin(mac_addr);
+  SD.begin(4);
+
+  conn.set_local_infile(true);   // must be set before connecting
+  Serial.println("Connecting...");
+  if (conn.connect(server_addr, 3306, user, password)) {
+    File readings = SD.open("READINGS.CSV");
+    MySQL_Cursor *cur_mem = new MySQL_Cursor(&conn);
+    // With the length the data ends without waiting for a timeout
+    cur_mem->set_infile_source(&readings, readings.size());
+    if (cur_mem->execute(LOAD_SQL)) {
+      Serial.print(cur_mem->get_rows_affected());
+      Serial.println(" rows loaded.");
+    }
+    delete cur_mem;
+    readings.close();
+  }
+  else
+    Serial.println("Connection failed.");
+  conn.close();
+}
+
+void loop() {
+}
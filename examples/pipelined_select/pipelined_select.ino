@@ -0,0 +1,88 @@
+/*
+  MySQL Connector/Arduino Example : pipelined select
+
+  This example demonstrates how to read a large result set on an ESP32
+  with the socket read on the other core. A MySQL_Pipeline between the
+  connection and the WiFi client runs a task on core 0 that frames the
+  packets from the server into a queue while loop() decodes the rows on
+  core 1, so reading the socket and decoding the rows overlap. When the
+  sketch falls behind the queue fills and the server is held back.
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  INSTRUCTIONS FOR USE
+
+  1) Change the address of the server to the IP address of the MySQL server
+  2) Change the user and password to a valid MySQL user and password
+  3) Change the SSID and pass to match your WiFi network
+  4) Change the query to one that returns many rows
+  5) Connect a USB cable to your ESP32
+  6) Select the correct board and port
+  7) Compile and upload the sketch to your ESP32
+  8) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+*/
+#include <WiFi.h>
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+#include <MySQL_Pipeline.h>
+
+IPAddress server_addr(10,0,1,35);  // IP of the MySQL *server* here
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+// WiFi card example
+char ssid[] = "your-ssid";         // your SSID
+char pass[] = "ssid-password";     // your SSID Password
+
+// Sample query
+char query[] = "SELECT id, name FROM test_arduino.readings";
+
+WiFiClient client;
+MySQL_Pipeline pipeline(&client);
+MySQL_Connection conn((Client *)&pipeline);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+
+  WiFi.begin(ssid, pass);
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(500);
+    Serial.print(".");
+  }
+  Serial.println("\nConnected to network");
+
+  // 16K queue, the I/O task wakes loop() when a packet is queued
+  if (!pipeline.begin(16384))
+    Serial.println("Pipeline failed.");
+  conn.set_wait(&pipeline);
+
+  Serial.println("Connecting...");
+  if (!conn.connect(server_addr, 3306, user, password))
+    Serial.println("Connection failed.");
+}
+
+void loop() {
+  row_values *row;
+  unsigned long rows = 0;
+  unsigned long started = millis();
+
+  MySQL_Cursor *cur_mem = new MySQL_Cursor(&conn);
+  cur_mem->execute(query);
+  cur_mem->get_columns();
+  while ((row = cur_mem->get_next_row()) != NULL) {
+    rows++;   // use the row here
+  }
+  delete cur_mem;
+
+  Serial.print(rows);
+  Serial.print(" rows in ");
+  Serial.print(millis() - started);
+  Serial.print(" ms, queue stalls: ");
+  Serial.print(pipeline.get_stalls());
+  Serial.print(", deepest: ");
+  Serial.println(pipeline.get_max_depth());
+  pipeline.reset_stats();
+  delay(10000);
+}
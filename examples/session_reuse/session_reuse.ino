@@ -0,0 +1,100 @@
+/*
+  MySQL Connector/Arduino Example : session reuse benchmark
+
+  This example compares three ways of getting a clean session for each
+  report: a full reconnect (close() and connect()), reset() and
+  change_user(). reset() and change_user() reuse the open socket so they
+  skip the TCP connect and the handshake. The average time of each is
+  printed after every round.
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  INSTRUCTIONS FOR USE
+
+  1) Change the address of the server to the IP address of the MySQL server
+  2) Change the user and password to a valid MySQL user and password
+  3) Connect a USB cable to your Arduino
+  4) Select the correct board and port
+  5) Compile and upload the sketch to your Arduino
+  6) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+
+  Note: reset() needs MySQL 5.7.3 or later.
+
+  Note: The MAC address can be anything so long as it is unique on your network.
+*/
+#include <Ethernet.h>
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+
+#define ROUNDS 10
+
+byte mac_addr[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED };
+
+IPAddress server_addr(10,0,1,35);  // IP of the MySQL *server* here
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+EthernetClient client;
+MySQL_Connection conn((Client *)&client);
+
+void report(const char *name, unsigned long total, int count) {
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(count ? total / count : 0);
+  Serial.print(" ms average over ");
+  Serial.print(count);
+  Serial.println(" runs");
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+  Ethernet.begin(mac_addr);
+}
+
+void loop() {
+  unsigned long start;
+  unsigned long total;
+  int count;
+
+  // Full reconnect
+  total = 0;
+  count = 0;
+  for (int i = 0; i < ROUNDS; i++) {
+    start = millis();
+    conn.close();
+    if (conn.connect(server_addr, 3306, user, password)) {
+      total += millis() - start;
+      count++;
+    }
+  }
+  report("reconnect", total, count);
+
+  // Reset on the open connection
+  total = 0;
+  count = 0;
+  for (int i = 0; i < ROUNDS; i++) {
+    start = millis();
+    if (conn.reset()) {
+      total += millis() - start;
+      count++;
+    }
+  }
+  report("reset", total, count);
+
+  // Change user on the open connection
+  total = 0;
+  count = 0;
+  for (int i = 0; i < ROUNDS; i++) {
+    start = millis();
+    if (conn.change_user(user, password)) {
+      total += millis() - start;
+      count++;
+    }
+  }
+  report("change_user", total, count);
+
+  conn.close();
+  delay(5000);
+}
@@ -0,0 +1,104 @@
+/*
+  MySQL Connector/Arduino Example : stream a BLOB value
+
+  This example demonstrates how to read a large BLOB or TEXT value in
+  chunks. get_next_row() copies every value of a row to memory, which a
+  photo or a firmware image does not fit. open_row() starts a row
+  without copying it, next_value() moves to each column and read_value()
+  reads the value into a small buffer of your own, as many times as
+  needed. The bytes are returned exactly, zero bytes included.
+
+  Here the chunks are only added to a checksum; a sketch would write
+  them to an SD card or flash instead.
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  NOTICE: You must create the table below and store a file in it to run
+          this sketch unaltered.
+
+    CREATE TABLE test_arduino.images (
+      id int primary key,
+      name varchar(32),
+      data mediumblob
+    );
+
+  INSTRUCTIONS FOR USE
+
+  1) Change the address of the server to the IP address of the MySQL server
+  2) Change the user and password to a valid MySQL user and password
+  3) Connect a USB cable to your Arduino
+  4) Select the correct board and port
+  5) Compile and upload the sketch to your Arduino
+  6) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+
+  Note: The MAC address can be anything so long as it is unique on your network.
+*/
+#include <Ethernet.h>
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+
+byte mac_addr[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED };
+
+IPAddress server_addr(10,0,1,35);  // IP of the MySQL *server* here
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+// Sample query
+char query[] = "SELECT name, data FROM test_arduino.images WHERE id = 1";
+
+EthernetClient client;
+MySQL_Connection conn((Client *)&client);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+  Ethernet.begin(mac_addr);
+  Serial.println("Connecting...");
+  if (conn.connect(server_addr, 3306, user, password)) {
+    delay(1000);
+  }
+  else
+    Serial.println("Connection failed.");
+}
+
+
+void loop() {
+  byte chunk[256];
+  char name[33];
+  long len;
+  int num;
+
+  delay(2000);
+
+  MySQL_Cursor *cur_mem = new MySQL_Cursor(&conn);
+  cur_mem->execute(query);
+  while (cur_mem->open_row()) {
+    // name
+    len = cur_mem->next_value();
+    num = cur_mem->read_value((byte *)name, sizeof(name) - 1);
+    name[num > 0 ? num : 0] = '\0';
+    Serial.print(name);
+
+    // data, a chunk at a time
+    unsigned long sum = 0;
+    unsigned long total = 0;
+    len = cur_mem->next_value();
+    if (len == MYSQL_VALUE_NULL) {
+      Serial.println(": NULL");
+      continue;
+    }
+    while ((num = cur_mem->read_value(chunk, sizeof(chunk))) > 0) {
+      for (int i = 0; i < num; i++)
+        sum = (sum << 1 | sum >> 31) ^ chunk[i];
+      total += num;
+    }
+    Serial.print(": ");
+    Serial.print(total);
+    Serial.print(" of ");
+    Serial.print(len);
+    Serial.print(" bytes, checksum ");
+    Serial.println(sum, HEX);
+  }
+  delete cur_mem;
+}
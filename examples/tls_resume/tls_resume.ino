@@ -0,0 +1,124 @@
+/*
+  MySQL Connector/Arduino Example : TLS connect with session resumption
+
+  This example encrypts the connection with TLS (mbed TLS on the ESP32)
+  and compares the time of connects with a full TLS handshake to connects
+  that resume the saved session. Clearing the session cache forces a full
+  handshake. The average time of each is printed after every round.
+
+  Use a MySQL server close to the board (e.g. on the same LAN) so the
+  numbers show the cost of the handshake rather than the network. MySQL
+  5.7 and later create a certificate at startup and accept TLS; resumption
+  needs MySQL 8.0.29 or later (ssl_session_cache_mode=ON, the default).
+  extras/host/tls_bench makes the same comparison on a PC against a
+  stand-in, without a board or a server.
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  INSTRUCTIONS FOR USE
+
+  1) Change the address of the server to the IP address of the MySQL server
+  2) Change the user and password to a valid MySQL user and password
+  3) Change the SSID and pass to match your WiFi network
+  4) Paste the CA certificate (PEM) that signed the server certificate
+     in ca_cert (ca.pem in the data directory of the server) and set
+     server_name to the name in the server certificate. To test without
+     verifying the server, uncomment the tls.set_insecure(true) line.
+  5) Connect a USB cable to your ESP32
+  6) Select the correct board and port
+  7) Compile and upload the sketch to your ESP32
+  8) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+*/
+#include <WiFi.h>
+#include <MySQL_Connection.h>
+#include <MySQL_TLS_Mbedtls.h>
+
+#define ROUNDS 10
+
+IPAddress server_addr(10,0,1,35);  // IP of the MySQL *server* here
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+// WiFi card example
+char ssid[] = "your-ssid";         // your SSID
+char pass[] = "ssid-password";     // your SSID Password
+
+// PEM of the CA that signed the server certificate
+const char ca_cert[] =
+  "-----BEGIN CERTIFICATE-----\n"
+  "...\n"
+  "-----END CERTIFICATE-----\n";
+const char *server_name = "mysql.example.com";  // name in the certificate
+
+WiFiClient client;
+MySQL_TLS_Mbedtls tls(ca_cert);
+MySQL_TLS_Cache sessions;
+MySQL_Connection conn((Client *)&client);
+
+void report(const char *name, unsigned long total, int count) {
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(count ? total / count : 0);
+  Serial.print(" ms average over ");
+  Serial.print(count);
+  Serial.println(" connects");
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+
+  // Begin WiFi section
+  WiFi.begin(ssid, pass);
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(500);
+    Serial.print(".");
+  }
+  Serial.println();
+  // End WiFi section
+
+  // tls.set_insecure(true);  // testing only: do not verify the server
+  conn.set_tls(&tls, &sessions, server_name);
+}
+
+void loop() {
+  unsigned long start;
+  unsigned long total;
+  int count;
+
+  // Full handshakes: forget the session before each connect
+  total = 0;
+  count = 0;
+  for (int i = 0; i < ROUNDS; i++) {
+    sessions.clear();
+    start = millis();
+    if (conn.connect(server_addr, 3306, user, password)) {
+      total += millis() - start;
+      count++;
+    }
+    conn.close();
+  }
+  report("full handshake", total, count);
+
+  // Resumed handshakes: the session saved by the last connect is offered
+  total = 0;
+  count = 0;
+  for (int i = 0; i < ROUNDS; i++) {
+    start = millis();
+    if (conn.connect(server_addr, 3306, user, password) &&
+        conn.tls_resumed()) {
+      total += millis() - start;
+      count++;
+    }
+    conn.close();
+  }
+  report("resumed", total, count);
+
+  Serial.print("Sessions resumed: ");
+  Serial.print(sessions.get_resumed());
+  Serial.print(" of ");
+  Serial.println(sessions.get_resumed() + sessions.get_full());
+
+  delay(5000);
+}
@@ -0,0 +1,84 @@
+/*
+  MySQL Connector/Arduino Example : trace record and replay
+
+  This example demonstrates how to record the traffic of a connection to a
+  trace file on an SD card and how to replay it without a server. The
+  replay runs the same sketch code against the recorded bytes, so it can
+  be used to time the result set handling reproducibly. Copy the trace to
+  a host to replay it there.
+
+  For more information and documentation, visit the wiki:
+  https://github.com/ChuckBell/MySQL_Connector_Arduino/wiki.
+
+  NOTICE: You must download and install the World sample database to run
+          this sketch unaltered. See http://dev.mysql.com/doc/index-other.html.
+
+  INSTRUCTIONS FOR USE
+
+  1) Change the address of the server to the IP address of the MySQL server
+  2) Change the user and password to a valid MySQL user and password
+  3) Insert an SD card in the Ethernet shield
+  4) Connect a USB cable to your Arduino
+  5) Select the correct board and port
+  6) Compile and upload the sketch to your Arduino
+  7) Once uploaded, open Serial Monitor (use 115200 speed) and observe
+
+  Note: The MAC address can be anything so long as it is unique on your network.
+*/
+#include <Ethernet.h>
+#include <SD.h>
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+#include <MySQL_Trace.h>
+
+byte mac_addr[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED };
+
+IPAddress server_addr(10,0,1,35);  // IP of the MySQL *server* here
+char user[] = "root";              // MySQL user login username
+char password[] = "secret";        // MySQL user login password
+
+// Sample query
+char query[] = "SELECT * FROM world.city LIMIT 12";
+
+EthernetClient client;
+
+// Run the same session against a live or a replayed client
+void session(Client *session_client) {
+  MySQL_Connection conn(session_client);
+  if (conn.connect(server_addr, 3306, user, password)) {
+    MySQL_Cursor *cur_mem = new MySQL_Cursor(&conn);
+    cur_mem->execute(query);
+    cur_mem->show_results();
+    delete cur_mem;
+    conn.close();
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // wait for serial port to connect
+  Ethernet.begin(mac_addr);
+  SD.begin(4);
+
+  // Record a session
+  SD.remove("session.trc");
+  File out = SD.open("session.trc", FILE_WRITE);
+  MySQL_Trace_Recorder recorder(&client, &out);
+  session(&recorder);
+  out.close();
+
+  // Replay it as fast as possible and time it
+  File in = SD.open("session.trc");
+  MySQL_Trace_Replay replay(&in, 0);
+  unsigned long start = millis();
+  session(&replay);
+  Serial.print("Replay took ");
+  Serial.print(millis() - start);
+  Serial.println(" ms.");
+  if (replay.get_mismatch() >= 0)
+    Serial.println("The replay did not send what was recorded.");
+  in.close();
+}
+
+void loop() {
+}
@@ -0,0 +1,6 @@
+/*
+  Arduino.cpp - Arduino API for host builds (see include/Arduino.h)
+*/
+#include <Arduino.h>
+
+HostSerial Serial;
@@ -0,0 +1,262 @@
+/*
+  MySQL Connector/Arduino Example : epoll load benchmark (Linux host)
+
+  This program runs many MySQL_Connection instances on one MySQL_Epoll
+  loop in a single thread. Each connection connects, runs a number of
+  SELECT queries reading every row and disconnects. The program prints
+  the query rate, the latency percentiles and how many system calls and
+  task switches the driver needed.
+
+  By default it starts a protocol stand-in on 127.0.0.1 in a second
+  thread: it answers the handshake, accepts any user and returns a small
+  result set for every query, so the numbers show the cost of the
+  connector and the driver rather than of a server. Give the address of
+  a real server to run the same load against it.
+
+  See ../README.md to build it. Run:
+
+    ./epoll_load [connections [queries [rows]]]
+    ./epoll_load 200 100 10 192.168.0.2 3306 user password
+*/
+#include <MySQL_Epoll.h>
+#include <MySQL_Cursor.h>
+#include <standin.h>
+#include <thread>
+#include <errno.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+/*
+  The protocol stand-in (see standin.h) on a socket, one StandIn_Server
+  per connection
+*/
+class SocketStandIn {
+  public:
+    SocketStandIn(int rows) : rows(rows), stopping(false) {}
+
+    uint16_t start() {
+      struct sockaddr_in addr;
+      socklen_t len = sizeof(addr);
+      int one = 1;
+
+      listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+      setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      memset(&addr, 0, sizeof(addr));
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+          listen(listener, 1024) < 0)
+        return 0;
+      getsockname(listener, (struct sockaddr *)&addr, &len);
+      poller = epoll_create1(0);
+      add(listener);
+      worker = std::thread(&SocketStandIn::serve, this);
+      return ntohs(addr.sin_port);
+    }
+
+    void stop() {
+      stopping = true;
+      worker.join();
+      close(poller);
+      close(listener);
+    }
+
+  private:
+    typedef StandIn_Server Session;
+
+    void add(int fd) {
+      struct epoll_event event;
+      event.events = EPOLLIN;
+      event.data.fd = fd;
+      epoll_ctl(poller, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    void serve() {
+      struct epoll_event events[128];
+      while (!stopping) {
+        int num = epoll_wait(poller, events, 128, 50);
+        for (int i = 0; i < num; i++) {
+          int fd = events[i].data.fd;
+          if (fd == listener)
+            accept_all();
+          else
+            receive(fd);
+        }
+      }
+      for (size_t fd = 0; fd < sessions.size(); fd++)
+        if (sessions[fd]) {
+          close(fd);
+          delete sessions[fd];
+        }
+    }
+
+    void accept_all() {
+      int fd;
+      while ((fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+        if ((size_t)fd >= sessions.size())
+          sessions.resize(fd + 1, NULL);
+        Session *s = new Session();
+        s->set_rows(rows);
+        s->start();
+        sessions[fd] = s;
+        send_out(fd, s);
+        add(fd);
+      }
+    }
+
+    void receive(int fd) {
+      Session *s = sessions[fd];
+      uint8_t chunk[4096];
+      ssize_t got;
+
+      while ((got = read(fd, chunk, sizeof(chunk))) > 0)
+        s->receive(chunk, got);
+      if (got == 0 || (got < 0 && errno != EAGAIN) || !s->is_open()) {
+        drop(fd);
+        return;
+      }
+      send_out(fd, s);
+    }
+
+    void drop(int fd) {
+      close(fd);
+      delete sessions[fd];
+      sessions[fd] = NULL;
+    }
+
+    void send_out(int fd, Session *s) {
+      size_t sent = 0;
+      while (sent < s->out.size()) {
+        ssize_t n = write(fd, &s->out[sent], s->out.size() - sent);
+        if (n <= 0)
+          break;   // the client reads everything, a short wait is fine
+        sent += n;
+      }
+      s->out.erase(s->out.begin(), s->out.begin() + sent);
+    }
+
+    int rows;
+    volatile bool stopping;
+    int listener;
+    int poller;
+    std::thread worker;
+    std::vector<Session *> sessions;
+};
+
+/*
+  The load: each task connects, runs its queries and disconnects
+*/
+struct Load {
+  IPAddress server;
+  int port;
+  char *user;
+  char *password;
+  int queries;
+  std::vector<unsigned long> latency;   // microseconds, all tasks
+  int failed;
+  long rows;
+};
+
+static void run_queries(MySQL_Connection *conn, void *arg) {
+  Load *load = (Load *)arg;
+
+  if (!conn->connect(load->server, load->port, load->user, load->password)) {
+    load->failed++;
+    return;
+  }
+  for (int q = 0; q < load->queries; q++) {
+    MySQL_Cursor cur(conn);
+    unsigned long started = micros();
+    if (!cur.execute("SELECT id, name FROM bench.t")) {
+      load->failed++;
+      break;
+    }
+    cur.get_columns();
+    while (cur.get_next_row() != NULL)
+      load->rows++;
+    load->latency.push_back(micros() - started);
+  }
+  conn->close();
+}
+
+static unsigned long percentile(std::vector<unsigned long> &values, int p) {
+  if (values.empty())
+    return 0;
+  return values[(values.size() - 1) * p / 100];
+}
+
+int main(int argc, char **argv) {
+  int connections = argc > 1 ? atoi(argv[1]) : 200;
+  int queries = argc > 2 ? atoi(argv[2]) : 100;
+  int rows = argc > 3 ? atoi(argv[3]) : 10;
+  SocketStandIn standin(rows);
+  Load load;
+  struct rlimit files;
+
+  // Two descriptors per connection with the stand-in in this process
+  getrlimit(RLIMIT_NOFILE, &files);
+  files.rlim_cur = files.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &files);
+
+  load.queries = queries;
+  load.failed = 0;
+  load.rows = 0;
+  load.user = (char *)(argc > 6 ? argv[6] : "bench");
+  load.password = (char *)(argc > 7 ? argv[7] : "secret");
+  if (argc > 5) {
+    load.server = IPAddress(inet_addr(argv[4]));
+    load.port = atoi(argv[5]);
+  } else {
+    load.server = IPAddress(127, 0, 0, 1);
+    load.port = standin.start();
+    if (load.port == 0) {
+      printf("Cannot start the stand-in server.\n");
+      return 1;
+    }
+  }
+  load.latency.reserve((size_t)connections * queries);
+  // Errors are counted, the Connected line of each connection is not needed
+  mysql_log_set_output(NULL);
+
+  MySQL_Epoll driver(connections);
+  std::vector<MySQL_Posix_Client *> clients;
+  std::vector<MySQL_Connection *> conns;
+  for (int i = 0; i < connections; i++) {
+    clients.push_back(new MySQL_Posix_Client());
+    conns.push_back(new MySQL_Connection(clients[i]));
+    driver.add(conns[i], clients[i], run_queries, &load);
+  }
+
+  unsigned long started = micros();
+  driver.run();
+  double seconds = (micros() - started) / 1e6;
+
+  unsigned long reads = 0, writes = 0;
+  for (int i = 0; i < connections; i++) {
+    reads += clients[i]->get_read_calls();
+    writes += clients[i]->get_write_calls();
+    delete conns[i];
+    delete clients[i];
+  }
+  if (argc <= 5)
+    standin.stop();
+
+  std::sort(load.latency.begin(), load.latency.end());
+  size_t done = load.latency.size();
+  printf("connections %d, queries %zu, rows %ld, failed %d\n",
+         connections, done, load.rows, load.failed);
+  printf("%.3f s, %.0f queries/s\n", seconds, done / seconds);
+  printf("latency us: p50 %lu  p90 %lu  p99 %lu  max %lu\n",
+         percentile(load.latency, 50), percentile(load.latency, 90),
+         percentile(load.latency, 99), percentile(load.latency, 100));
+  printf("epoll_wait %lu, wakeups %lu, switches %lu\n",
+         driver.get_polls(), driver.get_wakeups(), driver.get_switches());
+  if (done)
+    printf("per query: readv %.2f, writev %.2f\n",
+           (double)reads / done, (double)writes / done);
+  return load.failed ? 1 : 0;
+}
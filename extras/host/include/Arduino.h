@@ -0,0 +1,130 @@
+/*
+  Arduino.h - Arduino API for host builds
+
+  The types and functions of the Arduino core the connector uses, so it
+  can be compiled for Linux with the POSIX client (see ../README.md).
+  Serial writes to standard output.
+*/
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <Print.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+inline unsigned long millis() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000UL + now.tv_nsec / 1000000UL;
+}
+
+inline unsigned long micros() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000UL + now.tv_nsec / 1000UL;
+}
+
+inline void delay(unsigned long ms) { usleep(ms * 1000); }
+inline void yield() {}
+
+class Stream : public Print {
+  public:
+    Stream() : _timeout(1000) {}
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    void setTimeout(unsigned long ms) { _timeout = ms; }
+    // Waits up to the timeout for each byte, like the Arduino class
+    size_t readBytes(uint8_t *buf, size_t size) {
+      size_t n = 0;
+      while (n < size) {
+        int c = timedRead();
+        if (c < 0)
+          break;
+        buf[n++] = (uint8_t)c;
+      }
+      return n;
+    }
+    size_t readBytes(char *buf, size_t size) {
+      return readBytes((uint8_t *)buf, size);
+    }
+
+  protected:
+    int timedRead() {
+      unsigned long start = millis();
+      do {
+        int c = read();
+        if (c >= 0)
+          return c;
+        yield();
+      } while (millis() - start < _timeout);
+      return -1;
+    }
+
+    unsigned long _timeout;
+};
+
+// IPv4 address, kept in network byte order like the Arduino class
+class IPAddress {
+  public:
+    IPAddress() { memset(bytes, 0, 4); }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+      bytes[0] = a; bytes[1] = b; bytes[2] = c; bytes[3] = d;
+    }
+    IPAddress(uint32_t address) { memcpy(bytes, &address, 4); }
+    operator uint32_t() const {
+      uint32_t address;
+      memcpy(&address, bytes, 4);
+      return address;
+    }
+    bool operator==(const IPAddress &other) const {
+      return memcmp(bytes, other.bytes, 4) == 0;
+    }
+    uint8_t operator[](int index) const { return bytes[index]; }
+    uint8_t &operator[](int index) { return bytes[index]; }
+
+  private:
+    uint8_t bytes[4];
+};
+
+class Client : public Stream {
+  public:
+    virtual int connect(IPAddress ip, uint16_t port) = 0;
+    virtual int connect(const char *host, uint16_t port) = 0;
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t *buf, size_t size) = 0;
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int read(uint8_t *buf, size_t size) = 0;
+    virtual int peek() = 0;
+    virtual void flush() = 0;
+    virtual void stop() = 0;
+    virtual uint8_t connected() = 0;
+    virtual operator bool() = 0;
+    using Print::write;
+};
+
+class HostSerial : public Stream {
+  public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) { return fwrite(&c, 1, 1, stdout); }
+    size_t write(const uint8_t *buf, size_t size) {
+      return fwrite(buf, 1, size, stdout);
+    }
+    using Print::write;
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+    void flush() { fflush(stdout); }
+    operator bool() { return true; }
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,12 @@
+/*
+  Ethernet.h - Stand-in for the Ethernet library in host builds
+
+  The connector includes Ethernet.h on boards other than the ESP32 and
+  ESP8266. On a host the network is reached with MySQL_Posix_Client.
+*/
+#ifndef HOST_ETHERNET_H
+#define HOST_ETHERNET_H
+
+#include <Arduino.h>
+
+#endif
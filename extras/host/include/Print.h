@@ -0,0 +1,77 @@
+/*
+  Print.h - Arduino Print class for host builds
+
+  The part of the Arduino Print class the connector uses, so it can be
+  compiled for Linux with the POSIX client (see ../README.md).
+*/
+#ifndef HOST_PRINT_H
+#define HOST_PRINT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Program memory is ordinary memory on a host
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+#define strlen_P strlen
+#define memcpy_P memcpy
+#define strcmp_P strcmp
+
+#define DEC 10
+#define HEX 16
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t size) {
+      size_t n = 0;
+      while (size--)
+        n += write(*buf++);
+      return n;
+    }
+    size_t write(const char *str) {
+      return str ? write((const uint8_t *)str, strlen(str)) : 0;
+    }
+    virtual void flush() {}
+
+    size_t print(const char *str) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char n, int base=DEC) {
+      return print((unsigned long)n, base);
+    }
+    size_t print(int n, int base=DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base=DEC) {
+      return print((unsigned long)n, base);
+    }
+    size_t print(long n, int base=DEC) {
+      char text[24];
+      snprintf(text, sizeof(text), base == HEX ? "%lX" : "%ld", n);
+      return write(text);
+    }
+    size_t print(unsigned long n, int base=DEC) {
+      char text[24];
+      snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", n);
+      return write(text);
+    }
+    size_t print(double n, int digits=2) {
+      char text[48];
+      snprintf(text, sizeof(text), "%.*f", digits, n);
+      return write(text);
+    }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(T value) {
+      size_t n = print(value);
+      return n + println();
+    }
+    template <typename T> size_t println(T value, int format) {
+      size_t n = print(value, format);
+      return n + println();
+    }
+};
+
+#endif
@@ -0,0 +1,267 @@
+/*
+  standin.h - Protocol stand-in for the host programs
+
+  Just enough of a MySQL server for the benchmarks and the soak test. It
+  sends a handshake asking for mysql_native_password, accepts any user,
+  answers an OK packet to statements other than SELECT and a result set
+  of two columns (id, name) with set_rows() rows to SELECT. COM_QUIT
+  ends the session. A subclass offering CLIENT_SSL (set_caps()) is told
+  when the client asks for TLS (start_tls()). The packet builders are also used by the programs
+  that make packets of their own.
+
+  StandIn_Server only turns requests into replies; the program moves the
+  bytes. StandIn is a Client that does it in memory, for programs that
+  need no network.
+*/
+#ifndef HOST_STANDIN_H
+#define HOST_STANDIN_H
+
+#include <Arduino.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+typedef std::vector<uint8_t> bytes;
+
+// Capabilities of the handshake (CLIENT_DEPRECATE_EOF, plugin auth,
+// secure connection, protocol 41 and the basic flags)
+#define STANDIN_DEPRECATE_EOF  0x01000000UL
+#define STANDIN_SSL            0x00000800UL
+#define STANDIN_CAPS  (STANDIN_DEPRECATE_EOF | 0x00038000UL | 0x2000UL | \
+                       0x20fUL)
+
+/*
+  Packet builders
+*/
+// Length coded integer
+static inline void standin_lcb(bytes &p, unsigned long long n) {
+  if (n < 251) {
+    p.push_back(n);
+  } else if (n < 0x10000) {
+    p.insert(p.end(), {0xfc, (uint8_t)n, (uint8_t)(n >> 8)});
+  } else if (n < 0x1000000) {
+    p.insert(p.end(), {0xfd, (uint8_t)n, (uint8_t)(n >> 8),
+                       (uint8_t)(n >> 16)});
+  } else {
+    p.push_back(0xfe);
+    for (int i = 0; i < 8; i++)
+      p.push_back((uint8_t)(n >> (8 * i)));
+  }
+}
+
+// Length coded string
+static inline void standin_text(bytes &p, const std::string &value) {
+  standin_lcb(p, value.size());
+  p.insert(p.end(), value.begin(), value.end());
+}
+
+// Append a packet: 3 byte length, sequence number, payload
+static inline void standin_packet(bytes &out, uint8_t seq,
+                                  const bytes &payload) {
+  size_t n = payload.size();
+  out.push_back(n & 0xff);
+  out.push_back((n >> 8) & 0xff);
+  out.push_back((n >> 16) & 0xff);
+  out.push_back(seq);
+  out.insert(out.end(), payload.begin(), payload.end());
+}
+
+// Handshake with the scramble "abcdefghijklmnopqrst"
+static inline void standin_handshake(bytes &out, const char *version,
+                                     unsigned long caps=STANDIN_CAPS) {
+  bytes p = {10};
+  p.insert(p.end(), version, version + strlen(version) + 1);
+  p.insert(p.end(), {1, 0, 0, 0});
+  p.insert(p.end(), {'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 0});
+  p.insert(p.end(), {(uint8_t)caps, (uint8_t)(caps >> 8), 8, 2, 0,
+                     (uint8_t)(caps >> 16), (uint8_t)(caps >> 24), 21});
+  p.insert(p.end(), 10, 0);
+  const char *rest = "ijklmnopqrst";
+  p.insert(p.end(), rest, rest + 13);
+  const char *plugin = "mysql_native_password";
+  p.insert(p.end(), plugin, plugin + strlen(plugin) + 1);
+  standin_packet(out, 0, p);
+}
+
+// OK packet (header 0xfe ends a result set with CLIENT_DEPRECATE_EOF)
+static inline void standin_ok(bytes &out, uint8_t seq, uint8_t header=0x00,
+                              uint8_t affected=0) {
+  standin_packet(out, seq, {header, affected, 0, 0x02, 0x00, 0, 0});
+}
+
+// End of the column definitions or of the rows
+static inline void standin_eof(bytes &out, uint8_t seq,
+                               unsigned long flags) {
+  if (flags & STANDIN_DEPRECATE_EOF)
+    standin_ok(out, seq, 0xfe);
+  else
+    standin_packet(out, seq, {0xfe, 0, 0, 0x02, 0x00});
+}
+
+// Column definition
+static inline void standin_field(bytes &out, uint8_t seq, const char *db,
+                                 const std::string &table,
+                                 const std::string &name, uint8_t type,
+                                 unsigned long length=11) {
+  bytes f;
+  standin_text(f, "def");
+  standin_text(f, db);
+  standin_text(f, table);
+  standin_text(f, table);
+  standin_text(f, name);
+  standin_text(f, name);
+  f.insert(f.end(), {12, 8, 0, (uint8_t)length, (uint8_t)(length >> 8),
+                     (uint8_t)(length >> 16), (uint8_t)(length >> 24), type,
+                     0, 0, 0, 0, 0});
+  standin_packet(out, seq, f);
+}
+
+/*
+  StandIn_Server: the replies of the stand-in to the requests of a client
+*/
+class StandIn_Server {
+  public:
+    StandIn_Server(const char *version="8.0.0-standin")
+      : version(version), caps(STANDIN_CAPS), rows(0), authed(false),
+        open(false), flags(0) {}
+    virtual ~StandIn_Server() {}
+
+    void set_rows(int num_rows) { rows = num_rows; }
+    void set_caps(unsigned long server_caps) { caps = server_caps; }
+
+    // A client connected: the handshake is the first reply
+    void start() {
+      in.clear();
+      out.clear();
+      authed = false;
+      open = true;
+      flags = 0;
+      standin_handshake(out, version, caps);
+    }
+
+    // Bytes from the client; the replies are appended to out
+    void receive(const uint8_t *buf, size_t size) {
+      in.insert(in.end(), buf, buf + size);
+      while (in.size() >= 4) {
+        size_t len = in[0] | (in[1] << 8) | (in[2] << 16);
+        if (in.size() < len + 4)
+          break;
+        bytes payload(in.begin() + 4, in.begin() + 4 + len);
+        uint8_t seq = in[3];
+        in.erase(in.begin(), in.begin() + 4 + len);
+        answer(payload, seq);
+      }
+    }
+
+    // The client closed the connection
+    void end() { open = false; }
+
+    // False after COM_QUIT or end()
+    bool is_open() { return open; }
+
+    bytes out;                // replies not taken by the program yet
+
+  protected:
+    // The client sent an SSL request: the bytes that follow are TLS
+    // records, the authentication packet comes over TLS
+    virtual void start_tls() {}
+
+    // Values of row r (from 0) of the result set
+    virtual void row(int r, bytes &p) {
+      standin_text(p, std::to_string(r + 1));
+      standin_text(p, "sensor-" + std::to_string(r + 1));
+    }
+
+  private:
+    void answer(const bytes &p, uint8_t seq) {
+      if (!authed) {
+        if (p.size() >= 4)
+          flags = p[0] | (p[1] << 8) | (p[2] << 16) |
+                  ((unsigned long)p[3] << 24);
+        if (p.size() == 32 && (flags & STANDIN_SSL)) {   // SSL request
+          start_tls();
+          return;
+        }
+        authed = true;
+        standin_ok(out, seq + 1);
+        return;
+      }
+      if (p.empty() || p[0] == 0x01) {     // COM_QUIT
+        open = false;
+        return;
+      }
+      if (p[0] != 0x03 || p.size() < 7 || memcmp(&p[1], "SELECT", 6) != 0) {
+        standin_ok(out, 1, 0x00, 1);
+        return;
+      }
+      uint8_t n = 1;
+      standin_packet(out, n++, {2});
+      standin_field(out, n++, "standin", "t", "id", 3);
+      standin_field(out, n++, "standin", "t", "name", 253, 255);
+      if (!(flags & STANDIN_DEPRECATE_EOF))
+        standin_eof(out, n++, flags);
+      for (int r = 0; r < rows; r++) {
+        bytes values;
+        row(r, values);
+        standin_packet(out, n++, values);
+      }
+      standin_eof(out, n, flags);
+    }
+
+    const char *version;
+    unsigned long caps;       // capabilities offered in the handshake
+    int rows;
+    bool authed;
+    bool open;
+    unsigned long flags;      // capabilities the client asked for
+    bytes in;
+};
+
+/*
+  StandIn: a Client talking to the stand-in in memory
+*/
+class StandIn : public Client, public StandIn_Server {
+  public:
+    StandIn(const char *version="8.0.0-standin")
+      : StandIn_Server(version), pos(0) {}
+
+    int connect(IPAddress, uint16_t) {
+      pos = 0;
+      start();
+      return 1;
+    }
+    int connect(const char *, uint16_t port) {
+      return connect(IPAddress(), port);
+    }
+    size_t write(uint8_t b) { return write(&b, 1); }
+    size_t write(const uint8_t *buf, size_t size) {
+      receive(buf, size);
+      return size;
+    }
+    int available() { return (int)(out.size() - pos); }
+    int read() {
+      uint8_t b;
+      return read(&b, 1) == 1 ? b : -1;
+    }
+    int read(uint8_t *buf, size_t size) {
+      size_t n = std::min(size, out.size() - pos);
+      memcpy(buf, out.data() + pos, n);
+      pos += n;
+      if (pos == out.size()) {
+        out.clear();
+        pos = 0;
+      }
+      return (int)n;
+    }
+    int peek() { return pos < out.size() ? out[pos] : -1; }
+    void flush() {}
+    void stop() { end(); }
+    uint8_t connected() { return is_open(); }
+    operator bool() { return is_open(); }
+    using Print::write;
+
+  protected:
+    size_t pos;               // bytes of out read
+};
+
+#endif
@@ -0,0 +1,387 @@
+/*
+  MySQL Connector/Arduino Example : decoding micro benchmarks (host)
+
+  This program times the functions that decode the protocol: the length
+  coded integers (get_lcb_len(), read_lcb_int(), read_int()), strings
+  (read_string()), column definitions (get_field()), packet framing
+  (read_packet()), the handshake (parse_handshake_packet()) and the
+  password scramble (scramble_password()). They run on synthetic packets
+  of the shapes a sketch sees: narrow and wide rows, long strings and
+  rows that are mostly NULL. Packets read from the client come from an
+  in-memory client that replays them, so no network is involved.
+
+  Each line of the output is one benchmark in CSV form:
+
+    benchmark,shape,ns_per_op,allocs_per_op
+
+  ns_per_op is the best of several runs, allocs_per_op counts the calls
+  to mysql_malloc() (MYSQL_HEAP_STATS). Save the output of two commits
+  and compare them, or give the saved file of the first one with
+  --baseline to add its time and the change in percent to each line:
+
+    ./micro_bench > before.csv
+    ./micro_bench --baseline before.csv
+    ./micro_bench --filter read_string
+
+  See ../README.md to build it.
+*/
+#include <MySQL_Cursor.h>
+#include <chrono>
+#include <standin.h>
+
+#define RUNS          5     // runs per benchmark, the fastest is reported
+#define RUN_NS  20000000    // aim for runs of at least 20 ms
+
+static volatile long sink;  // keeps the results from being optimized away
+
+/*
+  Client that replays a byte stream endlessly, as fast as it is read
+*/
+class ReplayClient : public Client {
+  public:
+    void set_stream(const bytes &data) { stream = data; pos = 0; }
+
+    int connect(IPAddress, uint16_t) { return 1; }
+    int connect(const char *, uint16_t) { return 1; }
+    size_t write(uint8_t) { return 1; }
+    size_t write(const uint8_t *, size_t size) { return size; }
+    int available() { return stream.empty() ? 0 : 0x7fff; }
+    int read() {
+      uint8_t b;
+      return read(&b, 1) == 1 ? b : -1;
+    }
+    int read(uint8_t *buf, size_t size) {
+      size_t done = 0;
+      while (done < size && !stream.empty()) {
+        size_t n = std::min(size - done, stream.size() - pos);
+        memcpy(buf + done, &stream[pos], n);
+        done += n;
+        pos = (pos + n) % stream.size();
+      }
+      return (int)done;
+    }
+    int peek() { return stream.empty() ? -1 : stream[pos]; }
+    void flush() {}
+    void stop() {}
+    uint8_t connected() { return 1; }
+    operator bool() { return true; }
+    using Print::write;
+
+  private:
+    bytes stream;
+    size_t pos;
+};
+
+/*
+  Synthetic packets
+*/
+// Prepend the header (3 byte length, sequence)
+static bytes packet(const bytes &payload, uint8_t seq=1) {
+  bytes p;
+  standin_packet(p, seq, payload);
+  return p;
+}
+
+struct Shape {
+  const char *name;
+  int columns;
+  bytes row;          // row packet with its header
+};
+
+// A row of columns values; NULL where null_every divides the column
+static Shape row_shape(const char *name, int columns, size_t value_len,
+                       int null_every=0) {
+  bytes payload;
+  for (int c = 0; c < columns; c++) {
+    if (null_every && c % null_every != 0)
+      payload.push_back(0xfb);
+    else
+      standin_text(payload, std::string(value_len, 'a' + c % 26));
+  }
+  return Shape{name, columns, packet(payload)};
+}
+
+static std::vector<Shape> row_shapes() {
+  std::vector<Shape> shapes;
+  shapes.push_back(row_shape("narrow", 3, 8));
+  shapes.push_back(row_shape("wide", 32, 10));
+  shapes.push_back(row_shape("long", 2, 1000));
+  shapes.push_back(row_shape("nulls", 24, 10, 4));
+  return shapes;
+}
+
+static bytes field_packet(const std::string &table, const std::string &name,
+                          uint8_t type) {
+  bytes p;
+  standin_field(p, 2, "sensors", table, name, type);
+  return p;
+}
+
+// Offers every capability the connector knows
+static bytes handshake_packet(const char *version) {
+  bytes p;
+  standin_handshake(p, version, STANDIN_DEPRECATE_EOF | 0x000ff7ff);
+  return p;
+}
+
+/*
+  Measurement
+*/
+struct Result {
+  std::string benchmark;
+  std::string shape;
+  double ns_per_op;
+  double allocs_per_op;
+};
+
+static std::vector<Result> results;
+static const char *filter = NULL;
+
+static unsigned long allocations() {
+#if MYSQL_HEAP_STATS
+  return mysql_heap_total()->count;
+#else
+  return 0;
+#endif
+}
+
+template <typename Op>
+static void measure(const char *benchmark, const char *shape, Op op) {
+  if (filter && !strstr(benchmark, filter))
+    return;
+  typedef std::chrono::steady_clock clock;
+  unsigned long ops = 1;
+  double best = 0;
+  double allocs = 0;
+
+  // Grow the run until it is long enough to time
+  for (;;) {
+    clock::time_point start = clock::now();
+    for (unsigned long i = 0; i < ops; i++)
+      op();
+    double ns = std::chrono::duration<double, std::nano>(
+      clock::now() - start).count();
+    if (ns >= RUN_NS || ops >= (1UL << 30))
+      break;
+    if (ns < RUN_NS / 100)
+      ops *= 10;
+    else
+      ops = (unsigned long)(ops * 1.2 * RUN_NS / ns);
+  }
+  for (int run = 0; run < RUNS; run++) {
+    unsigned long before = allocations();
+    clock::time_point start = clock::now();
+    for (unsigned long i = 0; i < ops; i++)
+      op();
+    double ns = std::chrono::duration<double, std::nano>(
+      clock::now() - start).count() / ops;
+    if (run == 0 || ns < best)
+      best = ns;
+    allocs = (double)(allocations() - before) / ops;
+  }
+  results.push_back(Result{benchmark, shape, best, allocs});
+}
+
+/*
+  MySQL_Bench - Reaches the decoding functions of a cursor
+*/
+class MySQL_Bench {
+  public:
+    MySQL_Bench() : conn(&client), cur(&conn), borrowed(false) {}
+    ~MySQL_Bench() {
+      release();
+      mysql_free(conn.server_version);
+    }
+
+    void run_integers() {
+      static const struct { const char *shape; unsigned long value; } ints[] = {
+        {"1byte", 42}, {"3byte", 1000}, {"4byte", 70000},
+        {"9byte", 20000000},
+      };
+      for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        bytes p(4, 0);
+        standin_lcb(p, ints[i].value);
+        set_buffer(p);
+        measure("get_lcb_len", ints[i].shape, [&] {
+          sink += conn.get_lcb_len(4);
+        });
+        // read_lcb_int() returns an int, 8 byte values do not fit
+        if (ints[i].value < 0x1000000)
+          measure("read_lcb_int", ints[i].shape, [&] {
+            sink += conn.read_lcb_int(4);
+          });
+      }
+      for (int size = 1; size <= 4; size++) {
+        char shape[8];
+        snprintf(shape, sizeof(shape), "%dbyte", size);
+        set_buffer(bytes{0, 0, 0, 0, 0x12, 0x34, 0x56, 0x78});
+        measure("read_int", shape, [&] {
+          sink += conn.read_int(4, size);
+        });
+      }
+    }
+
+    // Decode (and free) every value of a row: one op is one row
+    void run_strings() {
+      for (const Shape &shape : row_shapes()) {
+        set_buffer(shape.row);
+        int columns = shape.columns;
+        measure("read_string", shape.name, [&] {
+          int offset = 4;
+          for (int c = 0; c < columns; c++) {
+            char *value = cur.read_string(&offset);
+            sink += value[0];
+            mysql_free(value);
+          }
+        });
+      }
+    }
+
+    // Read one column definition from the client (into the cursor's arena)
+    void run_fields() {
+      struct { const char *shape; bytes def; } defs[] = {
+        {"short", field_packet("t", "id", 3)},
+        {"long", field_packet(std::string(40, 't'), std::string(60, 'n'),
+                              253)},
+      };
+      for (size_t i = 0; i < sizeof(defs) / sizeof(defs[0]); i++) {
+        replay(defs[i].def);
+        measure("get_field", defs[i].shape, [&] {
+          field_struct *fs = cur.get_field();
+          if (fs)
+            sink += fs->type;
+          cur.free_columns_buffer();
+        });
+      }
+    }
+
+    // Frame one row packet from the client
+    void run_packets() {
+      for (const Shape &shape : row_shapes()) {
+        replay(shape.row);
+        measure("read_packet", shape.name, [&] {
+          conn.read_packet();
+          sink += conn.packet_len;
+        });
+      }
+      // A packet larger than the read buffer takes the allocating path
+      bytes big;
+      standin_text(big, std::string(MYSQL_IN_BUFFER_SIZE + 1000, 'x'));
+      replay(packet(big));
+      measure("read_packet", "large", [&] {
+        conn.read_packet();
+        sink += conn.packet_len;
+      });
+    }
+
+    void run_handshake() {
+      static const struct { const char *shape; const char *version; } hs[] = {
+        {"5.7", "5.7.44-log"}, {"8.0", "8.0.36-0ubuntu0.22.04.1"},
+      };
+      for (size_t i = 0; i < sizeof(hs) / sizeof(hs[0]); i++) {
+        set_buffer(handshake_packet(hs[i].version));
+        measure("parse_handshake_packet", hs[i].shape, [&] {
+          conn.parse_handshake_packet();
+          sink += conn.server_version[0];
+        });
+      }
+      static const struct { const char *shape; const char *password; } pw[] = {
+        {"8chars", "secret12"}, {"32chars", "correct-horse-battery-staple-32c"},
+      };
+      byte hash[20];
+      for (size_t i = 0; i < sizeof(pw) / sizeof(pw[0]); i++) {
+        measure("scramble_password", pw[i].shape, [&] {
+          conn.scramble_password((char *)pw[i].password, hash);
+          sink += hash[0];
+        });
+      }
+    }
+
+  private:
+    // Let the connection decode data directly (no client involved)
+    void set_buffer(const bytes &packet) {
+      release();
+      borrowed = true;
+      data = packet;
+      conn.buffer = data.empty() ? NULL : &data[0];
+      conn.packet_len = data.size() >= 4 ? (int)data.size() - 4 : 0;
+    }
+
+    // Let the connection read the packet from the client, over and over
+    void replay(const bytes &packet) {
+      release();
+      client.set_stream(packet);
+    }
+
+    // Give up the packet, freeing it if the connection read it
+    void release() {
+      if (borrowed)
+        conn.buffer = NULL;
+      borrowed = false;
+      conn.clear_packets();
+    }
+
+    ReplayClient client;
+    MySQL_Connection conn;
+    MySQL_Cursor cur;
+    bytes data;
+    boolean borrowed;       // buffer points into data
+};
+
+static void read_baseline(const char *name, std::vector<Result> &baseline) {
+  FILE *file = fopen(name, "r");
+  char line[256];
+
+  if (file == NULL) {
+    fprintf(stderr, "Cannot open %s.\n", name);
+    return;
+  }
+  while (fgets(line, sizeof(line), file)) {
+    char benchmark[64], shape[64];
+    double ns, allocs;
+    if (sscanf(line, "%63[^,],%63[^,],%lf,%lf", benchmark, shape, &ns,
+               &allocs) == 4)
+      baseline.push_back(Result{benchmark, shape, ns, allocs});
+  }
+  fclose(file);
+}
+
+int main(int argc, char **argv) {
+  std::vector<Result> baseline;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      read_baseline(argv[++i], baseline);
+    } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--baseline FILE] [--filter TEXT]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  mysql_log_set_output(NULL);
+
+  MySQL_Bench *bench = new MySQL_Bench();
+  bench->run_integers();
+  bench->run_strings();
+  bench->run_fields();
+  bench->run_packets();
+  bench->run_handshake();
+  delete bench;
+
+  printf("benchmark,shape,ns_per_op,allocs_per_op%s\n",
+         baseline.empty() ? "" : ",baseline_ns_per_op,change_percent");
+  for (const Result &r : results) {
+    printf("%s,%s,%.2f,%.2f", r.benchmark.c_str(), r.shape.c_str(),
+           r.ns_per_op, r.allocs_per_op);
+    for (const Result &b : baseline)
+      if (b.benchmark == r.benchmark && b.shape == r.shape) {
+        printf(",%.2f,%+.1f", b.ns_per_op,
+               (r.ns_per_op - b.ns_per_op) * 100.0 / b.ns_per_op);
+        break;
+      }
+    printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,226 @@
+/*
+  MySQL Connector/Arduino Example : pipelined read benchmark (host)
+
+  This program reads a large result set twice, once straight from the
+  client and once through a MySQL_Pipeline that reads the client in a
+  second thread, and prints how long each took:
+
+    mode,rows,seconds,rows_per_s,mb_per_s
+
+  The client is a model of a board's network interface talking to a
+  protocol stand-in in the same process, e.g. a W5500 on SPI: the
+  server's bytes arrive at --rate megabytes per second (0 = no limit)
+  while the socket buffer of the chip (--window bytes) has space, and
+  reading them costs the reading core --read nanoseconds per byte (the
+  SPI transfer). The sketch spends --work nanoseconds on each row after
+  decoding it. Read directly the time is about the transfer time plus
+  the decode time; pipelined it should approach the larger of the two.
+
+  See ../README.md to build it. Run:
+
+    ./pipeline_bench [--rows N] [--width N] [--rate MB/s] [--read ns]
+                     [--window BYTES] [--work ns] [--queue BYTES]
+*/
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+#include <MySQL_Pipeline.h>
+#include <chrono>
+#include <standin.h>
+
+typedef std::chrono::steady_clock bench_clock;
+
+/*
+  Link: the protocol stand-in (see standin.h) behind a network interface
+*/
+class Link : public Client, public StandIn_Server {
+  public:
+    Link(int rows, int width, double rate, int window, long read_ns)
+      : width(width), rate(rate), window(window), read_ns(read_ns) {
+      set_rows(rows);
+    }
+
+    int connect(IPAddress, uint16_t) {
+      sent = 0;
+      taken = 0;
+      credit = 0;
+      last = bench_clock::now();
+      start();
+      return 1;
+    }
+    int connect(const char *, uint16_t port) {
+      return connect(IPAddress(), port);
+    }
+    size_t write(uint8_t b) { return write(&b, 1); }
+    size_t write(const uint8_t *buf, size_t size) {
+      receive(buf, size);
+      return size;
+    }
+    int available() {
+      advance();
+      return sent - taken;
+    }
+    int read() {
+      uint8_t b;
+      return read(&b, 1) == 1 ? b : -1;
+    }
+    int read(uint8_t *buf, size_t size) {
+      size_t num = available();
+      if (num == 0)
+        return -1;
+      if (num > size)
+        num = size;
+      bench_clock::time_point done = bench_clock::now() +
+          std::chrono::nanoseconds(read_ns * (long)num);
+      memcpy(buf, &out[taken], num);
+      taken += num;
+      while (bench_clock::now() < done)
+        ;   // the transfer from the interface
+      return num;
+    }
+    int peek() { return available() ? out[taken] : -1; }
+    void flush() {}
+    void stop() { end(); }
+    uint8_t connected() { return is_open(); }
+    operator bool() { return is_open(); }
+    using Print::write;
+
+  protected:
+    void row(int r, bytes &p) {
+      standin_text(p, std::to_string(r + 1));
+      standin_text(p, std::string(width, 'x'));
+    }
+
+  private:
+    // Delivers what the link carried since the last call
+    void advance() {
+      bench_clock::time_point now = bench_clock::now();
+      double elapsed = std::chrono::duration<double, std::micro>(now -
+                                                                 last).count();
+      size_t space = window - (sent - taken);
+      size_t left = out.size() - sent;
+
+      last = now;
+      if (rate <= 0) {
+        sent += left < space ? left : space;
+        return;
+      }
+      credit += elapsed * rate;
+      size_t num = (size_t)credit;
+      if (num > left)
+        num = left;
+      if (num > space)
+        num = space;
+      sent += num;
+      credit -= num;
+      // Time the server waited for the window (or had nothing) is lost
+      if (credit >= 1)
+        credit = 0;
+    }
+
+    int width;
+    double rate;              // bytes per microsecond, 0 = no limit
+    int window;
+    long read_ns;             // cost of reading a byte
+    size_t sent;              // bytes of out that arrived
+    size_t taken;             // bytes of out that were read
+    double credit;            // bytes the link may still carry
+    bench_clock::time_point last;
+};
+
+struct Bench {
+  int rows;
+  int width;
+  double rate;
+  int window;
+  long read_ns;
+  long work_ns;
+  int queue;
+};
+
+/*
+  run - Read the result set once and print the line of the mode
+*/
+static bool run(Bench *bench, boolean pipelined) {
+  Link link(bench->rows, bench->width, bench->rate, bench->window,
+            bench->read_ns);
+  MySQL_Pipeline pipeline(&link);
+  Client *client = pipelined ? (Client *)&pipeline : (Client *)&link;
+  MySQL_Connection conn(client);
+  long rows = 0;
+  long bytes = 0;
+  row_values *row;
+
+  if (pipelined) {
+    pipeline.begin(bench->queue);
+    conn.set_wait(&pipeline);
+  }
+  if (!conn.connect(IPAddress(127, 0, 0, 1), 3306, (char *)"bench",
+                    (char *)"secret"))
+    return false;
+
+  MySQL_Cursor *cur = new MySQL_Cursor(&conn);
+  bench_clock::time_point started = bench_clock::now();
+  if (!cur->execute("SELECT id, name FROM bench.t")) {
+    delete cur;
+    return false;
+  }
+  cur->get_columns();
+  while ((row = cur->get_next_row()) != NULL) {
+    bench_clock::time_point done = bench_clock::now() +
+        std::chrono::nanoseconds(bench->work_ns);
+    bytes += strlen(row->values[0]) + strlen(row->values[1]) + 6;
+    rows++;
+    while (bench_clock::now() < done)
+      ;   // the sketch's work on the row
+  }
+  double seconds = std::chrono::duration<double>(bench_clock::now() -
+                                                 started).count();
+  delete cur;
+  conn.close();
+  printf("%s,%ld,%.3f,%.0f,%.2f\n", pipelined ? "pipelined" : "direct",
+         rows, seconds, rows / seconds, bytes / seconds / 1e6);
+  return rows == bench->rows;
+}
+
+int main(int argc, char **argv) {
+  Bench bench;
+
+  bench.rows = 20000;
+  bench.width = 32;
+  bench.rate = 0;
+  bench.window = 2048;
+  bench.read_ns = 500;
+  bench.work_ns = 20000;
+  bench.queue = MYSQL_PIPELINE_SIZE;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 < argc && strcmp(argv[i], "--rows") == 0) {
+      bench.rows = atoi(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "--width") == 0) {
+      bench.width = atoi(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "--rate") == 0) {
+      bench.rate = atof(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "--read") == 0) {
+      bench.read_ns = atol(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "--work") == 0) {
+      bench.work_ns = atol(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "--window") == 0) {
+      bench.window = atoi(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "--queue") == 0) {
+      bench.queue = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--rows N] [--width N] [--rate MB/s] "
+              "[--read ns] [--window BYTES] [--work ns] [--queue BYTES]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (bench.width < 1 || bench.width > 250)
+    bench.width = 250;
+  if (bench.window < 64)
+    bench.window = 64;
+  // Errors are counted, the Connected line is not needed
+  mysql_log_set_output(NULL);
+
+  printf("mode,rows,seconds,rows_per_s,mb_per_s\n");
+  return run(&bench, false) && run(&bench, true) ? 0 : 1;
+}
@@ -0,0 +1,462 @@
+/*
+  MySQL Connector/Arduino Example : heap soak test (host)
+
+  This program runs a connection for millions of cycles the way a field
+  unit does for weeks: it connects, runs INSERTs of varying length and
+  SELECTs of varying size reading every row, and now and then
+  disconnects. The allocations of the connector (packets, strings,
+  column definitions, the server version of the handshake) all go
+  through mysql_set_allocator() to a model of a small board's heap: a
+  fixed arena with a first fit free list that splits and merges blocks
+  like the malloc() of avr-libc. The server is an in-memory stand-in,
+  so no network is involved and the run is the same every time for a
+  given seed.
+
+  Every --every cycles the connection is closed and the heap is looked
+  at. Each line of the output is one such checkpoint in CSV form:
+
+    cycles,seconds,connects,queries,failed,held,held_blocks,used,peak,
+    free,largest_free,free_blocks,fragmentation
+
+  held is what the connector still holds between connections and must
+  not grow. used, peak and the free blocks are of the whole heap, which
+  the sketch shares: like the examples each query makes its cursor with
+  new, and the sketch keeps --keep blocks of its own (readings, strings)
+  for a random number of cycles. fragmentation is
+  1 - largest_free / free, 0 when the free memory is one block. At the
+  end the connection is destroyed and what the connector still holds is
+  reported as leaked, with the heap use of each call site (see
+  MySQL_Alloc.h). The program returns 1 if anything leaked.
+
+    ./soak
+    ./soak --cycles 5000000 --heap 8192 --every 100000
+    ./soak --rows 40 --width 200 --seed 7
+
+  See ../README.md to build it.
+*/
+#include <MySQL_Connection.h>
+#include <MySQL_Cursor.h>
+#include <new>
+#include <standin.h>
+
+/*
+  Model of a small heap: first fit, blocks split on allocation and
+  merged with their free neighbours when freed
+*/
+#define ALIGN         8     // block alignment
+#define HEADER        8     // size kept before each block
+#define MIN_SPLIT     16    // smallest free block split off
+
+class TinyHeap {
+  public:
+    TinyHeap(size_t size) {
+      size = size & ~(size_t)(ALIGN - 1);
+      arena = new uint8_t[size];
+      free_list = (Free *)arena;
+      free_list->size = size;
+      free_list->next = NULL;
+      used = 0;
+      used_blocks = 0;
+      peak = 0;
+      failed = 0;
+      held = 0;
+      held_blocks = 0;
+    }
+
+    ~TinyHeap() { delete [] arena; }
+
+    void *allocate(size_t size) {
+      size_t need = block_size(size);
+      Free **link = &free_list;
+
+      for (Free *f = free_list; f != NULL; link = &f->next, f = f->next) {
+        if (f->size < need)
+          continue;
+        if (f->size - need >= MIN_SPLIT) {
+          Free *rest = (Free *)((uint8_t *)f + need);
+          rest->size = f->size - need;
+          rest->next = f->next;
+          *link = rest;
+          f->size = need;
+        } else {
+          *link = f->next;
+        }
+        used += f->size;
+        used_blocks++;
+        if (used > peak)
+          peak = used;
+        return (uint8_t *)f + HEADER;
+      }
+      failed++;
+      return NULL;
+    }
+
+    void *reallocate(void *ptr, size_t size) {
+      if (ptr == NULL)
+        return allocate(size);
+      Free *b = (Free *)((uint8_t *)ptr - HEADER);
+      size_t need = block_size(size);
+      size_t have = b->size;
+
+      if (need <= have)
+        return ptr;
+      // Grow in place into a free block right after this one
+      Free **link = &free_list;
+      for (Free *f = free_list; f != NULL; link = &f->next, f = f->next) {
+        if ((uint8_t *)f != (uint8_t *)b + have)
+          continue;
+        if (have + f->size < need)
+          break;
+        *link = f->next;
+        b->size = have + f->size;
+        used += f->size;
+        if (b->size - need >= MIN_SPLIT) {
+          Free *rest = (Free *)((uint8_t *)b + need);
+          rest->size = b->size - need;
+          used -= rest->size;
+          b->size = need;
+          insert(rest);
+        }
+        if (used > peak)
+          peak = used;
+        return ptr;
+      }
+      void *moved = allocate(size);
+      if (moved == NULL)
+        return NULL;
+      memcpy(moved, ptr, have - HEADER);
+      release(ptr);
+      return moved;
+    }
+
+    void release(void *ptr) {
+      if (ptr == NULL)
+        return;
+      Free *b = (Free *)((uint8_t *)ptr - HEADER);
+      used -= b->size;
+      used_blocks--;
+      insert(b);
+    }
+
+    size_t get_used() { return used; }
+    size_t get_used_blocks() { return used_blocks; }
+    size_t get_peak() { return peak; }
+    unsigned long get_failed() { return failed; }
+    size_t get_held() { return held; }
+    size_t get_held_blocks() { return held_blocks; }
+
+    size_t get_free(size_t *largest, size_t *blocks) {
+      size_t total = 0;
+      *largest = 0;
+      *blocks = 0;
+      for (Free *f = free_list; f != NULL; f = f->next) {
+        total += f->size;
+        if (f->size > *largest)
+          *largest = f->size;
+        (*blocks)++;
+      }
+      return total;
+    }
+
+    // Connector allocator (see mysql_set_allocator()), its blocks are
+    // counted as held
+    static void *allocate(size_t size, void *heap) {
+      TinyHeap *h = (TinyHeap *)heap;
+      void *ptr = h->allocate(size);
+      if (ptr) {
+        h->held += size_of(ptr);
+        h->held_blocks++;
+      }
+      return ptr;
+    }
+    static void *reallocate(void *ptr, size_t size, void *heap) {
+      TinyHeap *h = (TinyHeap *)heap;
+      size_t old = ptr ? size_of(ptr) : 0;
+      void *moved = h->reallocate(ptr, size);
+      if (moved) {
+        h->held += size_of(moved) - old;
+        if (ptr == NULL)
+          h->held_blocks++;
+      }
+      return moved;
+    }
+    static void release(void *ptr, void *heap) {
+      TinyHeap *h = (TinyHeap *)heap;
+      if (ptr) {
+        h->held -= size_of(ptr);
+        h->held_blocks--;
+      }
+      h->release(ptr);
+    }
+
+  private:
+    struct Free {
+      size_t size;      // whole block, header included
+      Free *next;       // next free block by address
+    };
+
+    static size_t size_of(void *ptr) {
+      return ((Free *)((uint8_t *)ptr - HEADER))->size;
+    }
+
+    static size_t block_size(size_t size) {
+      size_t need = (size + HEADER + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+      return need < sizeof(Free) ? sizeof(Free) : need;
+    }
+
+    // Put a block back in address order, merging it with its neighbours
+    void insert(Free *b) {
+      Free *prev = NULL;
+      Free *next = free_list;
+
+      while (next != NULL && next < b) {
+        prev = next;
+        next = next->next;
+      }
+      b->next = next;
+      if (next != NULL && (uint8_t *)b + b->size == (uint8_t *)next) {
+        b->size += next->size;
+        b->next = next->next;
+      }
+      if (prev == NULL) {
+        free_list = b;
+      } else if ((uint8_t *)prev + prev->size == (uint8_t *)b) {
+        prev->size += b->size;
+        prev->next = b->next;
+      } else {
+        prev->next = b;
+      }
+    }
+
+    uint8_t *arena;
+    Free *free_list;
+    size_t used;
+    size_t used_blocks;
+    size_t peak;
+    unsigned long failed;
+    size_t held;          // by the connector
+    size_t held_blocks;
+};
+
+/*
+  The stand-in (see standin.h) returning a result set of the size asked
+  for with set_result(): names of 1 to max_width characters
+*/
+class SoakStandIn : public StandIn {
+  public:
+    SoakStandIn() : StandIn("8.0.0-soak"), width(1) {}
+
+    void set_result(int num_rows, int max_width) {
+      set_rows(num_rows);
+      width = max_width;
+    }
+
+  protected:
+    void row(int r, bytes &p) {
+      standin_text(p, std::to_string(r + 1));
+      standin_text(p, std::string(1 + (r * 7919) % width, 'a' + r % 26));
+    }
+
+  private:
+    int width;
+};
+
+/*
+  The soak: connect, INSERT and SELECT cycles with checkpoints. Like the
+  examples, each query uses a cursor made with new, and the sketch keeps
+  a few blocks of its own (readings, strings) for a random number of
+  cycles, both in the same heap as the connector.
+*/
+#define MAX_KEPT      16
+
+struct Soak {
+  TinyHeap *heap;
+  unsigned long cycles;
+  unsigned long every;
+  int max_rows;
+  int max_width;
+  int keep;
+  uint32_t seed;
+  void *kept[MAX_KEPT];
+  unsigned long connects;
+  unsigned long queries;
+  unsigned long failed;
+};
+
+static uint32_t next_random(uint32_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+static MySQL_Cursor *new_cursor(Soak *soak, MySQL_Connection *conn) {
+  void *mem = soak->heap->allocate(sizeof(MySQL_Cursor));
+  return mem ? new (mem) MySQL_Cursor(conn) : NULL;
+}
+
+static void delete_cursor(Soak *soak, MySQL_Cursor *cur) {
+  cur->~MySQL_Cursor();
+  soak->heap->release(cur);
+}
+
+static bool run_select(Soak *soak, MySQL_Connection *conn) {
+  MySQL_Cursor *cur = new_cursor(soak, conn);
+  bool ok = false;
+
+  if (cur == NULL)
+    return false;
+  if (cur->execute("SELECT id, name FROM soak.t") &&
+      cur->get_columns() != NULL) {
+    while (cur->get_next_row() != NULL)
+      ;
+    ok = conn->get_error_code() == 0;
+  }
+  delete_cursor(soak, cur);
+  return ok;
+}
+
+static bool run_insert(Soak *soak, MySQL_Connection *conn, int len) {
+  char query[300];
+  int n = snprintf(query, sizeof(query),
+                   "INSERT INTO soak.t (name) VALUES ('");
+  memset(query + n, 'x', len);
+  strcpy(query + n + len, "')");
+
+  MySQL_Cursor *cur = new_cursor(soak, conn);
+  if (cur == NULL)
+    return false;
+  bool ok = cur->execute(query);
+  delete_cursor(soak, cur);
+  return ok;
+}
+
+// Replace one of the sketch's own blocks now and then
+static void sketch(Soak *soak) {
+  uint32_t r = next_random(&soak->seed);
+
+  if (soak->keep == 0 || r % 4 != 0)
+    return;
+  int slot = (r >> 8) % soak->keep;
+  soak->heap->release(soak->kept[slot]);
+  soak->kept[slot] = soak->heap->allocate(8 + (r >> 16) % 120);
+}
+
+static void cycle(Soak *soak, SoakStandIn *server, MySQL_Connection *conn) {
+  uint32_t r = next_random(&soak->seed);
+
+  sketch(soak);
+  if (!conn->connected()) {
+    soak->connects++;
+    if (!conn->connect(IPAddress(127, 0, 0, 1), 3306, (char *)"soak",
+                       (char *)"secret")) {
+      soak->failed++;
+      conn->close();
+      return;
+    }
+  }
+  for (int i = r % 4; i > 0; i--) {
+    soak->queries++;
+    if (!run_insert(soak, conn, 1 + next_random(&soak->seed) % 250))
+      soak->failed++;
+    sketch(soak);
+  }
+  server->set_result(next_random(&soak->seed) % (soak->max_rows + 1),
+                     1 + next_random(&soak->seed) % soak->max_width);
+  soak->queries++;
+  if (!run_select(soak, conn))
+    soak->failed++;
+  // Reconnect about every 8 cycles
+  if ((r >> 8) % 8 == 0)
+    conn->close();
+}
+
+static void checkpoint(Soak *soak, unsigned long done, unsigned long started) {
+  TinyHeap *heap = soak->heap;
+  size_t largest, blocks;
+  size_t free = heap->get_free(&largest, &blocks);
+
+  printf("%lu,%.3f,%lu,%lu,%lu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%.4f\n", done,
+         (micros() - started) / 1e6, soak->connects, soak->queries,
+         soak->failed, heap->get_held(), heap->get_held_blocks(),
+         heap->get_used(), heap->get_peak(), free, largest, blocks,
+         free ? 1.0 - (double)largest / free : 0.0);
+  fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+  Soak soak;
+  size_t heap_size = 8192;
+
+  memset(&soak, 0, sizeof(soak));
+  soak.cycles = 1000000;
+  soak.every = 0;
+  soak.max_rows = 20;
+  soak.max_width = 64;
+  soak.keep = 4;
+  soak.seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 < argc && strcmp(argv[i], "--cycles") == 0) {
+      soak.cycles = strtoul(argv[++i], NULL, 10);
+    } else if (i + 1 < argc && strcmp(argv[i], "--heap") == 0) {
+      heap_size = strtoul(argv[++i], NULL, 10);
+    } else if (i + 1 < argc && strcmp(argv[i], "--every") == 0) {
+      soak.every = strtoul(argv[++i], NULL, 10);
+    } else if (i + 1 < argc && strcmp(argv[i], "--rows") == 0) {
+      soak.max_rows = atoi(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "--width") == 0) {
+      soak.max_width = atoi(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "--keep") == 0) {
+      soak.keep = atoi(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "--seed") == 0) {
+      soak.seed = strtoul(argv[++i], NULL, 10);
+    } else {
+      fprintf(stderr, "usage: %s [--cycles N] [--heap BYTES] [--every N] "
+              "[--rows N] [--width N] [--keep N] [--seed N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (soak.every == 0)
+    soak.every = soak.cycles >= 100 ? soak.cycles / 100 : 1;
+  if (soak.max_width < 1 || soak.max_width > 250)
+    soak.max_width = 250;
+  if (soak.max_rows < 0)
+    soak.max_rows = 0;
+  if (soak.keep < 0 || soak.keep > MAX_KEPT)
+    soak.keep = MAX_KEPT;
+  if (soak.seed == 0)
+    soak.seed = 1;
+  // Out of memory errors are counted, not printed
+  mysql_log_set_output(NULL);
+
+  TinyHeap heap(heap_size);
+  mysql_allocator allocator = {
+    TinyHeap::allocate, TinyHeap::reallocate, TinyHeap::release, &heap
+  };
+  mysql_set_allocator(&allocator);
+  soak.heap = &heap;
+
+  SoakStandIn server;
+  MySQL_Connection *conn = new MySQL_Connection(&server);
+  unsigned long started = micros();
+
+  printf("cycles,seconds,connects,queries,failed,held,held_blocks,used,peak,"
+         "free,largest_free,free_blocks,fragmentation\n");
+  for (unsigned long done = 1; done <= soak.cycles; done++) {
+    cycle(&soak, &server, conn);
+    if (done % soak.every == 0 || done == soak.cycles) {
+      conn->close();
+      checkpoint(&soak, done, started);
+    }
+  }
+  delete conn;
+  for (int i = 0; i < soak.keep; i++)
+    heap.release(soak.kept[i]);
+
+  printf("\nleaked %zu bytes in %zu blocks, %lu allocations failed\n",
+         heap.get_held(), heap.get_held_blocks(), heap.get_failed());
+#if MYSQL_HEAP_STATS
+  mysql_heap_print(&Serial);
+#endif
+  return heap.get_held() != 0 ? 1 : 0;
+}
@@ -0,0 +1,397 @@
+/*
+  MySQL Connector/Arduino Example : TLS resumption benchmark (host)
+
+  This program times connects with a full TLS handshake against connects
+  that resume the saved session (MySQL_TLS_Cache), and prints one line
+  for each:
+
+    mode,connects,ms_per_connect,resumed
+
+  The server is the protocol stand-in (see standin.h) in the same
+  process with TLS added. Like a MySQL server it offers a self-signed
+  RSA 2048 certificate, which the client verifies. Both ends use
+  OpenSSL through memory buffers, and the client side is a MySQL_TLS
+  backend like MySQL_TLS_Mbedtls on a board, so the numbers show the
+  cost of the handshake without a network. A board takes far longer for
+  each, but the ratio of full to resumed is what matters.
+
+  See ../README.md to build it. Run:
+
+    ./tls_bench [--connects N] [--tls13]
+
+  TLS 1.2 is used by default, as mbed TLS on the ESP32 core 2 does;
+  --tls13 allows TLS 1.3, where sessions are resumed with tickets.
+*/
+#include <MySQL_Connection.h>
+#include <MySQL_TLS.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <chrono>
+#include <standin.h>
+
+typedef std::chrono::steady_clock bench_clock;
+
+#define SERVER_NAME  "standin"
+
+// Move what OpenSSL wrote to a memory buffer into bytes
+static void drain(BIO *bio, bytes &to) {
+  uint8_t chunk[4096];
+  int num;
+
+  while ((num = BIO_read(bio, chunk, sizeof(chunk))) > 0)
+    to.insert(to.end(), chunk, chunk + num);
+}
+
+/*
+  TLS_StandIn: the stand-in as a Client, speaking TLS after the SSL
+  request
+*/
+class TLS_StandIn : public Client, public StandIn_Server {
+  public:
+    TLS_StandIn(SSL_CTX *context)
+      : StandIn_Server("8.0.0-tls"), ctx(context), ssl(NULL), pos(0) {
+      set_caps(STANDIN_CAPS | STANDIN_SSL);
+    }
+    ~TLS_StandIn() { end_tls(); }
+
+    int connect(IPAddress, uint16_t) {
+      end_tls();
+      wire.clear();
+      pos = 0;
+      start();
+      wire.swap(out);
+      return 1;
+    }
+    int connect(const char *, uint16_t port) {
+      return connect(IPAddress(), port);
+    }
+    size_t write(uint8_t b) { return write(&b, 1); }
+    size_t write(const uint8_t *buf, size_t size) {
+      uint8_t chunk[4096];
+      int num;
+
+      if (ssl == NULL) {
+        receive(buf, size);
+        wire.insert(wire.end(), out.begin(), out.end());
+        out.clear();
+        return size;
+      }
+      // Records in, the handshake or the requests decrypted, replies out
+      BIO_write(SSL_get_rbio(ssl), buf, size);
+      while ((num = SSL_read(ssl, chunk, sizeof(chunk))) > 0)
+        receive(chunk, num);
+      if (!out.empty()) {
+        SSL_write(ssl, out.data(), out.size());
+        out.clear();
+      }
+      drain(SSL_get_wbio(ssl), wire);
+      return size;
+    }
+    int available() { return (int)(wire.size() - pos); }
+    int read() {
+      uint8_t b;
+      return read(&b, 1) == 1 ? b : -1;
+    }
+    int read(uint8_t *buf, size_t size) {
+      size_t n = std::min(size, wire.size() - pos);
+      memcpy(buf, wire.data() + pos, n);
+      pos += n;
+      if (pos == wire.size()) {
+        wire.clear();
+        pos = 0;
+      }
+      return (int)n;
+    }
+    int peek() { return pos < wire.size() ? wire[pos] : -1; }
+    void flush() {}
+    void stop() { end(); }
+    uint8_t connected() { return is_open(); }
+    operator bool() { return is_open(); }
+    using Print::write;
+
+  protected:
+    void start_tls() {
+      ssl = SSL_new(ctx);
+      SSL_set_bio(ssl, BIO_new(BIO_s_mem()), BIO_new(BIO_s_mem()));
+      SSL_set_accept_state(ssl);
+    }
+
+  private:
+    void end_tls() {
+      SSL_free(ssl);
+      ssl = NULL;
+    }
+
+    SSL_CTX *ctx;
+    SSL *ssl;                 // TLS session, NULL before the SSL request
+    bytes wire;               // bytes for the client
+    size_t pos;               // bytes of wire read
+};
+
+/*
+  OpenSSL_TLS: a MySQL_TLS backend running OpenSSL over a Client
+*/
+class OpenSSL_TLS : public MySQL_TLS, public Client {
+  public:
+    OpenSSL_TLS(SSL_CTX *context)
+      : ctx(context), ssl(NULL), transport(NULL), pos(0) {}
+    ~OpenSSL_TLS() { SSL_free(ssl); }
+
+    Client *handshake(Client *transport_client, const char *host,
+                      const byte *session, int session_len) {
+      SSL_free(ssl);
+      plain.clear();
+      pos = 0;
+      transport = transport_client;
+      ssl = SSL_new(ctx);
+      SSL_set_bio(ssl, BIO_new(BIO_s_mem()), BIO_new(BIO_s_mem()));
+      SSL_set_connect_state(ssl);
+      if (host) {
+        SSL_set_tlsext_host_name(ssl, host);
+        SSL_set1_host(ssl, host);
+      }
+      if (session) {
+        const unsigned char *data = session;
+        SSL_SESSION *saved = d2i_SSL_SESSION(NULL, &data, session_len);
+        if (saved) {
+          SSL_set_session(ssl, saved);
+          SSL_SESSION_free(saved);
+        }
+      }
+      for (;;) {
+        int ret = SSL_do_handshake(ssl);
+        send_records();
+        if (ret == 1)
+          return this;
+        if (SSL_get_error(ssl, ret) != SSL_ERROR_WANT_READ ||
+            !receive_records())
+          return NULL;
+      }
+    }
+
+    byte *save_session(int *len) {
+      SSL_SESSION *current;
+      byte *session = NULL;
+      unsigned char *data;
+      int size;
+
+      *len = 0;
+      pull();     // TLS 1.3 tickets come after the handshake
+      current = ssl ? SSL_get1_session(ssl) : NULL;
+      if (current == NULL)
+        return NULL;
+      size = SSL_SESSION_is_resumable(current) ?
+             i2d_SSL_SESSION(current, NULL) : 0;
+      if (size > 0)
+        session = (byte *)mysql_malloc(size, MYSQL_ALLOC_TLS_SESSION);
+      if (session) {
+        data = session;
+        i2d_SSL_SESSION(current, &data);
+        *len = size;
+      }
+      SSL_SESSION_free(current);
+      return session;
+    }
+
+    boolean resumed() { return ssl && SSL_session_reused(ssl); }
+
+    int connect(IPAddress, uint16_t) { return 0; }
+    int connect(const char *, uint16_t) { return 0; }
+    size_t write(uint8_t b) { return write(&b, 1); }
+    size_t write(const uint8_t *buf, size_t size) {
+      if (SSL_write(ssl, buf, size) <= 0)
+        return 0;
+      send_records();
+      return size;
+    }
+    int available() {
+      pull();
+      return (int)(plain.size() - pos);
+    }
+    int read() {
+      uint8_t b;
+      return read(&b, 1) == 1 ? b : -1;
+    }
+    int read(uint8_t *buf, size_t size) {
+      size_t n = std::min(size, (size_t)available());
+      if (n == 0)
+        return -1;
+      memcpy(buf, plain.data() + pos, n);
+      pos += n;
+      return (int)n;
+    }
+    int peek() { return available() ? plain[pos] : -1; }
+    void flush() { transport->flush(); }
+    void stop() {
+      if (ssl) {
+        SSL_shutdown(ssl);
+        send_records();
+      }
+      transport->stop();
+    }
+    uint8_t connected() { return transport->connected() || available(); }
+    operator bool() { return connected(); }
+    using Print::write;
+
+  private:
+    void send_records() {
+      bytes records;
+      drain(SSL_get_wbio(ssl), records);
+      if (!records.empty())
+        transport->write(records.data(), records.size());
+    }
+
+    // False if the server sent nothing
+    boolean receive_records() {
+      uint8_t chunk[4096];
+      int num = 0;
+
+      while (transport->available() > 0) {
+        num = transport->read(chunk, sizeof(chunk));
+        if (num <= 0)
+          break;
+        BIO_write(SSL_get_rbio(ssl), chunk, num);
+      }
+      return num > 0;
+    }
+
+    // Decrypt what arrived
+    void pull() {
+      uint8_t chunk[4096];
+      int num;
+
+      if (ssl == NULL)
+        return;
+      if (pos == plain.size()) {
+        plain.clear();
+        pos = 0;
+      }
+      receive_records();
+      while ((num = SSL_read(ssl, chunk, sizeof(chunk))) > 0)
+        plain.insert(plain.end(), chunk, chunk + num);
+    }
+
+    SSL_CTX *ctx;
+    SSL *ssl;
+    Client *transport;        // client the TLS runs over
+    bytes plain;              // decrypted bytes
+    size_t pos;               // bytes of plain read
+};
+
+/*
+  make_certificate - A self-signed RSA 2048 certificate for the server
+
+  MySQL creates one like it at startup.
+*/
+static X509 *make_certificate(EVP_PKEY **key) {
+  X509 *cert = X509_new();
+  X509_NAME *name;
+
+  *key = EVP_RSA_gen(2048);
+  X509_set_version(cert, 2);
+  ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+  X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+  X509_gmtime_adj(X509_getm_notAfter(cert), 86400L);
+  X509_set_pubkey(cert, *key);
+  name = X509_get_subject_name(cert);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                             (const unsigned char *)SERVER_NAME, -1, -1, 0);
+  X509_set_issuer_name(cert, name);
+  X509_sign(cert, *key, EVP_sha256());
+  return cert;
+}
+
+struct Bench {
+  int connects;
+  boolean tls13;
+};
+
+/*
+  run - Connect and close the given number of times and print the line
+        of the mode
+*/
+static boolean run(Bench *bench, boolean resume, SSL_CTX *server_ctx,
+                   SSL_CTX *client_ctx) {
+  TLS_StandIn server(server_ctx);
+  OpenSSL_TLS tls(client_ctx);
+  MySQL_TLS_Cache sessions;
+  MySQL_Connection conn(&server);
+  IPAddress addr(127, 0, 0, 1);
+  double seconds = 0;
+  int resumed = 0;
+
+  conn.set_tls(&tls, &sessions, SERVER_NAME);
+  // The first connect saves the session the others resume
+  if (resume) {
+    if (!conn.connect(addr, 3306, (char *)"bench", (char *)"secret"))
+      return false;
+    conn.close();
+  }
+  for (int i = 0; i < bench->connects; i++) {
+    if (!resume)
+      sessions.clear();
+    bench_clock::time_point started = bench_clock::now();
+    if (!conn.connect(addr, 3306, (char *)"bench", (char *)"secret"))
+      return false;
+    seconds += std::chrono::duration<double>(bench_clock::now() -
+                                             started).count();
+    if (conn.tls_resumed())
+      resumed++;
+    conn.close();
+  }
+  printf("%s,%d,%.3f,%d\n", resume ? "resumed" : "full", bench->connects,
+         seconds * 1000 / bench->connects, resumed);
+  return resume ? resumed == bench->connects : resumed == 0;
+}
+
+int main(int argc, char **argv) {
+  Bench bench;
+  EVP_PKEY *key;
+  X509 *cert;
+  SSL_CTX *server_ctx;
+  SSL_CTX *client_ctx;
+  boolean ok;
+
+  bench.connects = 100;
+  bench.tls13 = false;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 < argc && strcmp(argv[i], "--connects") == 0) {
+      bench.connects = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--tls13") == 0) {
+      bench.tls13 = true;
+    } else {
+      fprintf(stderr, "usage: %s [--connects N] [--tls13]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (bench.connects < 1)
+    bench.connects = 1;
+  // The Connected lines are not needed
+  mysql_log_set_output(NULL);
+
+  cert = make_certificate(&key);
+  server_ctx = SSL_CTX_new(TLS_server_method());
+  SSL_CTX_use_certificate(server_ctx, cert);
+  SSL_CTX_use_PrivateKey(server_ctx, key);
+  SSL_CTX_set_session_id_context(server_ctx,
+                                 (const unsigned char *)SERVER_NAME,
+                                 strlen(SERVER_NAME));
+  client_ctx = SSL_CTX_new(TLS_client_method());
+  X509_STORE_add_cert(SSL_CTX_get_cert_store(client_ctx), cert);
+  SSL_CTX_set_verify(client_ctx, SSL_VERIFY_PEER, NULL);
+  if (!bench.tls13)
+    SSL_CTX_set_max_proto_version(client_ctx, TLS1_2_VERSION);
+
+  printf("mode,connects,ms_per_connect,resumed\n");
+  ok = run(&bench, false, server_ctx, client_ctx) &&
+       run(&bench, true, server_ctx, client_ctx);
+  if (!ok)
+    ERR_print_errors_fp(stderr);
+
+  SSL_CTX_free(client_ctx);
+  SSL_CTX_free(server_ctx);
+  X509_free(cert);
+  EVP_PKEY_free(key);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,297 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Alloc.cpp - Heap allocations of the connector and their accounting
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#include <MySQL_Alloc.h>
+#include <MySQL_Log.h>
+
+static const mysql_allocator *user_allocator = NULL;
+
+static void *allocate(size_t size) {
+  if (user_allocator)
+    return user_allocator->allocate(size, user_allocator->context);
+  return malloc(size);
+}
+
+static void *reallocate(void *ptr, size_t size) {
+  if (user_allocator)
+    return user_allocator->reallocate(ptr, size, user_allocator->context);
+  return realloc(ptr, size);
+}
+
+static void release(void *ptr) {
+  if (user_allocator)
+    user_allocator->release(ptr, user_allocator->context);
+  else
+    free(ptr);
+}
+
+#if MYSQL_HEAP_STATS
+
+// Kept before each block; the union keeps the block aligned for any type
+typedef union {
+  struct {
+    size_t size;
+    byte site;
+  } block;
+  double align_double;
+  long long align_long;
+  void *align_pointer;
+} block_header;
+
+const char SITE_NAMES[MYSQL_ALLOC_SITES][12] PROGMEM = {
+  "read_packet", "skip_packet", "handshake", "command", "query", "infile",
+  "get_fields", "read_string", "capture", "source", "cache_query",
+  "fetch_all", "pipeline", "tls_session", "pool"
+};
+const char HEAP_TITLE[] PROGMEM =
+  "site        current peak count largest failed";
+const char HEAP_TOTAL[] PROGMEM = "total      ";
+
+static mysql_heap_stats sites[MYSQL_ALLOC_SITES];
+static mysql_heap_stats total;
+
+/*
+  The counters are shared by the tasks of a MySQL_Pool, so they are
+  updated atomically on targets that have atomics.
+*/
+#if defined(__AVR__)
+static unsigned long add_stat(unsigned long *stat, long delta) {
+  *stat += delta;
+  return *stat;
+}
+
+static void raise_stat(unsigned long *stat, unsigned long value) {
+  if (value > *stat)
+    *stat = value;
+}
+#else
+static unsigned long add_stat(unsigned long *stat, long delta) {
+  return __atomic_add_fetch(stat, delta, __ATOMIC_RELAXED);
+}
+
+static void raise_stat(unsigned long *stat, unsigned long value) {
+  unsigned long seen = __atomic_load_n(stat, __ATOMIC_RELAXED);
+  while (value > seen &&
+         !__atomic_compare_exchange_n(stat, &seen, value, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+}
+#endif
+
+static void count_block(mysql_heap_stats *stats, size_t size) {
+  raise_stat(&stats->peak, add_stat(&stats->current, size));
+  add_stat(&stats->count, 1);
+  raise_stat(&stats->largest, size);
+}
+
+static void count_block_free(mysql_heap_stats *stats, size_t size) {
+  add_stat(&stats->current, -(long)size);
+}
+
+static void *track(block_header *header, size_t size, byte site) {
+  if (site >= MYSQL_ALLOC_SITES)
+    site = 0;
+  header->block.size = size;
+  header->block.site = site;
+  count_block(&sites[site], size);
+  count_block(&total, size);
+  return header + 1;
+}
+
+static void count_failure(byte site) {
+  if (site >= MYSQL_ALLOC_SITES)
+    site = 0;
+  add_stat(&sites[site].failed, 1);
+  add_stat(&total.failed, 1);
+}
+
+static block_header *untrack(void *ptr) {
+  block_header *header = (block_header *)ptr - 1;
+
+  count_block_free(&sites[header->block.site], header->block.size);
+  count_block_free(&total, header->block.size);
+  return header;
+}
+#endif  // MYSQL_HEAP_STATS
+
+
+/*
+  mysql_malloc - Allocate memory for the connector
+
+  size[in]        bytes needed
+  site[in]        call site (MYSQL_ALLOC_*)
+
+  Returns void * - the block or NULL
+*/
+void *mysql_malloc(size_t size, byte site) {
+#if MYSQL_HEAP_STATS
+  block_header *header = (block_header *)allocate(sizeof(block_header) + size);
+
+  if (header == NULL) {
+    count_failure(site);
+    return NULL;
+  }
+  return track(header, size, site);
+#else
+  (void)site;
+  return allocate(size);
+#endif
+}
+
+
+/*
+  mysql_realloc - Change the size of a block
+
+  On failure the block is left as it was.
+
+  ptr[in]         block from mysql_malloc() or NULL
+  size[in]        bytes needed
+  site[in]        call site (MYSQL_ALLOC_*)
+
+  Returns void * - the block or NULL
+*/
+void *mysql_realloc(void *ptr, size_t size, byte site) {
+#if MYSQL_HEAP_STATS
+  block_header *header;
+  size_t old_size;
+  byte old_site;
+
+  if (ptr == NULL)
+    return mysql_malloc(size, site);
+  header = (block_header *)ptr - 1;
+  old_size = header->block.size;
+  old_site = header->block.site;
+  header = (block_header *)reallocate(header, sizeof(block_header) + size);
+  if (header == NULL) {
+    count_failure(site);
+    return NULL;
+  }
+  count_block_free(&sites[old_site], old_size);
+  count_block_free(&total, old_size);
+  return track(header, size, site);
+#else
+  (void)site;
+  return reallocate(ptr, size);
+#endif
+}
+
+
+/*
+  mysql_free - Free a block from mysql_malloc() or mysql_realloc()
+
+  ptr[in]         block or NULL
+*/
+void mysql_free(void *ptr) {
+  if (ptr == NULL)
+    return;
+#if MYSQL_HEAP_STATS
+  release(untrack(ptr));
+#else
+  release(ptr);
+#endif
+}
+
+
+/*
+  mysql_set_allocator - Use other functions than malloc()/free()
+
+  allocator[in]   functions to use (kept, not copied), NULL = malloc()
+*/
+void mysql_set_allocator(const mysql_allocator *allocator) {
+  user_allocator = allocator;
+}
+
+
+#if MYSQL_HEAP_STATS
+/*
+  mysql_heap_total - Get the heap use of all call sites
+
+  Returns const mysql_heap_stats * - the totals
+*/
+const mysql_heap_stats *mysql_heap_total() {
+  return &total;
+}
+
+
+/*
+  mysql_heap_site - Get the heap use of a call site
+
+  site[in]        call site (MYSQL_ALLOC_*)
+
+  Returns const mysql_heap_stats * - the counters or NULL
+*/
+const mysql_heap_stats *mysql_heap_site(int site) {
+  if (site < 0 || site >= MYSQL_ALLOC_SITES)
+    return NULL;
+  return &sites[site];
+}
+
+
+/*
+  mysql_heap_reset_peaks - Start measuring peaks and largest blocks again
+*/
+void mysql_heap_reset_peaks() {
+  for (int i = 0; i < MYSQL_ALLOC_SITES; i++) {
+    sites[i].peak = sites[i].current;
+    sites[i].largest = 0;
+  }
+  total.peak = total.current;
+  total.largest = 0;
+}
+
+
+static void print_stats(Print *out, const mysql_heap_stats *stats) {
+  out->print(' ');
+  out->print(stats->current);
+  out->print(' ');
+  out->print(stats->peak);
+  out->print(' ');
+  out->print(stats->count);
+  out->print(' ');
+  out->print(stats->largest);
+  out->print(' ');
+  out->println(stats->failed);
+}
+
+
+/*
+  mysql_heap_print - Print the heap use per call site
+
+  Sites that never allocated are left out.
+
+  out[in]         where to print (e.g. &Serial)
+*/
+void mysql_heap_print(Print *out) {
+  mysql_print_P(out, HEAP_TITLE);
+  out->println();
+  for (int i = 0; i < MYSQL_ALLOC_SITES; i++) {
+    if (sites[i].count == 0 && sites[i].failed == 0)
+      continue;
+    mysql_print_P(out, SITE_NAMES[i]);
+    for (int pad = strlen_P(SITE_NAMES[i]); pad < 11; pad++)
+      out->print(' ');
+    print_stats(out, &sites[i]);
+  }
+  mysql_print_P(out, HEAP_TOTAL);
+  print_stats(out, &total);
+}
+#endif  // MYSQL_HEAP_STATS
@@ -0,0 +1,98 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Alloc.h - Heap allocations of the connector and their accounting
+
+  This header file defines the allocator the connector uses for packets,
+  strings, column definitions and cached results. Every allocation names
+  its call site so the heap the connector holds can be broken down:
+  bytes held now, the peak, the number of allocations and the largest
+  block per site. mysql_heap_print() writes the table to a Print.
+
+  The accounting keeps the size of each block in a small header before
+  it. It is on by default except on AVR boards, where set MYSQL_HEAP_STATS
+  to 1 (e.g. with -DMYSQL_HEAP_STATS=1) to use it.
+
+  mysql_set_allocator() replaces malloc()/free() with your own functions,
+  e.g. a pool or external RAM (PSRAM on the ESP32). Set it before the
+  first connection since blocks must be freed by the allocator that made
+  them.
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_ALLOC_H
+#define MYSQL_ALLOC_H
+
+#include <Arduino.h>
+
+#ifndef MYSQL_HEAP_STATS
+  #if defined(__AVR__)
+    #define MYSQL_HEAP_STATS 0
+  #else
+    #define MYSQL_HEAP_STATS 1
+  #endif
+#endif
+
+// Call sites of the allocations
+#define MYSQL_ALLOC_READ_PACKET   0   // read_packet()
+#define MYSQL_ALLOC_SKIP_PACKET   1   // skip_packet() (end of a result)
+#define MYSQL_ALLOC_HANDSHAKE     2   // server version, scramble
+#define MYSQL_ALLOC_COMMAND       3   // authentication and change_user
+#define MYSQL_ALLOC_QUERY         4   // execute() query packet
+#define MYSQL_ALLOC_INFILE        5   // LOAD DATA LOCAL INFILE chunks
+#define MYSQL_ALLOC_GET_FIELDS    6   // column definitions (metadata arena)
+#define MYSQL_ALLOC_READ_STRING   7   // read_string() names and values
+#define MYSQL_ALLOC_CAPTURE       8   // results captured for the cache
+#define MYSQL_ALLOC_SOURCE        9   // results read from the cache
+#define MYSQL_ALLOC_CACHE_QUERY   10  // query text kept by the cache
+#define MYSQL_ALLOC_FETCH_ALL     11  // column arrays of fetch_all()
+#define MYSQL_ALLOC_PIPELINE      12  // read queue of MySQL_Pipeline
+#define MYSQL_ALLOC_TLS_SESSION   13  // TLS sessions kept to resume
+#define MYSQL_ALLOC_POOL          14  // connections of MySQL_Pool
+#define MYSQL_ALLOC_SITES         15
+
+// Structure for the heap use of a call site (or all of them).
+typedef struct {
+  unsigned long current;    // bytes held now
+  unsigned long peak;       // most bytes held at once
+  unsigned long count;      // allocations made
+  unsigned long largest;    // largest block allocated
+  unsigned long failed;     // allocations that failed
+} mysql_heap_stats;
+
+// Structure for a user allocator (see mysql_set_allocator()).
+typedef struct {
+  void *(*allocate)(size_t size, void *context);
+  void *(*reallocate)(void *ptr, size_t size, void *context);
+  void (*release)(void *ptr, void *context);
+  void *context;            // passed to the functions
+} mysql_allocator;
+
+void *mysql_malloc(size_t size, byte site);
+void *mysql_realloc(void *ptr, size_t size, byte site);
+void mysql_free(void *ptr);
+void mysql_set_allocator(const mysql_allocator *allocator);
+
+#if MYSQL_HEAP_STATS
+const mysql_heap_stats *mysql_heap_total();
+const mysql_heap_stats *mysql_heap_site(int site);
+void mysql_heap_reset_peaks();
+void mysql_heap_print(Print *out);
+#endif
+
+#endif
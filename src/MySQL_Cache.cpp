@@ -0,0 +1,219 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Cache.cpp - Client side cache for small SELECT results
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#include <MySQL_Cache.h>
+#include <MySQL_Alloc.h>
+
+/*
+  Constructor
+
+  byte_budget[in]     maximum bytes held by the cache
+  default_ttl_ms[in]  time to live of entries stored without one
+*/
+MySQL_Cache::MySQL_Cache(unsigned long byte_budget,
+                         unsigned long default_ttl_ms) {
+  budget = byte_budget;
+  default_ttl = default_ttl_ms;
+  bytes_used = 0;
+  hits = 0;
+  misses = 0;
+  for (int i = 0; i < MYSQL_CACHE_ENTRIES; i++) {
+    entries[i].query = NULL;
+    entries[i].data = NULL;
+  }
+}
+
+
+/*
+  Destructor
+*/
+MySQL_Cache::~MySQL_Cache() {
+  invalidate();
+}
+
+
+/*
+  lookup - Find a fresh result for a query
+
+  query[in]       query text
+  len[out]        number of bytes in the result
+  session[in]     session state asking (MySQL_Packet::get_session())
+
+  Returns byte * - packets of the result or NULL on a miss. The data is
+                   owned by the cache and valid until the next store().
+*/
+const byte *MySQL_Cache::lookup(const char *query, int *len,
+                                unsigned long session) {
+  cache_entry *entry = find(query, hash(query), session);
+  unsigned long now = millis();
+
+  if (entry && now - entry->stored >= entry->ttl) {
+    evict(entry);
+    entry = NULL;
+  }
+  if (entry == NULL) {
+    misses++;
+    return NULL;
+  }
+  hits++;
+  entry->last_used = now;
+  *len = entry->len;
+  return entry->data;
+}
+
+
+/*
+  store - Save the result of a query
+
+  The cache takes ownership of the query copy and the data (both must be
+  allocated with mysql_malloc()) and frees them if the result does not fit.
+
+  query[in]       copy of the query text
+  data[in]        packets of the result
+  len[in]         number of bytes in data
+  ttl_ms[in]      time to live, 0 = default
+  session[in]     session state that read the result
+
+  Returns boolean - True if the result was cached
+*/
+boolean MySQL_Cache::store(char *query, byte *data, int len,
+                           unsigned long ttl_ms, unsigned long session) {
+  unsigned long key = hash(query);
+  unsigned long size = strlen(query) + 1 + len;
+  cache_entry *entry;
+
+  // Replace an older copy of the same query
+  entry = find(query, key, session);
+  if (entry)
+    evict(entry);
+
+  if (size > budget) {
+    mysql_free(query);
+    mysql_free(data);
+    return false;
+  }
+
+  // Make room: expired entries first, then the least recently used
+  for (int i = 0; i < MYSQL_CACHE_ENTRIES; i++) {
+    if (entries[i].query && millis() - entries[i].stored >= entries[i].ttl)
+      evict(&entries[i]);
+  }
+  for (;;) {
+    cache_entry *lru = NULL;
+    entry = NULL;
+    for (int i = 0; i < MYSQL_CACHE_ENTRIES; i++) {
+      if (entries[i].query == NULL) {
+        if (entry == NULL)
+          entry = &entries[i];
+      } else if (lru == NULL || entries[i].last_used - lru->last_used >
+                 0x7fffffffUL) {
+        lru = &entries[i];
+      }
+    }
+    if (entry && bytes_used + size <= budget)
+      break;
+    evict(lru);
+  }
+
+  entry->hash = key;
+  entry->session = session;
+  entry->query = query;
+  entry->data = data;
+  entry->len = len;
+  entry->stored = millis();
+  entry->last_used = entry->stored;
+  entry->ttl = ttl_ms ? ttl_ms : default_ttl;
+  bytes_used += size;
+  return true;
+}
+
+
+/*
+  invalidate - Drop cached results
+
+  Use this after changing the rows a cached query reads, for example
+  invalidate("SELECT * FROM config") after an UPDATE of that table.
+
+  prefix[in]      drop entries whose query starts with prefix,
+                  NULL drops all entries
+
+  Returns integer - number of entries dropped
+*/
+int MySQL_Cache::invalidate(const char *prefix) {
+  int num = 0;
+  int prefix_len = prefix ? strlen(prefix) : 0;
+
+  for (int i = 0; i < MYSQL_CACHE_ENTRIES; i++) {
+    if (entries[i].query &&
+        strncmp(entries[i].query, prefix ? prefix : "", prefix_len) == 0) {
+      evict(&entries[i]);
+      num++;
+    }
+  }
+  return num;
+}
+
+
+/*
+  hash - FNV-1a hash of the query text
+
+  query[in]       query text
+
+  Returns unsigned long - 32 bit hash
+*/
+unsigned long MySQL_Cache::hash(const char *query) {
+  unsigned long key = 2166136261UL;
+
+  while (*query) {
+    key ^= (byte)*query++;
+    key *= 16777619UL;
+  }
+  return key & 0xffffffffUL;
+}
+
+
+cache_entry *MySQL_Cache::find(const char *query, unsigned long key,
+                               unsigned long session) {
+  for (int i = 0; i < MYSQL_CACHE_ENTRIES; i++) {
+    if (entries[i].query && entries[i].hash == key &&
+        entries[i].session == session &&
+        strcmp(entries[i].query, query) == 0)
+      return &entries[i];
+  }
+  return NULL;
+}
+
+
+void MySQL_Cache::evict(cache_entry *entry) {
+  if (entry == NULL || entry->query == NULL)
+    return;
+  bytes_used -= entry_size(entry);
+  mysql_free(entry->query);
+  mysql_free(entry->data);
+  entry->query = NULL;
+  entry->data = NULL;
+}
+
+
+unsigned long MySQL_Cache::entry_size(cache_entry *entry) {
+  return strlen(entry->query) + 1 + entry->len;
+}
@@ -0,0 +1,90 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Cache.h - Client side cache for small SELECT results
+
+  This header file defines a cache of result sets keyed by the query text.
+  A cursor given a cache (MySQL_Cursor::set_cache()) saves the packets of
+  each result set it reads completely and, while the entry is fresh,
+  answers the same query from memory through the normal cursor methods
+  (get_columns(), get_next_row(), fetch_into(), ...) without a round trip.
+
+  A result is keyed by the session state that read it: the server, the
+  user and the default database. Another connection or a reconnect with
+  the same state is answered from the cache; after USE or change_user()
+  the query is read again. Session variables changed with SET are not
+  part of the key, so do not cache queries that depend on them.
+
+  The cache holds at most MYSQL_CACHE_ENTRIES results within a byte budget
+  (packets plus query text). Entries expire after their time to live and
+  the least recently used entry is evicted to make room.
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_CACHE_H
+#define MYSQL_CACHE_H
+
+#include <Arduino.h>
+
+#ifndef MYSQL_CACHE_ENTRIES
+  #define MYSQL_CACHE_ENTRIES 8   // Maximum number of cached results
+#endif
+
+// Structure for one cached result.
+typedef struct {
+  unsigned long hash;       // hash of the query text
+  unsigned long session;    // session state that read the result
+  char *query;              // query text (NULL = free entry)
+  byte *data;               // packets of the result set
+  int len;                  // number of bytes in data
+  unsigned long stored;     // millis() when stored
+  unsigned long ttl;        // time to live in milliseconds
+  unsigned long last_used;  // millis() of the last hit
+} cache_entry;
+
+class MySQL_Cache {
+  public:
+    MySQL_Cache(unsigned long byte_budget, unsigned long default_ttl_ms);
+    ~MySQL_Cache();
+    const byte *lookup(const char *query, int *len,
+                       unsigned long session=0);
+    boolean store(char *query, byte *data, int len, unsigned long ttl_ms=0,
+                  unsigned long session=0);
+    int invalidate(const char *prefix=NULL);
+    unsigned long get_hits() { return hits; }
+    unsigned long get_misses() { return misses; }
+    unsigned long get_bytes_used() { return bytes_used; }
+    unsigned long get_budget() { return budget; }
+    void reset_stats() { hits = 0; misses = 0; }
+    static unsigned long hash(const char *query);
+
+  private:
+    cache_entry *find(const char *query, unsigned long key,
+                      unsigned long session);
+    void evict(cache_entry *entry);
+    unsigned long entry_size(cache_entry *entry);
+
+    cache_entry entries[MYSQL_CACHE_ENTRIES];
+    unsigned long budget;
+    unsigned long default_ttl;
+    unsigned long bytes_used;
+    unsigned long hits;
+    unsigned long misses;
+};
+
+#endif
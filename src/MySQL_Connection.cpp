@@ -32,14 +32,21 @@
 */
 #include <Arduino.h>
 #include <MySQL_Connection.h>
+#include <MySQL_Group_Commit.h>
 #include <MySQL_Encrypt_Sha1.h>
 
 #define MAX_CONNECT_ATTEMPTS 3
-#define CONNECT_DELAY_MS     500
+#define CONNECT_DELAY_MS     500   // Used until a round trip is measured
 #define SUCCESS              1
+#define COM_PING             0x0e
+#define COM_CHANGE_USER      0x11
+#define COM_RESET_CONNECTION 0x1f
 
 const char CONNECTED[] PROGMEM = "Connected to server version ";
 const char DISCONNECTED[] PROGMEM = "Disconnected.";
+const char CONNECT_FAILED[] PROGMEM = "ERROR: Cannot connect to server.";
+const char TLS_UNSUPPORTED[] PROGMEM = "ERROR: Server does not support SSL.";
+const char TLS_FAILED[] PROGMEM = "ERROR: TLS handshake failed.";
 
 /*
   connect - Connect to a MySQL server.
@@ -64,38 +71,300 @@ boolean MySQL_Connection::connect(IPAddress server, int port, char *user,
   int connected = 0;
   int retries = MAX_CONNECT_ATTEMPTS;
 
+  // Drop anything queued for a previous connection
+  clear_packets();
+  clear_error();
+  result_pending = false;
+
+  // A TLS connection starts over on the plain client
+  if (transport)
+    client = transport;
+  ssl_requested = false;
+
   // Retry up to MAX_CONNECT_ATTEMPTS times.
   while (retries--)
   {
-    Serial.println("...trying...");
+    MYSQL_LOG_D("...trying...");
     connected = client->connect(server, port);
     if (connected != SUCCESS) {
-      Serial.print("...got: ");
-      Serial.print(connected);
-      Serial.println(" retrying...");
-      delay(CONNECT_DELAY_MS);
+      MYSQL_LOG_W("...got: ", connected, " retrying...");
+      // Wait half the read timeout of the link measured so far
+      idle(get_rtt_samples() ? get_timeout() / 2 : CONNECT_DELAY_MS);
     } else {
       break;
     }
   }
 
-  if (connected != SUCCESS)
+  if (connected != SUCCESS) {
+    set_error(MYSQL_CR_CONN_HOST_ERROR, CONNECT_FAILED);
     return false;
+  }
 
   read_packet();
   parse_handshake_packet();
+  if (tls && !start_tls(server, port))
+    return false;
   send_authentication_packet(user, password, db);
+  if (get_error_code() == MYSQL_CR_OUT_OF_MEMORY)
+    return false;
   read_packet();
   if (get_packet_type() != MYSQL_OK_PACKET) {
     parse_error_packet();
     return false;
   }
+  start_session(server, port, user, db);
+
+  // Save the TLS session so the next connect can resume it
+  if (tls && tls_sessions) {
+    tls_sessions->count(tls->resumed());
+    tls_sessions->store(server, port, tls);
+  }
 
-  show_error(CONNECTED);
+  MYSQL_LOG_I(MYSQL_P(CONNECTED), server_version ? server_version : "");
 
-  Serial.println(server_version);
+  mysql_free(server_version); // don't need it anymore
+  server_version = NULL;
+  return true;
+}
+
+/*
+  set_tls - Encrypt the following connections with TLS
+
+  The connection asks the server to switch to TLS after its handshake
+  packet and then authenticates over the encrypted connection. With a
+  session cache, each connect saves the TLS session and the next connect
+  to the same server resumes it instead of doing a full handshake, which
+  is much faster on small boards. Several connections may share a cache.
+  Call this before connect().
+
+  backend[in]     TLS backend (e.g. MySQL_TLS_Mbedtls), NULL for plain
+                  connections
+  sessions[in]    (optional) cache of sessions to resume
+  host[in]        (optional) server name for certificate verification
+*/
+void MySQL_Connection::set_tls(MySQL_TLS *backend, MySQL_TLS_Cache *sessions,
+                               const char *host)
+{
+  if (transport)
+    client = transport;
+  transport = backend ? client : NULL;
+  tls = backend;
+  tls_sessions = sessions;
+  tls_host = host;
+}
+
+/*
+  start_tls - Switch the connection to TLS
+
+  This sends the SSL request packet and runs the TLS handshake over the
+  plain client, offering the saved session of the server if there is one.
+
+  server[in]      server IP address (session cache key)
+  port[in]        server port
+
+  Returns boolean - True = connection encrypted
+*/
+boolean MySQL_Connection::start_tls(IPAddress server, int port)
+{
+  mysql_tls_session *session = NULL;
+  Client *secure;
+
+  if (!(server_capabilities & MYSQL_CLIENT_SSL)) {
+    set_error(MYSQL_CR_SSL_CONNECTION_ERROR, TLS_UNSUPPORTED);
+    client->stop();
+    return false;
+  }
+  send_ssl_request();
+  if (tls_sessions)
+    session = tls_sessions->find(server, port);
+  secure = tls->handshake(client, tls_host, session ? session->data : NULL,
+                          session ? session->len : 0);
+  if (secure == NULL) {
+    // Do not offer a session the server refused again
+    if (session)
+      tls_sessions->forget(server, port);
+    set_error(MYSQL_CR_SSL_CONNECTION_ERROR, TLS_FAILED);
+    client->stop();
+    return false;
+  }
+  client = secure;
+  return true;
+}
+
+/*
+  set_group_commit - Group the writes of this connection in transactions
+
+  The INSERT, UPDATE, DELETE and REPLACE statements run by the cursors of
+  this connection go into transactions committed by the scheduler (see
+  MySQL_Group_Commit.h). The open group of the previous scheduler is
+  committed first.
+
+  scheduler[in]   write scheduler, NULL to autocommit each statement
+*/
+void MySQL_Connection::set_group_commit(MySQL_Group_Commit *scheduler)
+{
+  if (group) {
+    if (connected())
+      group->commit();
+    group->attach(NULL);
+  }
+  group = scheduler;
+  group_hooks = group ? &mysql_group_commit_hooks : NULL;
+  if (group)
+    group->attach(this);
+}
+
+/*
+  set_local_infile - Allow LOAD DATA LOCAL INFILE on the next connect()
+
+  The server only sends local file requests to clients that announce
+  support for them. Call this before connect(). The file data comes from
+  the stream given to MySQL_Cursor::set_infile_source().
+
+  enable[in]      True to allow LOCAL INFILE
+*/
+void MySQL_Connection::set_local_infile(boolean enable)
+{
+  if (enable)
+    client_flags |= MYSQL_CLIENT_LOCAL_FILES;
+  else
+    client_flags &= ~MYSQL_CLIENT_LOCAL_FILES;
+}
+
+/*
+  ping - Check that the server is still answering on this connection
+
+  This method sends a COM_PING command and waits for the Ok packet. It
+  is a cheap way to validate a connection that has been idle for some
+  time before issuing a query on it (see MySQL_Pool).
+
+  Returns boolean - True = server answered with an Ok packet
+*/
+boolean MySQL_Connection::ping()
+{
+  byte ping_packet[5];
 
-  free(server_version); // don't need it anymore
+  if (!connected())
+    return false;
+
+  store_int(&ping_packet[0], 1, 3);
+  ping_packet[3] = byte(0x00);
+  ping_packet[4] = byte(COM_PING);
+  write_packet(ping_packet, 5);
+
+  read_packet();
+  return get_packet_type() == MYSQL_OK_PACKET;
+}
+
+/*
+  reset - Reset the session state without reconnecting
+
+  This method sends COM_RESET_CONNECTION (MySQL 5.7.3 and later). The
+  server rolls back any open transaction, drops temporary tables and
+  user variables and resets session variables, but keeps the socket
+  and the authenticated user. It is much cheaper than close() followed
+  by connect() when a node only needs a clean session.
+
+  Returns boolean - True = session was reset
+*/
+boolean MySQL_Connection::reset()
+{
+  byte reset_packet[5];
+
+  if (!connected())
+    return false;
+
+  // The reset would roll back the open group
+  group_commit();
+
+  store_int(&reset_packet[0], 1, 3);
+  reset_packet[3] = byte(0x00);
+  reset_packet[4] = byte(COM_RESET_CONNECTION);
+  write_packet(reset_packet, 5);
+
+  read_packet();
+  if (get_packet_type() != MYSQL_OK_PACKET) {
+    parse_error_packet();
+    return false;
+  }
+  return true;
+}
+
+/*
+  change_user - Authenticate as another user on the open connection
+
+  This method sends COM_CHANGE_USER which re-authenticates on the same
+  socket (using the scramble seed of the original handshake) and resets
+  the session like reset(). It avoids the TCP connect and handshake of a
+  new connection. The command packet is defined as follows.
+
+  Bytes                        Name
+  -----                        ----
+  1                            command (0x11)
+  n (Null-Terminated String)   user
+  n (Length Coded Binary)      scramble_buff (1 + x bytes)
+  n (Null-Terminated String)   databasename
+  2                            charset_number
+
+  user[in]        user name
+  password[in]    (optional) user password
+  db[in]          (optional) default database
+
+  Returns boolean - True = user changed
+*/
+boolean MySQL_Connection::change_user(char *user, char *password, char *db)
+{
+  int user_len = strlen(user);
+  int db_len = db ? strlen(db) : 0;
+  int size_send = 4;
+
+  if (!connected())
+    return false;
+
+  group_commit();
+  free_buffer();
+  buffer = (byte *)mysql_malloc(4 + 1 + user_len + 1 + 21 + db_len + 1 + 2,
+                                MYSQL_ALLOC_COMMAND);
+  if (buffer == NULL) {
+    set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+    return false;
+  }
+
+  buffer[size_send++] = byte(COM_CHANGE_USER);
+
+  // user name
+  memcpy((char *)&buffer[size_send], user, user_len);
+  size_send += user_len;
+  buffer[size_send++] = 0x00;
+
+  // password - see scramble password
+  if (password && scramble_password(password, &buffer[size_send+1])) {
+    buffer[size_send] = 0x14;
+    size_send += 21;
+  } else {
+    buffer[size_send++] = 0x00;
+  }
+
+  // default database
+  if (db_len)
+    memcpy((char *)&buffer[size_send], db, db_len);
+  size_send += db_len;
+  buffer[size_send++] = 0x00;
+
+  // charset - default is 8
+  buffer[size_send++] = byte(0x08);
+  buffer[size_send++] = byte(0x00);
+
+  store_int(&buffer[0], size_send - 4, 3);
+  buffer[3] = byte(0x00);
+  write_packet(buffer, size_send);
+
+  read_packet();
+  if (get_packet_type() != MYSQL_OK_PACKET) {
+    parse_error_packet();
+    return false;
+  }
+  change_session(user, db);
   return true;
 }
 
@@ -103,14 +372,28 @@ boolean MySQL_Connection::connect(IPAddress server, int port, char *user,
   close - cancel the connection
 
   This method closes the connection to the server and frees up any memory
-  used in the buffer.
+  used in the buffer. The open group of the write scheduler is committed
+  first, unless a result set is still being read: the reply to a COMMIT
+  could not be told from the rows, so the group is abandoned instead
+  (see MySQL_Group_Commit::abandon()).
 */
 void MySQL_Connection::close()
 {
   if (connected())
   {
+    if (!result_pending)
+      group_commit();
+    else if (group)
+      group_hooks->abandon(group);
+    flush_packets();
     client->flush();
     client->stop();
-    show_error(DISCONNECTED, true);
+    MYSQL_LOG_I(MYSQL_P(DISCONNECTED));
   }
+  // Nothing is held between connections (a failed connect may have
+  // kept the last packet and the server version)
+  free_buffer();
+  mysql_free(server_version);
+  server_version = NULL;
+  result_pending = false;
 }
@@ -37,16 +37,64 @@
 #define MYSQL_CONNECTION_H
 
 #include <MySQL_Packet.h>
+#include <MySQL_TLS.h>
+
+class MySQL_Group_Commit;
+
+// Calls into the write scheduler. set_group_commit() installs them, so
+// sketches that never set a scheduler do not link its code.
+typedef struct {
+  boolean (*route)(MySQL_Group_Commit *group, const char *query,
+                   boolean progmem);
+  void (*opened)(MySQL_Group_Commit *group);
+  void (*written)(MySQL_Group_Commit *group, boolean ok);
+  boolean (*commit)(MySQL_Group_Commit *group);
+  void (*abandon)(MySQL_Group_Commit *group);
+} mysql_group_hooks;
 
 class MySQL_Connection : public MySQL_Packet {
   public:
     MySQL_Connection(Client *client_instance) :
-        MySQL_Packet(client_instance) {}
+        MySQL_Packet(client_instance), tls(NULL), tls_sessions(NULL),
+        tls_host(NULL), transport(NULL), group(NULL), group_hooks(NULL),
+        result_pending(false) {}
     boolean connect(IPAddress server, int port, char *user, char *password,
                     char *db=NULL);
     int connected() { return client->connected(); }
     const char *version() { return MYSQL_VERSION_STR; }
+    void set_local_infile(boolean enable);
+    boolean ping();
+    boolean reset();
+    boolean change_user(char *user, char *password, char *db=NULL);
     void close();
+    void set_tls(MySQL_TLS *backend, MySQL_TLS_Cache *sessions=NULL,
+                 const char *host=NULL);
+    boolean tls_resumed() { return tls && ssl_requested && tls->resumed(); }
+    void set_group_commit(MySQL_Group_Commit *scheduler);
+    MySQL_Group_Commit *get_group_commit() { return group; }
+
+    // Used by MySQL_Cursor, see MySQL_Group_Commit
+    boolean group_route(const char *query, boolean progmem) {
+      return group && group_hooks->route(group, query, progmem);
+    }
+    void group_opened() { group_hooks->opened(group); }
+    void group_written(boolean ok) { group_hooks->written(group, ok); }
+    void group_commit() {
+      if (group)
+        group_hooks->commit(group);
+    }
+    void set_result_pending(boolean pending) { result_pending = pending; }
+
+  private:
+    boolean start_tls(IPAddress server, int port);
+
+    MySQL_TLS *tls;                 // TLS backend (NULL = plain connection)
+    MySQL_TLS_Cache *tls_sessions;  // saved sessions to resume (optional)
+    const char *tls_host;           // server name for the TLS handshake
+    Client *transport;              // plain client the TLS runs over
+    MySQL_Group_Commit *group;      // write scheduler (optional)
+    const mysql_group_hooks *group_hooks;
+    boolean result_pending;         // a reply is not read to its end
 };
 
 #endif
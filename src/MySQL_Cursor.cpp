@@ -29,12 +29,27 @@
   Version 1.1.2b Created by Dr. Charles A. Bell, November 2016.
   Version 1.2.0 Created by Dr. Charles A. Bell, March 2020.
 */
+#include <limits.h>
 #include <MySQL_Cursor.h>
 
 const char BAD_MOJO[] PROGMEM = "Bad mojo. EOF found reading column header.";
 const char ROWS[] PROGMEM = " rows in result.";
 const char READ_COLS[] PROGMEM = "ERROR: You must read the columns first!";
 const char NOT_CONNECTED[] PROGMEM = "ERROR: Class requires connected server.";
+const char BAD_MAP[] PROGMEM = "ERROR: Row map does not match the columns.";
+const char INFILE_SHORT[] PROGMEM = "ERROR: Local infile data ended early.";
+
+// Column types of the server used to check row maps
+#define MYSQL_TYPE_DECIMAL     0x00
+#define MYSQL_TYPE_TINY        0x01
+#define MYSQL_TYPE_SHORT       0x02
+#define MYSQL_TYPE_LONG        0x03
+#define MYSQL_TYPE_FLOAT       0x04
+#define MYSQL_TYPE_DOUBLE      0x05
+#define MYSQL_TYPE_LONGLONG    0x08
+#define MYSQL_TYPE_INT24       0x09
+#define MYSQL_TYPE_YEAR        0x0d
+#define MYSQL_TYPE_NEWDECIMAL  0xf6
 
 /*
   Constructor
@@ -46,6 +61,8 @@ const char NOT_CONNECTED[] PROGMEM = "ERROR: Class requires connected server.";
 */
 MySQL_Cursor::MySQL_Cursor(MySQL_Connection *connection) {
   conn = connection;
+  infile = NULL;
+  infile_left = -1;
 #ifdef WITH_SELECT
   columns.num_fields = 0;
   for (int f = 0; f < MAX_FIELDS; f++) {
@@ -55,6 +72,20 @@ MySQL_Cursor::MySQL_Cursor(MySQL_Connection *connection) {
   columns_read = false;
   rows_affected = -1;
   last_insert_id = -1;
+  result_state = MYSQL_RESULT_NONE;
+  more_results_exist = false;
+  bound_map = NULL;
+  set_all_columns();
+  cache = NULL;
+  cache_ttl = 0;
+  capture_query = NULL;
+  value_column = -1;
+  value_left = 0;
+  meta_arena = NULL;
+  meta_size = 0;
+  meta_used = 0;
+  fetch_block = NULL;
+  fetch_size = 0;
 #endif
 }
 
@@ -80,6 +111,9 @@ MySQL_Cursor::~MySQL_Cursor() {
   packets and rows can be read separately using the get_field() and
   get_row() methods.
 
+  With a write scheduler on the connection (set_group_commit()) writes
+  are run in its open transaction and committed with the group.
+
   query[in]       SQL statement (using normal memory access)
   progmem[in]     True if string is in program memory
 
@@ -90,19 +124,151 @@ boolean MySQL_Cursor::execute(const char *query, boolean progmem)
   int query_len;   // length of query
 
   if (!conn->connected()) {
-    conn->show_error(NOT_CONNECTED, true);
+    conn->set_error(MYSQL_CR_SERVER_GONE_ERROR, NOT_CONNECTED);
+    return false;
+  }
+
+#ifdef WITH_SELECT
+  // Consume results left over from the previous query
+  clear_ok_packet();
+
+  // Answer from the cache or capture the result for it
+  if (cache && !progmem) {
+    int len = 0;
+    const byte *data = cache->lookup(query, &len, conn->get_session());
+    if (data) {
+      conn->set_packet_source(data, len);
+      return query_response();
+    }
+    capture_query = (char *)mysql_malloc(strlen(query)+1,
+                                         MYSQL_ALLOC_CACHE_QUERY);
+    if (capture_query) {
+      strcpy(capture_query, query);
+      conn->start_capture(cache->get_budget());
+    }
+  }
+#endif
+
+  // Writes go into the open group of the write scheduler
+  boolean grouped = conn->group_route(query, progmem);
+
+  query_len = build_query(query, progmem);
+  if (query_len < 0) {
+#ifdef WITH_SELECT
+    end_cache_capture(false);
+#endif
+    if (grouped) {
+      conn->group_opened();
+      conn->group_written(false);
+    }
     return false;
   }
 
+  // Send the query
+  boolean res;
+  if (grouped) {
+    send_query(query_len);
+    conn->group_opened();
+    res = query_response();
+    conn->group_written(res);
+  } else {
+    res = execute_query(query_len);
+  }
+#ifdef WITH_SELECT
+  // Only result sets are cached
+  if (result_state == MYSQL_RESULT_NONE)
+    end_cache_capture(false);
+#endif
+  return res;
+}
+
+
+/*
+  execute_batch - Execute several SQL statements in one round trip
+
+  This method queues all statements before reading any response so they
+  are coalesced in the connection's outgoing buffer and leave in as few
+  TCP segments as possible. The responses are then read in order. Use it
+  for statements that do not return rows (e.g. a batch of INSERTs);
+  any result set returned is read and discarded. The open group of the
+  write scheduler is committed first; the statements of the batch are
+  not grouped.
+
+  queries[in]     Array of SQL statements
+  count[in]       Number of statements in the array
+  progmem[in]     True if the strings are in program memory
+
+  Returns integer - Number of statements that succeeded
+*/
+int MySQL_Cursor::execute_batch(const char *queries[], int count,
+                                boolean progmem)
+{
+  int query_len;
+  int sent = 0;
+  int succeeded = 0;
+  int total_rows = 0;
+
+  if (!conn->connected()) {
+    conn->set_error(MYSQL_CR_SERVER_GONE_ERROR, NOT_CONNECTED);
+    return 0;
+  }
+
+#ifdef WITH_SELECT
+  clear_ok_packet();
+#endif
+  // Batched writes would run in the open group without being counted
+  conn->group_commit();
+
+  for (int q = 0; q < count; q++) {
+    query_len = build_query(queries[q], progmem);
+    if (query_len < 0)
+      break;
+    send_query(query_len);
+    sent++;
+  }
+
+  for (int q = 0; q < sent; q++) {
+    if (!query_response())
+      continue;
+    if (rows_affected > 0)
+      total_rows += rows_affected;
+#ifdef WITH_SELECT
+    // Result sets are not expected in a batch, consume them
+    clear_ok_packet();
+#endif
+    succeeded++;
+  }
+  rows_affected = total_rows;
+  return succeeded;
+}
+
+
+/*
+  build_query - Copy a query into the packet buffer
+
+  This method copies the query to the buffer leaving room for the packet
+  header and command byte.
+
+  query[in]       SQL statement (using normal memory access)
+  progmem[in]     True if string is in program memory
+
+  Returns integer - length of the query, -1 if out of memory
+*/
+int MySQL_Cursor::build_query(const char *query, boolean progmem)
+{
+  int query_len;   // length of query
+
   if (progmem) {
     query_len = (int)strlen_P(query);
   } else {
     query_len = (int)strlen(query);
   }
-  if (conn->buffer != NULL)
-    free(conn->buffer);
-
-  conn->buffer = (byte *)malloc(query_len+5);
+  conn->free_buffer();
+  conn->buffer = (byte *)mysql_malloc(query_len+5, MYSQL_ALLOC_QUERY);
+  if (conn->buffer == NULL) {
+    conn->set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+    return -1;
+  }
 
   // Write query to packet
   if (progmem) {
@@ -111,9 +277,22 @@ boolean MySQL_Cursor::execute(const char *query, boolean progmem)
   } else {
     memcpy(&conn->buffer[5], query, query_len);
   }
+  return query_len;
+}
 
-  // Send the query
-  return execute_query(query_len);
+
+/*
+  send_query - Frame the query in the buffer and queue it for sending
+
+  query_len[in]   Number of bytes in the query string
+*/
+void MySQL_Cursor::send_query(int query_len)
+{
+  conn->store_int(&conn->buffer[0], query_len+1, 3);
+  conn->buffer[3] = byte(0x00);
+  conn->buffer[4] = byte(0x03);  // command packet
+
+  conn->write_packet(conn->buffer, query_len + 5);
 }
 
 
@@ -136,52 +315,149 @@ boolean MySQL_Cursor::execute_query(int query_len)
   if (!conn->buffer)
     return false;
 
+  // Send the query
+  send_query(query_len);
+
+  return query_response();
+}
+
+
+/*
+  query_response - Read the response to a query
+
+  Returns boolean - true = Ok packet or result set available,
+                    false = error
+*/
+boolean MySQL_Cursor::query_response()
+{
   // Reset the rows affected and last insert id before query.
   rows_affected = -1;
   last_insert_id = -1;
 
-  conn->store_int(&conn->buffer[0], query_len+1, 3);
-  conn->buffer[3] = byte(0x00);
-  conn->buffer[4] = byte(0x03);  // command packet
-
-  // Send the query
-  conn->client->write((uint8_t*)conn->buffer, query_len + 5);
-  conn->client->flush();
-
   // Read a response packet and check it for Ok or Error.
   conn->read_packet();
   int res = conn->get_packet_type();
+  if (res == MYSQL_LOCAL_INFILE_PACKET) {
+    // LOAD DATA LOCAL INFILE, the server answers once it has the data
+    boolean sent = send_local_file();
+    if (!conn->connected())
+      return false;
+    conn->read_packet();
+    res = conn->get_packet_type();
+    if (!sent && res != MYSQL_ERROR_PACKET)
+      return false;   // out of memory, no data was sent
+  }
   if (res == MYSQL_ERROR_PACKET) {
     conn->parse_error_packet();
     return false;
   } else if (res == MYSQL_OK_PACKET || res == MYSQL_EOF_PACKET) {
     // Read the rows affected and last insert id.
-    int loc1 = conn->buffer[5];  // Location of rows affected
-    int loc2 = 5;
-    if (loc1 < 252) {
-      loc2++;
-    } else if (loc1 == 252) {
-      loc2 += 2;
-    } else if (loc1 == 253) {
-      loc2 += 3;
-    } else {
-      loc2 += 8;
-    }
+    int loc2 = 5 + conn->get_lcb_len(5);  // Location of last insert id
     rows_affected = conn->read_lcb_int(5);
     if (rows_affected > 0) {
       last_insert_id = conn->read_lcb_int(loc2);
     }
+#ifdef WITH_SELECT
+    more_results_exist = (conn->parse_server_status() &
+                          MYSQL_SERVER_MORE_RESULTS_EXISTS) != 0;
+    set_result_state(MYSQL_RESULT_NONE);
+#endif
     return true;
   }
 
   // Not an Ok packet, so we now have the result set to process.
 #ifdef WITH_SELECT
   columns_read = false;
+  more_results_exist = false;
+  set_result_state(MYSQL_RESULT_COLUMNS);
+  bound_map = NULL;
 #endif
   return true;
 }
 
 
+/*
+  send_local_file - Answer a LOCAL INFILE request from the server
+
+  The server sends the file name it wants (LOAD DATA LOCAL INFILE) and
+  expects the file contents as a series of packets ending with an empty
+  packet. The contents are streamed from the source set with
+  set_infile_source() in MYSQL_INFILE_CHUNK sized packets, so memory use
+  does not depend on the size of the data. With a length given, exactly
+  that many bytes are sent; if the source stops short (no byte within
+  its timeout, see Stream::setTimeout()) the connection is closed so the
+  server does not load part of the data. Without a length the data ends
+  when no byte arrives within the timeout, so a File or a memory stream
+  costs one timeout at its end. The source is used for one request only;
+  without one an empty file is sent.
+
+  The request packet is defined as follows.
+
+  Bytes                        Name
+  -----                        ----
+  1                            0xfb
+  n                            file name
+
+  Returns boolean - True = the data was sent, False = out of memory (an
+                    empty file was sent) or the data ended early
+*/
+boolean MySQL_Cursor::send_local_file() {
+  byte seq = conn->buffer ? conn->buffer[3] : 1;
+  int len = 0;
+
+  conn->free_buffer();
+  conn->buffer = (byte *)mysql_malloc(MYSQL_INFILE_CHUNK+4,
+                                      MYSQL_ALLOC_INFILE);
+  if (conn->buffer == NULL) {
+    byte end[4];
+
+    conn->set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+    // The empty packet still ends the request, the connection stays usable
+    conn->store_int(&end[0], 0, 3);
+    end[3] = ++seq;
+    conn->write_packet(end, 4);
+    infile = NULL;
+    return false;
+  }
+
+  do {
+    len = 0;
+    while (infile && infile_left != 0 && len < MYSQL_INFILE_CHUNK) {
+      int num = MYSQL_INFILE_CHUNK - len;
+      if (infile_left > 0 && num > infile_left)
+        num = (int)infile_left;
+      // Take what is there, or wait for one byte up to the timeout
+      int ready = infile->available();
+      if (num > ready)
+        num = ready > 0 ? ready : 1;
+      num = infile->readBytes((char *)&conn->buffer[4+len], num);
+      if (num <= 0) {
+        infile = NULL;  // end of the data
+        break;
+      }
+      len += num;
+      if (infile_left > 0)
+        infile_left -= num;
+    }
+    if (len == 0 && infile_left > 0) {
+      // Ending here would load part of the data. Nothing else can be
+      // sent in the middle of it (e.g. the COMMIT of a group).
+      conn->set_error(MYSQL_CR_SERVER_LOST, INFILE_SHORT);
+      conn->set_result_pending(true);
+      conn->close();
+      infile_left = -1;
+      return false;
+    }
+    conn->store_int(&conn->buffer[0], len, 3);
+    conn->buffer[3] = ++seq;
+    conn->write_packet(conn->buffer, len+4);
+  } while (len > 0);
+  infile = NULL;
+  infile_left = -1;
+  return true;
+}
+
+
 #ifdef WITH_SELECT
 /*
   Close
@@ -190,7 +466,14 @@ boolean MySQL_Cursor::execute_query(int query_len)
 */
 void MySQL_Cursor::close() {
   free_columns_buffer();
+  mysql_free(meta_arena);
+  meta_arena = NULL;
+  meta_size = 0;
+  mysql_free(fetch_block);
+  fetch_block = NULL;
+  fetch_size = 0;
   free_row_buffer();
+  end_cache_capture(false);
 }
 
 
@@ -204,14 +487,18 @@ void MySQL_Cursor::close() {
         the field data to free memory.
 */
 column_names *MySQL_Cursor::get_columns() {
+  if (result_state == MYSQL_RESULT_ROWS)
+    return &columns;
   free_columns_buffer();
   free_row_buffer();
   num_cols = 0;
-  if (get_fields()) {
+  if (result_state == MYSQL_RESULT_COLUMNS && get_fields()) {
     columns_read = true;
+    set_result_state(MYSQL_RESULT_ROWS);
     return &columns;
   }
   else {
+    set_result_state(MYSQL_RESULT_NONE);
     return NULL;
   }
 }
@@ -231,6 +518,8 @@ row_values *MySQL_Cursor::get_next_row() {
   int res = 0;
 
   free_row_buffer();
+  if (result_state != MYSQL_RESULT_ROWS)
+    return NULL;
 
   // Read the rows
   res = get_row_values();
@@ -241,6 +530,206 @@ row_values *MySQL_Cursor::get_next_row() {
 }
 
 
+/*
+  open_row - Start reading the next row a value at a time
+
+  Use this instead of get_next_row() for values too large to hold in
+  memory, such as BLOB and TEXT columns with photos or firmware. The row
+  is not copied: next_value() moves to each value in turn and
+  read_value() reads it in chunks into a buffer of your own, with its
+  exact length and any zero bytes it contains. Values not read are
+  skipped. Small rows are read from the read buffer, large ones straight
+  from the client.
+
+    while (cur->open_row()) {
+      long len = cur->next_value();   // first column
+      while ((n = cur->read_value(chunk, sizeof(chunk))) > 0)
+        file.write(chunk, n);
+    }
+
+  Returns boolean - True = a row was opened,
+                    False = no more rows or error
+*/
+boolean MySQL_Cursor::open_row() {
+  int type;
+
+  value_column = -1;
+  value_left = 0;
+  free_row_buffer();
+  if (result_state == MYSQL_RESULT_COLUMNS)
+    get_columns();
+  if (result_state != MYSQL_RESULT_ROWS)
+    return false;
+
+  type = conn->open_packet();
+  if (type < 0 || type == MYSQL_ERROR_PACKET) {
+    if (type == MYSQL_ERROR_PACKET)
+      conn->parse_error_packet();
+    end_cache_capture(false);
+    more_results_exist = false;
+    set_result_state(MYSQL_RESULT_NONE);
+    return false;
+  }
+  if (conn->is_eof_packet()) {
+    end_rows();
+    return false;
+  }
+  value_column = 0;
+  value_lead = type;
+  return true;
+}
+
+
+/*
+  next_value - Move to the next value of the row from open_row()
+
+  The unread rest of the current value is skipped.
+
+  Returns long - length of the value in bytes,
+                 MYSQL_VALUE_NULL = the value is NULL,
+                 MYSQL_VALUE_NONE = no more values or error
+*/
+long MySQL_Cursor::next_value() {
+  byte lcb[8];
+  int lead;
+  int len_bytes;
+  long len = 0;
+
+  if (value_column < 0 || value_column >= num_cols)
+    return MYSQL_VALUE_NONE;
+  if (value_left > 0 && conn->read_payload(NULL, value_left) < value_left)
+    return close_row();
+  value_left = 0;
+
+  // The first byte of the row was read by open_row()
+  if (value_column == 0) {
+    lead = value_lead;
+  } else {
+    if (conn->read_payload(lcb, 1) < 1)
+      return close_row();
+    lead = lcb[0];
+  }
+  value_column++;
+  if (lead == 0xfb)
+    return MYSQL_VALUE_NULL;
+  if (lead < 0xfb) {
+    value_left = lead;
+    return value_left;
+  }
+
+  len_bytes = lead == 0xfc ? 2 : lead == 0xfd ? 3 : 8;
+  if (conn->read_payload(lcb, len_bytes) < len_bytes)
+    return close_row();
+  // Lengths that do not fit a long (e.g. 0xfe and 8 bytes on AVR) fail
+  for (int i = len_bytes; i > 0; i--) {
+    if (len > (long)(LONG_MAX >> 8))
+      return close_row();
+    len = (len << 8) | lcb[i-1];
+  }
+  value_left = len;
+  return len;
+}
+
+
+/*
+  read_value - Read the next chunk of the value from next_value()
+
+  dest[out]       where to store the bytes (not terminated)
+  size[in]        size of dest
+
+  Returns integer - bytes read, 0 = end of the value, -1 = error
+*/
+int MySQL_Cursor::read_value(byte *dest, int size) {
+  int num;
+
+  if (value_left <= 0)
+    return 0;
+  if (size > value_left)
+    size = value_left;
+  num = conn->read_payload(dest, size);
+  if (num <= 0) {
+    close_row();
+    return -1;
+  }
+  value_left -= num;
+  return num;
+}
+
+
+/*
+  close_row - Stop reading the row from open_row() after an error
+
+  Returns long - MYSQL_VALUE_NONE
+*/
+long MySQL_Cursor::close_row() {
+  value_column = -1;
+  value_left = 0;
+  return MYSQL_VALUE_NONE;
+}
+
+
+/*
+  next_result - Advance to the next result of a multi-result query
+
+  Stored procedure calls (and multiple statements in one query) return
+  several results: result sets and a trailing Ok packet. The server flags
+  each result that is followed by another one. This method consumes
+  what is left of the current result and reads the next one, so the
+  results can be processed (or skipped) one at a time without guessing
+  how long to wait for packets still in flight.
+
+  Use has_result_set() to tell a result set (read it with get_columns()
+  and get_next_row()) from an Ok packet (see get_rows_affected()).
+
+  Returns boolean - True = another result was read
+                    False = no more results or error
+*/
+boolean MySQL_Cursor::next_result() {
+  unsigned long skipped = 0;
+
+  // Consume the rest of the current result set
+  if (!skip_result(0, &skipped))
+    return false;
+
+  if (!more_results_exist)
+    return false;
+  more_results_exist = false;
+  return query_response();
+}
+
+
+/*
+  discard_results - Consume the rest of the results without reading them
+
+  Use this when you stop reading a result set early. The remaining row
+  packets are skipped in bulk without being parsed or allocated, unlike
+  reading them with get_next_row(). Results that follow (e.g. of a stored
+  procedure call) are discarded as well.
+
+  When a large result is abandoned it can be cheaper to drop the
+  connection than to receive the rest. If more than max_bytes have to be
+  skipped the connection is closed instead, and you must connect() again
+  before the next query.
+
+  max_bytes[in]   bytes to skip before closing the connection, 0 = no limit
+
+  Returns boolean - True = results consumed
+                    False = error or the connection was closed
+*/
+boolean MySQL_Cursor::discard_results(unsigned long max_bytes) {
+  unsigned long skipped = 0;
+
+  while (skip_result(max_bytes, &skipped)) {
+    if (!more_results_exist)
+      return true;
+    more_results_exist = false;
+    if (!query_response())
+      return false;
+  }
+  return false;
+}
+
+
 /*
   show_results - Show a result set from the server via Serial.print
 
@@ -264,7 +753,8 @@ void MySQL_Cursor::show_results() {
   }
 
   for (int f = 0; f < columns.num_fields; f++) {
-    Serial.print(columns.fields[f]->name);
+    if (column_selected(f))
+      Serial.print(columns.fields[f]->name);
     if (f < columns.num_fields-1)
       Serial.print(',');
   }
@@ -274,7 +764,8 @@ void MySQL_Cursor::show_results() {
   while (get_next_row()) {
     rows++;
     for (int f = 0; f < columns.num_fields; f++) {
-      Serial.print(row.values[f]);
+      if (row.values[f] != NULL)
+        Serial.print(row.values[f]);
       if (f < columns.num_fields-1)
         Serial.print(',');
     }
@@ -284,7 +775,8 @@ void MySQL_Cursor::show_results() {
 
   // Report how many rows were read
   Serial.print(rows);
-  conn->show_error(ROWS, true);
+  mysql_print_P(&Serial, ROWS);
+  Serial.println();
   free_columns_buffer();
 
   // Free any post-query messages in queue for stored procedures
@@ -293,55 +785,113 @@ void MySQL_Cursor::show_results() {
 
 
 /*
-  clear_ok_packet - clear last Ok packet (if present)
+  set_cache - Answer repeated queries from a result cache
 
-  This method reads the header and status to see if this is an Ok packet.
-  If it is, it reads the packet and discards it. This is useful for
-  processing result sets from stored procedures.
+  Result sets read completely are saved in the cache and the same query
+  text is answered from it until the entry expires. Only queries in
+  normal memory are cached. Several cursors may share a cache; results
+  are only answered to a session with the same server, user and default
+  database.
 
-  Returns False if the packet was not an Ok packet.
+  result_cache[in]  cache to use, NULL to stop caching
+  ttl_ms[in]        time to live of results stored by this cursor,
+                    0 = the cache's default
 */
-bool MySQL_Cursor::clear_ok_packet() {
-  int num = 0;
+void MySQL_Cursor::set_cache(MySQL_Cache *result_cache, unsigned long ttl_ms) {
+  end_cache_capture(false);
+  cache = result_cache;
+  cache_ttl = ttl_ms;
+}
 
-  do {
-    num = conn->client->available();
-    if (num > 0) {
-      conn->read_packet();
-      if (conn->get_packet_type() != MYSQL_OK_PACKET) {
-        conn->parse_error_packet();
-        return false;
-      }
+
+/*
+  end_cache_capture - Finish capturing a result for the cache
+
+  keep[in]        True to store the captured result in the cache
+*/
+void MySQL_Cursor::end_cache_capture(boolean keep) {
+  int len = 0;
+  byte *data;
+
+  if (capture_query == NULL)
+    return;
+  if (keep && conn->capturing()) {
+    data = conn->end_capture(&len);
+    if (data) {
+      cache->store(capture_query, data, len, cache_ttl,
+                   conn->get_session());
+      capture_query = NULL;
+      return;
     }
-  } while (num > 0);
+  }
+  conn->cancel_capture();
+  mysql_free(capture_query);
+  capture_query = NULL;
+}
+
+
+/*
+  set_columns - Select the columns decoded by get_next_row()
+
+  Only the selected columns are copied into the row values, the others
+  are skipped in the packet and left NULL. Per row work and memory then
+  scale with the columns used rather than the columns returned. The
+  selection applies to all following queries until changed.
+
+  indexes[in]     column indexes (0 based) to decode
+  count[in]       number of indexes, 0 selects all columns
+*/
+void MySQL_Cursor::set_columns(const int *indexes, int count) {
+  if (count <= 0) {
+    set_all_columns();
+    return;
+  }
+  memset(column_mask, 0, sizeof(column_mask));
+  for (int i = 0; i < count; i++) {
+    if (indexes[i] >= 0 && indexes[i] < MAX_FIELDS)
+      column_mask[indexes[i] >> 3] |= (1 << (indexes[i] & 7));
+  }
+}
+
+
+/*
+  set_all_columns - Decode all columns in get_next_row() (the default)
+*/
+void MySQL_Cursor::set_all_columns() {
+  memset(column_mask, 0xff, sizeof(column_mask));
+}
+
+
+/*
+  clear_ok_packet - clear the remaining results (if present)
+
+  This method consumes the rest of the current result set and every
+  result that follows it, such as the trailing Ok packet of a stored
+  procedure call. The server status flags tell whether more results
+  follow so this does not depend on what happens to be buffered.
+
+  Returns False if one of the results was an error.
+*/
+bool MySQL_Cursor::clear_ok_packet() {
+  while (next_result());
   rows_affected = -1;
   last_insert_id = -1;
-  return true;
+  return conn->get_packet_type() != MYSQL_ERROR_PACKET;
 }
 
 
 /*
-  free_columns_buffer - Free memory allocated for column names
-
-  This method frees the memory allocated during the get_columns()
-  method.
+  free_columns_buffer - Drop the column names of the result set
 
-  NOTICE: Failing to call this method after calling get_columns()
-          and consuming the column names, types, etc. will result
-          in a memory leak. The size of the leak will depend on
-          the size of the combined column names (bytes).
+  The column definitions read by get_columns() are dropped. Their memory
+  (the metadata arena) is kept for the next result set of the cursor
+  and freed by close().
 */
 void MySQL_Cursor::free_columns_buffer() {
-  // clear the columns
-  for (int f = 0; f < MAX_FIELDS; f++) {
-    if (columns.fields[f] != NULL) {
-      free(columns.fields[f]->db);
-      free(columns.fields[f]->table);
-      free(columns.fields[f]->name);
-      free(columns.fields[f]);
-    }
+  // clear the columns, the arena is kept for the next result set
+  for (int f = 0; f < MAX_FIELDS; f++)
     columns.fields[f] = NULL;
-  }
+  meta_used = 0;
   num_cols = 0;
   columns_read = false;
 }
@@ -362,7 +912,7 @@ void MySQL_Cursor::free_row_buffer() {
   // clear the row
   for (int f = 0; f < MAX_FIELDS; f++) {
     if (row.values[f] != NULL) {
-      free(row.values[f]);
+      mysql_free(row.values[f]);
     }
     row.values[f] = NULL;
   }
@@ -377,21 +927,26 @@ void MySQL_Cursor::free_row_buffer() {
 
   offset[in]      offset from start of buffer
 
-  Returns string - String from the buffer
+  Returns string - String from the buffer, NULL if out of memory
 */
 char *MySQL_Cursor::read_string(int *offset) {
   char *str;
-  int len_bytes = conn->get_lcb_len(conn->buffer[*offset]);
-  int len = conn->read_int(*offset, len_bytes);
-  if (len == 251) {
+  int len_bytes = conn->get_lcb_len(*offset);
+  int len = conn->read_lcb_int(*offset);
+  // A NULL is the single byte 0xfb, not a value of length 251
+  boolean is_null = conn->buffer[*offset] == 0xfb;
+  str = (char *)mysql_malloc(is_null ? 5 : len+1, MYSQL_ALLOC_READ_STRING);
+  if (str == NULL) {
+    conn->set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+    return NULL;
+  }
+  if (is_null) {
     // This is a null field.
-    str = (char *)malloc(5);
     strncpy(str, "NULL", 4);
     str[4] = 0x00;
     *offset += len_bytes;
   } else {
-    str = (char *)malloc(len+1);
-    strncpy(str, (char *)&conn->buffer[*offset+len_bytes], len);
+    memcpy(str, &conn->buffer[*offset+len_bytes], len);
     str[len] = 0x00;
     *offset += len_bytes+len;
   }
@@ -399,6 +954,19 @@ char *MySQL_Cursor::read_string(int *offset) {
 }
 
 
+/*
+  skip_value - Skip a length coded string in the buffer
+
+  offset[in/out]  offset of the value, moved past it
+*/
+void MySQL_Cursor::skip_value(int *offset) {
+  int len_bytes = conn->get_lcb_len(*offset);
+  if (conn->buffer[*offset] != 0xfb)  // NULL values have no data
+    *offset += conn->read_lcb_int(*offset);
+  *offset += len_bytes;
+}
+
+
 /*
   get_field - Read a field from the server
 
@@ -423,30 +991,139 @@ char *MySQL_Cursor::read_string(int *offset) {
   n (Length Coded Binary)    default
 
   Note: the sum of all db, column, and field names must be < 255 in length
+
+  The field and its strings are stored in the metadata arena (see
+  meta_alloc()).
+
+  Returns field_struct * - the field, NULL at the EOF packet or when
+                           out of memory
 */
-int MySQL_Cursor::get_field(field_struct *fs) {
-  int len_bytes;
-  int len;
-  int offset;
+field_struct *MySQL_Cursor::get_field() {
+  int offset = 4;
+  int db;
+  int table;
+  int name;
+  field_struct *fs;
+  char *text;
 
   // Read field packets until EOF
   conn->read_packet();
-  if (conn->buffer && conn->buffer[4] != MYSQL_EOF_PACKET) {
-    // calculate location of db
-    len_bytes = conn->get_lcb_len(4);
-    len = conn->read_int(4, len_bytes);
-    offset = 4+len_bytes+len;
-    fs->db = read_string(&offset);
-    // get table
-    fs->table = read_string(&offset);
-    // calculate location of name
-    len_bytes = conn->get_lcb_len(offset);
-    len = conn->read_int(offset, len_bytes);
-    offset += len_bytes+len;
-    fs->name = read_string(&offset);
-    return 0;
+  if (conn->buffer == NULL || conn->buffer[4] == MYSQL_EOF_PACKET)
+    return NULL;
+  skip_value(&offset);    // catalog
+  db = offset;
+  skip_value(&offset);
+  table = offset;
+  skip_value(&offset);
+  skip_value(&offset);    // org_table
+  name = offset;
+  skip_value(&offset);
+  // skip org_name, filler, charsetnr and length to get the type
+  skip_value(&offset);
+
+  // One block for the field and its strings
+  fs = (field_struct *)meta_alloc(sizeof(field_struct) + string_size(db) +
+                                  string_size(table) + string_size(name));
+  if (fs == NULL)
+    return NULL;
+  text = (char *)(fs + 1);
+  fs->db = text;
+  text = copy_string(db, text);
+  fs->table = text;
+  text = copy_string(table, text);
+  fs->name = text;
+  copy_string(name, text);
+  fs->type = conn->buffer[offset+7];
+  return fs;
+}
+
+
+/*
+  string_size - Get the memory a length coded string needs as a C string
+
+  offset[in]      offset of the string in the buffer
+
+  Returns integer - bytes including the terminator ("NULL" for NULL)
+*/
+int MySQL_Cursor::string_size(int offset) {
+  if (conn->buffer[offset] == 0xfb)
+    return 5;
+  return conn->read_lcb_int(offset) + 1;
+}
+
+
+/*
+  copy_string - Copy a length coded string as a C string
+
+  offset[in]      offset of the string in the buffer
+  dest[out]       where to copy it (string_size() bytes)
+
+  Returns char * - the byte after the terminator
+*/
+char *MySQL_Cursor::copy_string(int offset, char *dest) {
+  int len;
+
+  if (conn->buffer[offset] == 0xfb) {
+    memcpy(dest, "NULL", 5);
+    return dest + 5;
   }
-  return MYSQL_EOF_PACKET;
+  len = conn->read_lcb_int(offset);
+  memcpy(dest, &conn->buffer[offset + conn->get_lcb_len(offset)], len);
+  dest[len] = 0x00;
+  return dest + len + 1;
+}
+
+
+/*
+  meta_alloc - Take memory for column metadata from the arena
+
+  The column definitions of a result set are stored one after the other
+  in a single block that is kept for the next result set, so a cursor
+  running the same queries allocates no metadata once the block is large
+  enough. When it must grow the fields already stored are moved with it.
+  free_columns_buffer() empties the arena and close() frees it.
+
+  size[in]        bytes needed
+
+  Returns void * - the memory or NULL
+*/
+void *MySQL_Cursor::meta_alloc(int size) {
+  void *block;
+
+  // Keep the next field_struct aligned
+  size = (size + sizeof(void *) - 1) & ~(int)(sizeof(void *) - 1);
+  if (meta_used + size > meta_size) {
+    int grown = meta_size ? meta_size * 2 :
+                (num_cols > 0 ? num_cols : 1) * MYSQL_META_PER_FIELD;
+    uintptr_t old_base = (uintptr_t)meta_arena;
+    byte *arena;
+
+    if (grown < meta_used + size)
+      grown = meta_used + size;
+    arena = (byte *)mysql_realloc(meta_arena, grown, MYSQL_ALLOC_GET_FIELDS);
+    if (arena == NULL) {
+      conn->set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+      return NULL;
+    }
+    if (arena != meta_arena) {
+      // Point the fields already stored into the new block
+      for (int f = 0; f < MAX_FIELDS; f++) {
+        field_struct *fs = columns.fields[f];
+        if (fs == NULL)
+          continue;
+        fs = (field_struct *)(arena + ((uintptr_t)fs - old_base));
+        fs->db = (char *)(arena + ((uintptr_t)fs->db - old_base));
+        fs->table = (char *)(arena + ((uintptr_t)fs->table - old_base));
+        fs->name = (char *)(arena + ((uintptr_t)fs->name - old_base));
+        columns.fields[f] = fs;
+      }
+    }
+    meta_arena = arena;
+    meta_size = grown;
+  }
+  block = meta_arena + meta_used;
+  meta_used += size;
+  return block;
 }
 
 
@@ -470,12 +1147,114 @@ int MySQL_Cursor::get_field(field_struct *fs) {
 int MySQL_Cursor::get_row() {
   // Read row packets
   conn->read_packet();
-  if (conn->buffer && conn->buffer[4] != MYSQL_EOF_PACKET)
+  if (conn->buffer && !conn->is_eof_packet())
     return 0;
+  if (conn->buffer == NULL &&
+      conn->get_error_code() == MYSQL_CR_OUT_OF_MEMORY) {
+    drop_result(0);
+    return MYSQL_EOF_PACKET;
+  }
+  return end_rows();
+}
+
+
+/*
+  drop_result - Skip the rest of a result set after running out of memory
+
+  The packets left are read without keeping them, so the connection
+  stays in step with the server and can run the next query. The out of
+  memory error is kept for the sketch.
+
+  packets[in]     column definitions (and their EOF packet) still to be
+                  read before the rows
+*/
+void MySQL_Cursor::drop_result(int packets) {
+  unsigned long skipped = 0;
+
+  while (packets-- > 0 && conn->skip_packet() >= 0)
+    ;
+  set_result_state(MYSQL_RESULT_ROWS);
+  skip_result(0, &skipped);
+  conn->set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+}
+
+
+/*
+  end_rows - Finish the result set at its EOF packet (or a failed read)
+
+  Returns integer - MYSQL_EOF_PACKET
+*/
+int MySQL_Cursor::end_rows() {
+  // The status tells if more results follow
+  more_results_exist = (conn->parse_server_status() &
+                        MYSQL_SERVER_MORE_RESULTS_EXISTS) != 0;
+  set_result_state(MYSQL_RESULT_NONE);
+  end_cache_capture(conn->buffer != NULL && !more_results_exist);
   return MYSQL_EOF_PACKET;
 }
 
 
+/*
+  skip_result - Skip the rest of the current result set
+
+  Column definitions and rows are read with skip_packet(), so only the
+  EOF or Error packet ending the result set is kept.
+
+  max_bytes[in]   bytes to skip before closing the connection, 0 = no limit
+  skipped[in/out] bytes skipped so far
+
+  Returns boolean - True = result set consumed (or none pending)
+                    False = error, timeout or the connection was closed
+*/
+boolean MySQL_Cursor::skip_result(unsigned long max_bytes,
+                                  unsigned long *skipped) {
+  int fields = 0;
+  int type;
+
+  free_columns_buffer();
+  free_row_buffer();
+  if (result_state == MYSQL_RESULT_COLUMNS && conn->buffer) {
+    // Column definitions and (without CLIENT_DEPRECATE_EOF) an EOF packet
+    fields = conn->buffer[4];   // From result header packet
+    if (!conn->eof_deprecated())
+      fields++;
+  }
+
+  while (result_state != MYSQL_RESULT_NONE) {
+    if (result_state == MYSQL_RESULT_COLUMNS && fields <= 0) {
+      set_result_state(MYSQL_RESULT_ROWS);
+      continue;
+    }
+    if (max_bytes > 0 && *skipped > max_bytes) {
+      end_cache_capture(false);
+      conn->close();
+      type = -1;
+    } else {
+      type = conn->skip_packet();
+      *skipped += conn->packet_len + 4;
+    }
+    if (type < 0 || type == MYSQL_ERROR_PACKET) {
+      if (type == MYSQL_ERROR_PACKET)
+        conn->parse_error_packet();
+      end_cache_capture(false);
+      more_results_exist = false;
+      set_result_state(MYSQL_RESULT_NONE);
+      return false;
+    }
+    if (result_state == MYSQL_RESULT_COLUMNS) {
+      fields--;
+    } else if (type == MYSQL_EOF_PACKET && conn->is_eof_packet()) {
+      // End of the result set, the status tells if more results follow
+      more_results_exist = (conn->parse_server_status() &
+                            MYSQL_SERVER_MORE_RESULTS_EXISTS) != 0;
+      set_result_state(MYSQL_RESULT_NONE);
+      end_cache_capture(!more_results_exist);
+    }
+  }
+  return true;
+}
+
+
 /*
   get_fields - reads the fields from the read buffer
 
@@ -486,7 +1265,6 @@ int MySQL_Cursor::get_row() {
 boolean MySQL_Cursor::get_fields()
 {
   int num_fields = 0;
-  int res = 0;
 
   if (conn->buffer == NULL) {
     return false;
@@ -495,15 +1273,19 @@ boolean MySQL_Cursor::get_fields()
   columns.num_fields = num_fields;
   num_cols = num_fields; // Save this for later use
   for (int f = 0; f < num_fields; f++) {
-    field_struct *field = (field_struct *)malloc(sizeof(field_struct));
-    res = get_field(field);
-    if (res == MYSQL_EOF_PACKET) {
-      conn->show_error(BAD_MOJO, true);
+    field_struct *field = get_field();
+    if (field == NULL) {
+      if (conn->get_error_code() == MYSQL_CR_OUT_OF_MEMORY)
+        drop_result(num_fields - f - 1 + (conn->eof_deprecated() ? 0 : 1));
+      else if (conn->buffer)   // EOF packet before the last column
+        conn->set_error(MYSQL_CR_MALFORMED_PACKET, BAD_MOJO);
       return false;
     }
     columns.fields[f] = field;
   }
-  conn->read_packet(); // EOF packet
+  // The EOF packet after the columns is not sent with CLIENT_DEPRECATE_EOF
+  if (!conn->eof_deprecated())
+    conn->read_packet();
   return true;
 }
 
@@ -521,8 +1303,8 @@ int MySQL_Cursor::get_row_values() {
 
   // It is an error to try to read rows before columns
   // are read.
-  if (!columns_read) {
-    conn->show_error(READ_COLS, true);
+  if (result_state != MYSQL_RESULT_ROWS) {
+    conn->set_error(MYSQL_CR_COMMANDS_OUT_OF_SYNC, READ_COLS);
     return MYSQL_EOF_PACKET;
   }
   // Drop any row data already read
@@ -533,10 +1315,338 @@ int MySQL_Cursor::get_row_values() {
   if (res != MYSQL_EOF_PACKET) {
     offset = 4;
     for (int f = 0; f < num_cols; f++) {
+      if (!column_selected(f)) {
+        skip_value(&offset);
+        continue;
+      }
       row.values[f] = read_string(&offset);
+      if (row.values[f] == NULL) {
+        drop_result(0);
+        return MYSQL_EOF_PACKET;
+      }
     }
   }
   return res;
 }
 
+
+/*
+  fetch_mapped - Decode the next row into a struct
+
+  This method is used by fetch_into() (see MySQL_Row_Map.h). The column
+  map is checked against the result set metadata once per result set.
+  Each row is then decoded straight from the packet buffer without
+  allocating strings for the values.
+
+  object[in]      struct to fill
+  map[in]         column map of the struct
+  count[in]       number of entries in the map
+
+  Returns boolean - True = a row was decoded,
+                    False = no more rows or the map does not match
+*/
+boolean MySQL_Cursor::fetch_mapped(void *object, const mysql_column_map *map,
+                                   int count) {
+  int offset;
+  int len_bytes;
+  int len;
+
+  if (result_state == MYSQL_RESULT_COLUMNS)
+    get_columns();
+  if (result_state != MYSQL_RESULT_ROWS)
+    return false;
+  if (map != bound_map && !bind_map(map, count))
+    return false;
+
+  if (get_row() == MYSQL_EOF_PACKET)
+    return false;
+
+  offset = 4;
+  for (int f = 0; f < num_cols; f++) {
+    if (bind_target[f]) {
+      const mysql_column_map *column = &map[bind_target[f]-1];
+      len_bytes = conn->get_lcb_len(offset);
+      len = conn->read_lcb_int(offset);
+      if (conn->buffer[offset] == 0xfb)  // NULL value
+        column->decode(object, NULL, 0);
+      else
+        column->decode(object, (char *)&conn->buffer[offset+len_bytes], len);
+    }
+    skip_value(&offset);
+  }
+  return true;
+}
+
+
+/*
+  bind_map - Check a column map against the result set metadata
+
+  Resolves the column names of the map to column indexes and checks that
+  each member can hold the values of its column. A column may be mapped
+  to one member only.
+
+  map[in]         column map of the struct
+  count[in]       number of entries in the map
+
+  Returns boolean - True = map matches the columns
+*/
+boolean MySQL_Cursor::bind_map(const mysql_column_map *map, int count) {
+  for (int f = 0; f < MAX_FIELDS; f++)
+    bind_target[f] = 0;
+  bound_map = NULL;
+
+  for (int m = 0; m < count; m++) {
+    int index = find_column(map[m].name, map[m].index, map[m].kind);
+    if (index < 0)
+      return false;
+    bind_target[index] = m + 1;
+  }
+  bound_map = map;
+  return true;
+}
+
+
+/*
+  find_column - Find the column of a map entry in the result set
+
+  Resolves a column name to its index and checks that the column can be
+  decoded as kind and is not mapped yet (see bind_target).
+
+  name[in]        column name or NULL to use index
+  index[in]       column index if name is NULL
+  kind[in]        MYSQL_KIND_* of the destination
+
+  Returns integer - column index, -1 = no such column or wrong kind
+*/
+int MySQL_Cursor::find_column(const char *name, int index, byte kind) {
+  if (name) {
+    index = -1;
+    for (int f = 0; f < num_cols; f++) {
+      if (strcmp(columns.fields[f]->name, name) == 0) {
+        index = f;
+        break;
+      }
+    }
+  }
+  if (index < 0 || index >= num_cols || bind_target[index]) {
+    conn->set_error(MYSQL_CR_UNKNOWN_ERROR, BAD_MAP);
+    return -1;
+  }
+
+  byte type = columns.fields[index]->type;
+  boolean is_int = type == MYSQL_TYPE_TINY || type == MYSQL_TYPE_SHORT ||
+                   type == MYSQL_TYPE_LONG || type == MYSQL_TYPE_LONGLONG ||
+                   type == MYSQL_TYPE_INT24 || type == MYSQL_TYPE_YEAR;
+  boolean is_real = is_int || type == MYSQL_TYPE_FLOAT ||
+                    type == MYSQL_TYPE_DOUBLE ||
+                    type == MYSQL_TYPE_DECIMAL ||
+                    type == MYSQL_TYPE_NEWDECIMAL;
+  if ((kind == MYSQL_KIND_INT && !is_int) ||
+      (kind == MYSQL_KIND_REAL && !is_real)) {
+    conn->set_error(MYSQL_CR_UNKNOWN_ERROR, BAD_MAP);
+    return -1;
+  }
+  return index;
+}
+
+
+/*
+  fetch_all - Decode the rows of a result set into column arrays
+
+  Each entry of arrays names a column (or its index) and the type of its
+  array: MYSQL_ARRAY_INT32 (int32_t), MYSQL_ARRAY_FLOAT (float) or
+  MYSQL_ARRAY_STRING (width chars per row, null terminated and cut to
+  fit). Up to max_rows rows are decoded straight from the packets, one
+  value per array per row, so a column is scanned as a plain array.
+  SQL NULL is decoded as 0 or an empty string.
+
+  An entry with array set is filled in the caller's array (max_rows
+  values). The others are laid out one after the other in block, and
+  fewer rows are read if block is too small for max_rows; without a
+  block they are laid out in one block of the cursor, kept for the next
+  call and freed by close(). data of each entry is set to its values.
+
+  The rest of the result set is left for the next call, so a large
+  result can be processed max_rows at a time; has_result_set() tells
+  if rows are left (discard_results() drops them).
+
+  arrays[in/out]  column arrays
+  count[in]       number of entries in arrays
+  max_rows[in]    rows to decode at most
+  block[in]       (optional) memory for the arrays not given
+  block_size[in]  size of block in bytes
+
+  Returns integer - rows decoded, 0 = no more rows,
+                    -1 = the arrays do not match the columns or no memory
+*/
+int MySQL_Cursor::fetch_all(mysql_column_array *arrays, int count,
+                            int max_rows, void *block, size_t block_size) {
+  size_t row_size = 0;
+  size_t slack = (count + 1) * 3;   // for aligning the arrays
+  size_t used;
+  byte *base = (byte *)block;
+  int rows = max_rows;
+  int offset;
+  int len_bytes;
+  int len;
+  int r;
+
+  if (result_state == MYSQL_RESULT_COLUMNS)
+    get_columns();
+  if (result_state != MYSQL_RESULT_ROWS || max_rows <= 0)
+    return 0;
+
+  // Find the columns (bind_target is shared with fetch_into())
+  bound_map = NULL;
+  for (int f = 0; f < MAX_FIELDS; f++)
+    bind_target[f] = 0;
+  for (int a = 0; a < count; a++) {
+    mysql_column_array *array = &arrays[a];
+    int index = find_column(array->name, array->index, array->type);
+    if (index < 0)
+      return -1;
+    if (array->type != MYSQL_ARRAY_STRING) {
+      array->width = 4;     // int32_t and float
+    } else if (array->width < 1) {
+      conn->set_error(MYSQL_CR_UNKNOWN_ERROR, BAD_MAP);
+      return -1;
+    }
+    bind_target[index] = a + 1;
+    if (array->array == NULL)
+      row_size += array->width;
+  }
+
+  // Lay out the arrays not given, each aligned for int32_t and float
+  if (row_size > 0 && block == NULL) {
+    size_t need = row_size * max_rows + slack;
+    if (need > fetch_size) {
+      byte *grown = (byte *)mysql_realloc(fetch_block, need,
+                                          MYSQL_ALLOC_FETCH_ALL);
+      if (grown == NULL) {
+        conn->set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+        return -1;
+      }
+      fetch_block = grown;
+      fetch_size = need;
+    }
+    base = fetch_block;
+  } else if (row_size > 0 && block_size < row_size * max_rows + slack) {
+    rows = block_size > slack ? (block_size - slack) / row_size : 0;
+    if (rows == 0) {
+      conn->set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+      return -1;
+    }
+  }
+  used = (4 - ((uintptr_t)base & 3)) & 3;
+  for (int a = 0; a < count; a++) {
+    if (arrays[a].array) {
+      arrays[a].data = arrays[a].array;
+    } else {
+      arrays[a].data = base + used;
+      used += ((size_t)arrays[a].width * rows + 3) & ~(size_t)3;
+    }
+  }
+
+  // Decode the rows straight from the packets
+  for (r = 0; r < rows && get_row() != MYSQL_EOF_PACKET; r++) {
+    offset = 4;
+    for (int f = 0; f < num_cols; f++) {
+      if (bind_target[f]) {
+        mysql_column_array *array = &arrays[bind_target[f]-1];
+        const char *value = NULL;
+        len_bytes = conn->get_lcb_len(offset);
+        len = 0;
+        if (conn->buffer[offset] != 0xfb) {   // not a NULL value
+          len = conn->read_lcb_int(offset);
+          value = (char *)&conn->buffer[offset+len_bytes];
+        }
+        if (array->type == MYSQL_ARRAY_INT32) {
+          ((int32_t *)array->data)[r] =
+            value ? (int32_t)mysql_parse_long(value, len) : 0;
+        } else if (array->type == MYSQL_ARRAY_FLOAT) {
+          ((float *)array->data)[r] =
+            value ? (float)mysql_parse_double(value, len) : 0;
+        } else {
+          char *dest = (char *)array->data + (size_t)r * array->width;
+          if (len > array->width - 1)
+            len = array->width - 1;
+          if (len > 0)
+            memcpy(dest, value, len);
+          dest[len] = 0x00;
+        }
+      }
+      skip_value(&offset);
+    }
+  }
+  return r;
+}
+
 #endif  // WITH_SELECT
+
+
+/*
+  mysql_parse_long - Convert a text protocol value to an integer
+
+  value[in]       digits (not null terminated)
+  len[in]         number of characters
+
+  Returns long - the value
+*/
+long mysql_parse_long(const char *value, int len) {
+  long result = 0;
+  boolean negative = false;
+  int i = 0;
+
+  if (len > 0 && (value[0] == '-' || value[0] == '+')) {
+    negative = value[0] == '-';
+    i++;
+  }
+  for (; i < len && value[i] >= '0' && value[i] <= '9'; i++)
+    result = result * 10 + (value[i] - '0');
+  return negative ? -result : result;
+}
+
+
+/*
+  mysql_parse_longlong - Convert a text protocol value to a 64 bit integer
+
+  The digits are accumulated unsigned, so a BIGINT UNSIGNED value is
+  kept when the result is cast to unsigned long long.
+
+  value[in]       digits (not null terminated)
+  len[in]         number of characters
+
+  Returns long long - the value
+*/
+long long mysql_parse_longlong(const char *value, int len) {
+  unsigned long long result = 0;
+  boolean negative = false;
+  int i = 0;
+
+  if (len > 0 && (value[0] == '-' || value[0] == '+')) {
+    negative = value[0] == '-';
+    i++;
+  }
+  for (; i < len && value[i] >= '0' && value[i] <= '9'; i++)
+    result = result * 10 + (value[i] - '0');
+  return (long long)(negative ? 0 - result : result);
+}
+
+
+/*
+  mysql_parse_double - Convert a text protocol value to a double
+
+  value[in]       number (not null terminated)
+  len[in]         number of characters
+
+  Returns double - the value
+*/
+double mysql_parse_double(const char *value, int len) {
+  char local[32];
+
+  if (len > 31)
+    len = 31;
+  memcpy(local, value, len);
+  local[len] = 0x00;
+  return atof(local);
+}
@@ -42,12 +42,40 @@
                              // Reduces memory footprint of the library.
 #define MAX_FIELDS    0x20   // Maximum number of fields. Reduce to save memory. Default=32
 
+// Bytes sent per packet when streaming a LOCAL INFILE
+#ifndef MYSQL_INFILE_CHUNK
+  #if defined(__AVR__)
+    #define MYSQL_INFILE_CHUNK 128
+  #else
+    #define MYSQL_INFILE_CHUNK 1024
+  #endif
+#endif
+
+// Bytes of the column metadata arena first allocated per column (a field
+// and its db, table and name); it grows when the names are longer
+#ifndef MYSQL_META_PER_FIELD
+  #if defined(__AVR__)
+    #define MYSQL_META_PER_FIELD 32
+  #else
+    #define MYSQL_META_PER_FIELD 64
+  #endif
+#endif
+
+// Result states of the cursor
+#define MYSQL_RESULT_NONE     0   // no result set pending (Ok packet)
+#define MYSQL_RESULT_COLUMNS  1   // result set header read, columns next
+#define MYSQL_RESULT_ROWS     2   // columns read, rows next
+
 #ifdef WITH_SELECT
+#include <MySQL_Row_Map.h>
+#include <MySQL_Cache.h>
+
 // Structure for retrieving a field (minimal implementation).
 typedef struct {
   char *db;
   char *table;
   char *name;
+  byte type;          // column type (MYSQL_TYPE_* of the server)
 } field_struct;
 
 // Structure for storing result set metadata.
@@ -60,6 +88,25 @@ typedef struct {
 typedef struct {
   char *values[MAX_FIELDS];
 } row_values;
+
+// Type of a column array of fetch_all()
+#define MYSQL_ARRAY_INT32   MYSQL_KIND_INT     // int32_t per row
+#define MYSQL_ARRAY_FLOAT   MYSQL_KIND_REAL    // float per row
+#define MYSQL_ARRAY_STRING  MYSQL_KIND_STRING  // width chars per row
+
+// Structure for one column array of fetch_all().
+typedef struct {
+  const char *name;   // column name or NULL to use index
+  int index;          // column index if name is NULL
+  byte type;          // MYSQL_ARRAY_*
+  int width;          // chars per string, terminator included
+  void *array;        // (optional) array of max_rows values to fill
+  void *data;         // set by fetch_all(): the values of the rows read
+} mysql_column_array;
+
+// Returned by next_value() instead of a length
+#define MYSQL_VALUE_NULL   -1   // the value is NULL
+#define MYSQL_VALUE_NONE   -2   // no more values in the row (or an error)
 #endif  // WITH_SELECT
 
 class MySQL_Cursor {
@@ -67,30 +114,77 @@ class MySQL_Cursor {
     MySQL_Cursor(MySQL_Connection *connection);
     ~MySQL_Cursor();
     boolean execute(const char *query, boolean progmem=false);
+    int execute_batch(const char *queries[], int count,
+                      boolean progmem=false);
+    void set_infile_source(Stream *source, long length=-1) {
+      infile = source;
+      infile_left = length;
+    }
 
   private:
+    int build_query(const char *query, boolean progmem);
+    void send_query(int query_len);
     boolean execute_query(int query_len);
+    boolean query_response();
+    boolean send_local_file();
 
 #ifdef WITH_SELECT
   public:
     void close();
     column_names *get_columns();
     row_values *get_next_row();
+    boolean open_row();
+    long next_value();
+    int read_value(byte *dest, int size);
     void show_results();
     int get_rows_affected() { return rows_affected; }
     int get_last_insert_id() { return last_insert_id; }
+    boolean next_result();
+    boolean discard_results(unsigned long max_bytes=0);
+    boolean more_results() { return more_results_exist; }
+    boolean has_result_set() { return result_state != MYSQL_RESULT_NONE; }
+    void set_cache(MySQL_Cache *result_cache, unsigned long ttl_ms=0);
+    void set_columns(const int *indexes, int count);
+    void set_all_columns();
+    boolean column_selected(int index) {
+      return (column_mask[index >> 3] >> (index & 7)) & 1;
+    }
+    template <typename S> boolean fetch_into(S &object) {
+      int count = 0;
+      const mysql_column_map *map = MySQL_Row_Map<S>::columns(&count);
+      return fetch_mapped(&object, map, count);
+    }
+    int fetch_all(mysql_column_array *arrays, int count, int max_rows,
+                  void *block=NULL, size_t block_size=0);
 
   private:
     void free_columns_buffer();
     void free_row_buffer();
     bool clear_ok_packet();
+    void set_result_state(int state) {
+      result_state = state;
+      conn->set_result_pending(state != MYSQL_RESULT_NONE);
+    }
 
     char *read_string(int *offset);
-    int get_field(field_struct *fs);
+    void skip_value(int *offset);
+    boolean skip_result(unsigned long max_bytes, unsigned long *skipped);
+    field_struct *get_field();
+    int string_size(int offset);
+    char *copy_string(int offset, char *dest);
+    void *meta_alloc(int size);
     int get_row();
+    int end_rows();
+    void drop_result(int packets);
+    long close_row();
     boolean get_fields();
     int get_row_values();
     column_names *query_result();
+    void end_cache_capture(boolean keep);
+    boolean bind_map(const mysql_column_map *map, int count);
+    int find_column(const char *name, int index, byte kind);
+    boolean fetch_mapped(void *object, const mysql_column_map *map,
+                         int count);
     
     boolean columns_read;
     int num_cols;
@@ -98,9 +192,30 @@ class MySQL_Cursor {
     row_values row;
     int rows_affected;
     int last_insert_id;
+    int result_state;
+    boolean more_results_exist;
+    const mysql_column_map *bound_map;  // map checked against the columns
+    byte bind_target[MAX_FIELDS];       // map entry + 1 per column, 0 = skip
+    byte column_mask[(MAX_FIELDS+7)/8]; // columns decoded by get_next_row()
+    MySQL_Cache *cache;                 // result cache (optional)
+    unsigned long cache_ttl;            // time to live of stored results
+    char *capture_query;                // query of the result being captured
+    int value_column;                   // next column of the open row,
+                                        // -1 = no row open (open_row())
+    int value_lead;                     // first byte of the open row
+    long value_left;                    // unread bytes of the value
+    byte *meta_arena;                   // column definitions of the result
+    int meta_size;                      // size of meta_arena
+    int meta_used;                      // bytes of meta_arena in use
+    byte *fetch_block;                  // column arrays of fetch_all()
+    size_t fetch_size;                  // size of fetch_block
 #endif
 
     MySQL_Connection *conn;
+    Stream *infile;         // data for the next LOCAL INFILE request
+    long infile_left;       // bytes of it still to send, -1 = unknown
+
+    friend class MySQL_Bench;   // extras/host/micro_bench
 };
 
 #endif
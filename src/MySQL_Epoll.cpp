@@ -0,0 +1,238 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Epoll.cpp - Many connections on one epoll loop (Linux host builds)
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#include <MySQL_Epoll.h>
+
+#ifdef MYSQL_EPOLL
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#define TASK_READY     1
+#define TASK_WAITING   2
+#define TASK_DONE      3
+
+/*
+  Constructor
+
+  max_tasks[in]   most tasks that can be added
+*/
+MySQL_Epoll::MySQL_Epoll(int max_tasks) {
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  slots = (mysql_epoll_slot *)calloc(max_tasks, sizeof(mysql_epoll_slot));
+  ready = (int *)malloc(max_tasks * sizeof(int));
+  size = (slots && ready) ? max_tasks : 0;
+  ready_head = 0;
+  ready_len = 0;
+  count = 0;
+  live = 0;
+  current = -1;
+  polls = 0;
+  wakeups = 0;
+  switches = 0;
+}
+
+
+/*
+  Destructor
+*/
+MySQL_Epoll::~MySQL_Epoll() {
+  for (int i = 0; i < count; i++)
+    free(slots[i].stack);
+  free(slots);
+  free(ready);
+  if (epoll_fd >= 0)
+    close(epoll_fd);
+}
+
+
+/*
+  add - Add a task using a connection
+
+  The task starts on the next run(). The connection and its client wait
+  through the driver until the task returns.
+
+  conn[in]        connection the task uses
+  client[in]      the connection's client
+  task[in]        function to run
+  arg[in]         passed to the task
+
+  Returns boolean - True if the task was added
+*/
+boolean MySQL_Epoll::add(MySQL_Connection *conn, MySQL_Posix_Client *client,
+                         mysql_epoll_task task, void *arg) {
+  mysql_epoll_slot *slot;
+  uintptr_t self = (uintptr_t)this;
+
+  if (epoll_fd < 0 || count >= size)
+    return false;
+  slot = &slots[count];
+  slot->stack = (byte *)malloc(MYSQL_EPOLL_STACK);
+  if (slot->stack == NULL)
+    return false;
+  getcontext(&slot->context);
+  slot->context.uc_stack.ss_sp = slot->stack;
+  slot->context.uc_stack.ss_size = MYSQL_EPOLL_STACK;
+  slot->context.uc_link = &loop;
+  // makecontext() passes int arguments, so the pointer goes in two halves
+  makecontext(&slot->context, (void (*)())start, 2,
+              (unsigned int)((uint64_t)self >> 32), (unsigned int)self);
+  slot->conn = conn;
+  slot->client = client;
+  slot->run = task;
+  slot->arg = arg;
+  conn->set_wait(this);
+  client->set_wait(this);
+  make_ready(count);
+  count++;
+  live++;
+  return true;
+}
+
+
+/*
+  run - Run the tasks until all of them have returned
+
+  Returns integer - number of tasks run
+*/
+int MySQL_Epoll::run() {
+  struct epoll_event events[MYSQL_EPOLL_EVENTS];
+
+  while (live > 0) {
+    // Run every task that can run, each until it waits or returns
+    while (ready_len > 0) {
+      current = ready[ready_head];
+      ready_head = (ready_head + 1) % size;
+      ready_len--;
+      switches++;
+      swapcontext(&loop, &slots[current].context);
+      if (slots[current].state == TASK_READY) {
+        // Returned (uc_link brought us back here)
+        slots[current].state = TASK_DONE;
+        slots[current].conn->set_wait(NULL);
+        slots[current].client->set_wait(NULL);
+        live--;
+      }
+      current = -1;
+    }
+    if (live == 0)
+      break;
+
+    int num = epoll_wait(epoll_fd, events, MYSQL_EPOLL_EVENTS,
+                         next_timeout());
+    polls++;
+    for (int i = 0; i < num; i++) {
+      int index = (int)events[i].data.u32;
+      if (slots[index].state == TASK_WAITING) {
+        wakeups++;
+        make_ready(index);
+      }
+    }
+    // Wake the tasks whose wait is up
+    unsigned long now = millis();
+    for (int i = 0; i < count; i++) {
+      mysql_epoll_slot *slot = &slots[i];
+      if (slot->state == TASK_WAITING &&
+          now - slot->wait_start >= slot->wait_ms)
+        make_ready(i);
+    }
+  }
+  return count;
+}
+
+
+/*
+  wait - Let the other tasks run while this one waits
+
+  Called by the connector (MySQL_Wait). The task sleeps until its socket
+  is readable (or writable while bytes are pending) or ms have passed.
+  Outside a task it is the same as delay().
+
+  ms[in]          milliseconds to wait at most
+*/
+void MySQL_Epoll::wait(unsigned long ms) {
+  mysql_epoll_slot *slot;
+  int fd;
+
+  if (current < 0) {
+    delay(ms);
+    return;
+  }
+  slot = &slots[current];
+  fd = slot->client->get_fd();
+  if (fd >= 0) {
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    if (slot->client->pending() || slot->client->connecting())
+      event.events |= EPOLLOUT;
+    event.data.u64 = 0;
+    event.data.u32 = current;
+    // One-shot, so each wait arms the socket again
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) < 0 && errno == ENOENT)
+      epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+  }
+  slot->wait_start = millis();
+  slot->wait_ms = ms;
+  slot->state = TASK_WAITING;
+  swapcontext(&slot->context, &loop);
+}
+
+
+void MySQL_Epoll::start(unsigned int high, unsigned int low) {
+  MySQL_Epoll *self = (MySQL_Epoll *)(uintptr_t)(((uint64_t)high << 32) | low);
+  mysql_epoll_slot *slot = &self->slots[self->current];
+
+  slot->run(slot->conn, slot->arg);
+}
+
+
+void MySQL_Epoll::make_ready(int index) {
+  slots[index].state = TASK_READY;
+  ready[(ready_head + ready_len) % size] = index;
+  ready_len++;
+}
+
+
+/*
+  next_timeout - Get how long epoll_wait() may sleep
+
+  Returns integer - milliseconds until the first wait is up
+*/
+int MySQL_Epoll::next_timeout() {
+  unsigned long now = millis();
+  unsigned long shortest = MYSQL_TIMEOUT_MAX;
+
+  for (int i = 0; i < count; i++) {
+    mysql_epoll_slot *slot = &slots[i];
+    if (slot->state == TASK_WAITING) {
+      unsigned long passed = now - slot->wait_start;
+      unsigned long left = passed >= slot->wait_ms ? 0 :
+                           slot->wait_ms - passed;
+      if (left < shortest)
+        shortest = left;
+    }
+  }
+  return (int)shortest;
+}
+
+#endif  // MYSQL_EPOLL
@@ -0,0 +1,106 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Epoll.h - Many connections on one epoll loop (Linux host builds)
+
+  This header file defines a driver that runs hundreds of MySQL_Connection
+  instances in a single thread. Each connection is used by a task, a
+  function written against the usual blocking API (connect(), execute(),
+  get_next_row(), ...). Every task runs on its own small stack. When a
+  task waits for the server (MySQL_Wait) the driver switches to the next
+  task that can run and sleeps in epoll_wait() once none can. A task
+  resumes when its socket is readable or its wait is up, so the timeouts
+  of the connector work as before.
+
+  The connections must use a MySQL_Posix_Client. Tasks run one at a time
+  and only switch while waiting, so they need no locking.
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_EPOLL_H
+#define MYSQL_EPOLL_H
+
+#include <MySQL_Posix_Client.h>
+
+#if defined(MYSQL_POSIX) && defined(__linux__)
+  #define MYSQL_EPOLL
+#endif
+
+#ifdef MYSQL_EPOLL
+
+#include <MySQL_Connection.h>
+#include <ucontext.h>
+
+#ifndef MYSQL_EPOLL_STACK
+  #define MYSQL_EPOLL_STACK   65536   // stack of each task (bytes)
+#endif
+#define MYSQL_EPOLL_EVENTS    64      // events taken per epoll_wait()
+
+// A task: uses conn until it returns (arg is passed through)
+typedef void (*mysql_epoll_task)(MySQL_Connection *conn, void *arg);
+
+// Structure for one task of the driver.
+typedef struct {
+  ucontext_t context;
+  byte *stack;
+  MySQL_Connection *conn;
+  MySQL_Posix_Client *client;
+  mysql_epoll_task run;
+  void *arg;
+  unsigned long wait_start;   // millis() when the wait started
+  unsigned long wait_ms;      // length of the wait
+  byte state;
+} mysql_epoll_slot;
+
+class MySQL_Epoll : public MySQL_Wait {
+  public:
+    MySQL_Epoll(int max_tasks);
+    ~MySQL_Epoll();
+    boolean add(MySQL_Connection *conn, MySQL_Posix_Client *client,
+                mysql_epoll_task task, void *arg=NULL);
+    int run();
+    void wait(unsigned long ms);
+    int get_tasks() { return count; }
+    int get_running() { return live; }
+    unsigned long get_polls() { return polls; }
+    unsigned long get_wakeups() { return wakeups; }
+    unsigned long get_switches() { return switches; }
+
+  private:
+    static void start(unsigned int high, unsigned int low);
+    void make_ready(int index);
+    int next_timeout();
+
+    int epoll_fd;
+    mysql_epoll_slot *slots;
+    int *ready;               // queue of runnable tasks
+    int ready_head;
+    int ready_len;
+    int size;
+    int count;
+    int live;                 // tasks that have not returned
+    int current;              // running task, -1 = the loop
+    ucontext_t loop;
+    unsigned long polls;      // epoll_wait() calls
+    unsigned long wakeups;    // tasks woken by their socket
+    unsigned long switches;   // switches into a task
+};
+
+#endif  // MYSQL_EPOLL
+
+#endif
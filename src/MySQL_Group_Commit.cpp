@@ -0,0 +1,370 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Group_Commit.cpp - Group writes into timed transactions
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#include <MySQL_Group_Commit.h>
+
+#define COM_QUERY  0x03
+
+const char START_TRANSACTION[] PROGMEM = "START TRANSACTION";
+const char COMMIT[] PROGMEM = "COMMIT";
+const char ROLLBACK[] PROGMEM = "ROLLBACK";
+const char GROUP_ROLLED_BACK[] PROGMEM = "Group rolled back, statements lost: ";
+const char GROUP_ABANDONED[] PROGMEM =
+  "Group abandoned, outcome unknown for statements: ";
+
+// First words of the statements that are grouped
+const char WRITE_WORDS[][8] PROGMEM = {
+  "INSERT", "UPDATE", "DELETE", "REPLACE"
+};
+
+static boolean hook_route(MySQL_Group_Commit *group, const char *query,
+                          boolean progmem) {
+  return group->route(query, progmem);
+}
+
+static void hook_opened(MySQL_Group_Commit *group) {
+  group->opened();
+}
+
+static void hook_written(MySQL_Group_Commit *group, boolean ok) {
+  group->written(ok);
+}
+
+static boolean hook_commit(MySQL_Group_Commit *group) {
+  return group->commit();
+}
+
+static void hook_abandon(MySQL_Group_Commit *group) {
+  group->abandon();
+}
+
+const mysql_group_hooks mysql_group_commit_hooks = {
+  hook_route, hook_opened, hook_written, hook_commit, hook_abandon
+};
+
+/*
+  Constructor
+
+  max_statements[in]  writes per transaction
+  max_ms[in]          milliseconds a transaction stays open at most,
+                      0 = until max_statements
+*/
+MySQL_Group_Commit::MySQL_Group_Commit(int max_statements,
+                                       unsigned long max_ms) {
+  conn = NULL;
+  max_count = max_statements > 0 ? max_statements : 1;
+  max_time = max_ms;
+  open = false;
+  begin_queued = false;
+  count = 0;
+  started = 0;
+  sequence = 0;
+  failed = NULL;
+  failed_arg = NULL;
+  reset_stats();
+}
+
+
+/*
+  set_failed_handler - Set the function told about rolled back writes
+
+  handler[in]     function to call, NULL for none
+  arg[in]         passed to the function
+*/
+void MySQL_Group_Commit::set_failed_handler(mysql_group_failed handler,
+                                            void *arg) {
+  failed = handler;
+  failed_arg = arg;
+}
+
+
+/*
+  reset_stats - Reset the statistics
+*/
+void MySQL_Group_Commit::reset_stats() {
+  memset(&stats, 0, sizeof(stats));
+}
+
+
+/*
+  attach - Use the scheduler for a connection
+
+  Called by MySQL_Connection::set_group_commit().
+
+  connection[in]  connection to run the transactions on, NULL to detach
+*/
+void MySQL_Group_Commit::attach(MySQL_Connection *connection) {
+  conn = connection;
+  open = false;
+  begin_queued = false;
+  count = 0;
+}
+
+
+/*
+  commit - Commit the open group now
+
+  Returns boolean - True = committed (or no group open),
+                    False = the COMMIT failed and the group was lost
+*/
+boolean MySQL_Group_Commit::commit() {
+  unsigned long start;
+  unsigned long took;
+
+  if (!open || conn == NULL)
+    return true;
+  start = micros();
+  queue_command(COMMIT);
+  if (!command_reply()) {
+    rollback(conn->get_error_code());
+    return false;
+  }
+  took = micros() - start;
+  stats.commits++;
+  stats.committed += count;
+  stats.last_us = took;
+  stats.total_us += took;
+  if (took > stats.max_us)
+    stats.max_us = took;
+  stats.last_size = count;
+  if (count > stats.max_size)
+    stats.max_size = count;
+  open = false;
+  count = 0;
+  return true;
+}
+
+
+/*
+  poll - Commit the open group if its time is up
+
+  Call this from loop() between queries.
+
+  Returns boolean - False if a COMMIT failed
+*/
+boolean MySQL_Group_Commit::poll() {
+  if (open && max_time > 0 && millis() - started >= max_time)
+    return commit();
+  return true;
+}
+
+
+/*
+  is_write - Check if a statement is one that is grouped
+
+  query[in]       SQL statement
+  progmem[in]     True if the string is in program memory
+
+  Returns boolean - True for INSERT, UPDATE, DELETE and REPLACE
+*/
+boolean MySQL_Group_Commit::is_write(const char *query, boolean progmem) {
+  char word[8];
+
+  mysql_first_word(query, progmem, word, sizeof(word));
+  for (unsigned int i = 0; i < sizeof(WRITE_WORDS) / sizeof(WRITE_WORDS[0]);
+       i++) {
+    if (strcmp_P(word, WRITE_WORDS[i]) == 0)
+      return true;
+  }
+  return false;
+}
+
+
+/*
+  mysql_first_word - Get the first word of a SQL statement
+
+  The word is read in upper case after any blanks or parentheses and is
+  cut to fit.
+
+  query[in]       SQL statement
+  progmem[in]     True if the string is in program memory
+  word[out]       the word
+  size[in]        size of word (terminator included)
+
+  Returns const char * - the rest of the statement after the word
+*/
+const char *mysql_first_word(const char *query, boolean progmem, char *word,
+                             int size) {
+  int len = 0;
+  char c;
+
+  for (;; query++) {
+    c = progmem ? pgm_read_byte_near(query) : *query;
+    if (c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != '(')
+      break;
+  }
+  for (;; query++) {
+    c = progmem ? pgm_read_byte_near(query) : *query;
+    if (c >= 'a' && c <= 'z')
+      c -= 'a' - 'A';
+    if (c < 'A' || c > 'Z')
+      break;
+    if (len < size - 1)
+      word[len++] = c;
+  }
+  word[len] = 0x00;
+  return query;
+}
+
+
+/*
+  route - Decide if a statement goes into the group
+
+  Called by MySQL_Cursor::execute() before it sends the statement. When
+  it is the first write of a group START TRANSACTION is queued to go out
+  with it; opened() reads its reply.
+
+  query[in]       SQL statement
+  progmem[in]     True if the string is in program memory
+
+  Returns boolean - True = the statement is part of the group
+*/
+boolean MySQL_Group_Commit::route(const char *query, boolean progmem) {
+  if (conn == NULL || !is_write(query, progmem))
+    return false;
+  if (!open) {
+    queue_command(START_TRANSACTION);
+    begin_queued = true;
+  }
+  return true;
+}
+
+
+/*
+  opened - Read the reply to START TRANSACTION if one was queued
+
+  Called by MySQL_Cursor::execute() after sending the statement. If the
+  transaction could not be started the statement runs on its own.
+*/
+void MySQL_Group_Commit::opened() {
+  if (!begin_queued)
+    return;
+  begin_queued = false;
+  if (command_reply()) {
+    open = true;
+    started = millis();
+  }
+}
+
+
+/*
+  written - Account for a grouped statement once it was answered
+
+  Commits the group when it is full or its time is up, rolls it back
+  when the statement failed.
+
+  ok[in]          True if the statement succeeded
+*/
+void MySQL_Group_Commit::written(boolean ok) {
+  if (!open)
+    return;
+  sequence++;
+  count++;
+  stats.statements++;
+  if (!ok) {
+    rollback(conn->get_error_code());
+    return;
+  }
+  if (count >= max_count || (max_time > 0 && millis() - started >= max_time))
+    commit();
+}
+
+
+/*
+  abandon - Give up the open group without ending it
+
+  Called by MySQL_Connection::close() when the connection is closed in
+  the middle of a result set, so the reply to a COMMIT or ROLLBACK could
+  not be read. The failed handler is called with the error
+  MYSQL_GROUP_OUTCOME_UNKNOWN for the statements of the group.
+*/
+void MySQL_Group_Commit::abandon() {
+  unsigned long first = sequence - count + 1;
+  int unknown = count;
+
+  if (!open)
+    return;
+  open = false;
+  begin_queued = false;
+  count = 0;
+  stats.abandoned++;
+  MYSQL_LOG_W(MYSQL_P(GROUP_ABANDONED), unknown, ".");
+  if (failed)
+    failed(first, unknown, MYSQL_GROUP_OUTCOME_UNKNOWN, failed_arg);
+}
+
+
+/*
+  rollback - Roll back the open group and report its statements
+
+  error[in]       error that caused it
+*/
+void MySQL_Group_Commit::rollback(int error) {
+  unsigned long first = sequence - count + 1;
+  int lost = count;
+
+  if (conn->connected()) {
+    // Keep the error of the failed statement, not the ROLLBACK's
+    mysql_error cause = *conn->get_last_error();
+    queue_command(ROLLBACK);
+    command_reply();
+    conn->set_last_error(&cause);
+  }
+  open = false;
+  count = 0;
+  stats.rollbacks++;
+  stats.lost += lost;
+  MYSQL_LOG_W(MYSQL_P(GROUP_ROLLED_BACK), lost, ".");
+  if (failed)
+    failed(first, lost, error, failed_arg);
+}
+
+
+/*
+  queue_command - Queue a statement of this class for the server
+
+  command[in]     statement (in program memory)
+*/
+void MySQL_Group_Commit::queue_command(const char *command) {
+  byte packet[24];
+  int len = strlen_P(command);
+
+  conn->store_int(&packet[0], len+1, 3);
+  packet[3] = byte(0x00);
+  packet[4] = byte(COM_QUERY);
+  memcpy_P(&packet[5], command, len);
+  conn->write_packet(packet, len+5);
+}
+
+
+/*
+  command_reply - Read the reply to a queued statement
+
+  Returns boolean - True = Ok packet
+*/
+boolean MySQL_Group_Commit::command_reply() {
+  conn->read_packet();
+  int type = conn->get_packet_type();
+  if (type == MYSQL_ERROR_PACKET)
+    conn->parse_error_packet();
+  return type == MYSQL_OK_PACKET;
+}
@@ -0,0 +1,123 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Group_Commit.h - Group writes into timed transactions
+
+  This header file defines a write scheduler for a connection. Each
+  autocommitted INSERT makes the server flush its log, which limits how
+  many samples per second one server can take from many nodes. Given to
+  a connection (MySQL_Connection::set_group_commit()), the scheduler
+  opens a transaction before the first write and the following INSERT,
+  UPDATE, DELETE and REPLACE statements run by MySQL_Cursor::execute()
+  go into it. The transaction is committed after max_statements writes
+  or max_ms milliseconds, whichever comes first, so the server flushes
+  once per group. Other statements run as before (inside the open
+  transaction, so they see its writes).
+
+  START TRANSACTION is sent together with the first write of a group, so
+  opening a group costs no extra round trip. Call poll() from loop() so a
+  group is committed on time when the writes stop, and commit() before
+  statements that commit implicitly (e.g. CREATE TABLE).
+
+  If a write of the group fails, or the COMMIT does, the transaction is
+  rolled back and the failed handler is called with the numbers of the
+  statements lost (numbered from 1 in the order they were executed, see
+  get_sequence()) so a sketch can send them again. If the connection is
+  closed while a result set is being read, no COMMIT or ROLLBACK can be
+  read back: the group is abandoned and the handler is called with the
+  error MYSQL_GROUP_OUTCOME_UNKNOWN. The server rolls back a transaction
+  left open by a closed connection, but the client cannot confirm it.
+
+  MySQL_Cursor::execute_batch() commits the open group before it sends
+  its statements, which are not grouped.
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_GROUP_COMMIT_H
+#define MYSQL_GROUP_COMMIT_H
+
+#include <MySQL_Connection.h>
+
+// Error given to the failed handler for an abandoned group
+#define MYSQL_GROUP_OUTCOME_UNKNOWN  -1
+
+// Called when a group is rolled back: statements first to first+count-1
+// were lost, error is the error code (see get_last_error()).
+typedef void (*mysql_group_failed)(unsigned long first, int count,
+                                   int error, void *arg);
+
+// Structure for the statistics of the groups.
+typedef struct {
+  unsigned long statements;   // writes run in groups
+  unsigned long commits;      // groups committed
+  unsigned long committed;    // writes committed
+  unsigned long rollbacks;    // groups rolled back
+  unsigned long lost;         // writes rolled back
+  unsigned long abandoned;    // groups of unknown outcome
+  unsigned long last_us;      // time of the last COMMIT (microseconds)
+  unsigned long max_us;       // longest COMMIT
+  unsigned long total_us;     // time of all COMMITs
+  int last_size;              // writes in the last group committed
+  int max_size;               // most writes in a group committed
+} mysql_group_stats;
+
+const char *mysql_first_word(const char *query, boolean progmem, char *word,
+                             int size);
+
+// Installed by MySQL_Connection::set_group_commit()
+extern const mysql_group_hooks mysql_group_commit_hooks;
+
+class MySQL_Group_Commit {
+  public:
+    MySQL_Group_Commit(int max_statements, unsigned long max_ms);
+    void set_failed_handler(mysql_group_failed handler, void *arg=NULL);
+    boolean commit();
+    boolean poll();
+    boolean is_open() { return open; }
+    int pending() { return count; }
+    unsigned long get_sequence() { return sequence; }
+    const mysql_group_stats *get_stats() { return &stats; }
+    void reset_stats();
+    static boolean is_write(const char *query, boolean progmem=false);
+
+    // Used by MySQL_Connection and MySQL_Cursor
+    void attach(MySQL_Connection *connection);
+    boolean route(const char *query, boolean progmem);
+    void opened();
+    void written(boolean ok);
+    void abandon();
+
+  private:
+    void queue_command(const char *command);
+    boolean command_reply();
+    void rollback(int error);
+
+    MySQL_Connection *conn;
+    int max_count;              // writes per group
+    unsigned long max_time;     // milliseconds per group, 0 = no limit
+    boolean open;               // transaction open on the server
+    boolean begin_queued;       // START TRANSACTION sent, reply not read
+    int count;                  // writes in the open group
+    unsigned long started;      // millis() when the group was opened
+    unsigned long sequence;     // number of the last write grouped
+    mysql_group_failed failed;
+    void *failed_arg;
+    mysql_group_stats stats;
+};
+
+#endif
@@ -0,0 +1,474 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Hosts.cpp - Server lists with failover and read/write routing
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#include <MySQL_Hosts.h>
+
+const char HOST_DOWN[] PROGMEM = "Server down, skipped for ms: ";
+const char HOST_UNRESOLVED[] PROGMEM = "Cannot resolve ";
+const char HOST_FAILOVER[] PROGMEM = "Failed over to server ";
+
+// First words of the statements sent to the replicas
+const char READ_WORDS[][9] PROGMEM = {
+  "SELECT", "SHOW", "DESCRIBE", "DESC", "EXPLAIN"
+};
+
+// Reads that lock rows run on the primary
+const char LOCKING_READS[][14] PROGMEM = {
+  "FOR UPDATE", "FOR SHARE", "LOCK IN SHARE"
+};
+
+/*
+  Constructor
+
+  dns_ttl_ms[in]  milliseconds a resolved address is used
+*/
+MySQL_Hosts::MySQL_Hosts(unsigned long dns_ttl_ms) {
+  num_hosts = 0;
+  dns_ttl = dns_ttl_ms;
+  resolver = NULL;
+  resolver_arg = NULL;
+  failovers = 0;
+}
+
+
+/*
+  add - Add a server given by address
+
+  address[in]     IP address of the server
+  port[in]        port number of the server
+  role[in]        MYSQL_HOST_PRIMARY or MYSQL_HOST_REPLICA
+
+  Returns integer - number of the server, -1 = the list is full
+*/
+int MySQL_Hosts::add(IPAddress address, int port, byte role) {
+  if (num_hosts == MYSQL_HOSTS_MAX)
+    return -1;
+  mysql_host *host = &hosts[num_hosts];
+  host->name = NULL;
+  host->address = (uint32_t)address;
+  host->port = port;
+  host->role = role;
+  host->failures = 0;
+  host->resolved = 0;
+  host->down_until = 0;
+  return num_hosts++;
+}
+
+
+/*
+  add - Add a server given by name
+
+  The name is resolved when the server is first used (see
+  set_resolver()). It is not copied and must stay valid.
+
+  name[in]        host name of the server
+  port[in]        port number of the server
+  role[in]        MYSQL_HOST_PRIMARY or MYSQL_HOST_REPLICA
+
+  Returns integer - number of the server, -1 = the list is full
+*/
+int MySQL_Hosts::add(const char *name, int port, byte role) {
+  int host = add(IPAddress((uint32_t)0), port, role);
+  if (host >= 0)
+    hosts[host].name = name;
+  return host;
+}
+
+
+/*
+  set_resolver - Set the function that resolves the server names
+
+  For example with the Ethernet library:
+
+    boolean resolve(const char *name, IPAddress *address, void *arg) {
+      DNSClient dns;
+      dns.begin(Ethernet.dnsServerIP());
+      return dns.getHostByName(name, *address) == 1;
+    }
+
+  resolver[in]    function to call
+  arg[in]         passed to the function
+*/
+void MySQL_Hosts::set_resolver(mysql_resolver resolver, void *arg) {
+  this->resolver = resolver;
+  resolver_arg = arg;
+}
+
+
+/*
+  count - Count the servers of a role
+
+  role[in]        MYSQL_HOST_PRIMARY or MYSQL_HOST_REPLICA
+
+  Returns integer - number of servers
+*/
+int MySQL_Hosts::count(byte role) {
+  int num = 0;
+  for (int h = 0; h < num_hosts; h++)
+    if (hosts[h].role == role)
+      num++;
+  return num;
+}
+
+
+/*
+  connect - Connect to the first server of a role that answers
+
+  The servers of the role are tried in the order they were added,
+  beginning with the start-th one. Servers that failed recently are
+  skipped (see is_up()).
+
+  conn[in]        connection to open
+  user[in]        user name
+  password[in]    user password
+  db[in]          (optional) default database
+  role[in]        MYSQL_HOST_PRIMARY or MYSQL_HOST_REPLICA
+  start[in]       server of the role to try first (counted from 0)
+
+  Returns integer - number of the server connected to, -1 = none
+*/
+int MySQL_Hosts::connect(MySQL_Connection *conn, char *user, char *password,
+                         char *db, byte role, int start) {
+  int num = count(role);
+  IPAddress address;
+
+  for (int k = 0; k < num; k++) {
+    // The ((start + k) % num)-th server of the role
+    int host = -1;
+    for (int n = (start + k) % num; n >= 0; n--)
+      for (host++; hosts[host].role != role; host++)
+        ;
+    if (!is_up(host))
+      continue;
+    if (!resolve(host, &address)) {
+      failed(host);
+      continue;
+    }
+    if (conn->connect(address, hosts[host].port, user, password, db)) {
+      succeeded(host);
+      if (k > 0) {
+        failovers++;
+        MYSQL_LOG_W(MYSQL_P(HOST_FAILOVER), host, ".");
+      }
+      return host;
+    }
+    conn->close();
+    failed(host);
+  }
+  return -1;
+}
+
+
+/*
+  resolve - Get the address of a server
+
+  A name is resolved again once its address is older than the DNS time
+  to live or the server failed. If the name cannot be resolved the last
+  address is used.
+
+  host[in]        number of the server
+  address[out]    its address
+
+  Returns boolean - True = address known
+*/
+boolean MySQL_Hosts::resolve(int host, IPAddress *address) {
+  mysql_host *entry = &hosts[host];
+
+  if (entry->name &&
+      (entry->address == 0 || millis() - entry->resolved >= dns_ttl)) {
+    IPAddress found;
+    if (resolver && resolver(entry->name, &found, resolver_arg) &&
+        (uint32_t)found != 0) {
+      entry->address = (uint32_t)found;
+      entry->resolved = millis();
+    } else {
+      MYSQL_LOG_W(MYSQL_P(HOST_UNRESOLVED), entry->name);
+    }
+  }
+  *address = IPAddress(entry->address);
+  return entry->address != 0;
+}
+
+
+/*
+  is_up - Check if a server may be tried
+
+  host[in]        number of the server
+
+  Returns boolean - False while a failed server is skipped
+*/
+boolean MySQL_Hosts::is_up(int host) {
+  return hosts[host].failures == 0 ||
+         (long)(millis() - hosts[host].down_until) >= 0;
+}
+
+
+/*
+  failed - Count a failed connect to a server
+
+  The server is skipped for MYSQL_HOST_RETRY_MS, doubled for each failure
+  in a row up to MYSQL_HOST_RETRY_MAX_MS, and its name is resolved again
+  the next time.
+
+  host[in]        number of the server
+*/
+void MySQL_Hosts::failed(int host) {
+  mysql_host *entry = &hosts[host];
+  unsigned long wait = MYSQL_HOST_RETRY_MS;
+
+  if (entry->failures < 255)
+    entry->failures++;
+  for (int f = 1; f < entry->failures && wait < MYSQL_HOST_RETRY_MAX_MS; f++)
+    wait <<= 1;
+  if (wait > MYSQL_HOST_RETRY_MAX_MS)
+    wait = MYSQL_HOST_RETRY_MAX_MS;
+  entry->down_until = millis() + wait;
+  entry->resolved = millis() - dns_ttl;
+  MYSQL_LOG_W(MYSQL_P(HOST_DOWN), wait, ".");
+}
+
+
+/*
+  succeeded - Count a good connect to a server
+
+  host[in]        number of the server
+*/
+void MySQL_Hosts::succeeded(int host) {
+  hosts[host].failures = 0;
+}
+
+
+/*
+  Constructor
+
+  host_list[in]     servers to connect to
+  primary_conn[in]  connection for the writes
+  replica_conns[in] (optional) connections for the reads, each with
+                    its own client
+  replica_count[in] number of replica connections
+*/
+MySQL_Router::MySQL_Router(MySQL_Hosts *host_list,
+                           MySQL_Connection *primary_conn,
+                           MySQL_Connection **replica_conns,
+                           int replica_count) {
+  hosts = host_list;
+  this->primary_conn = primary_conn;
+  primary_host = -1;
+  num_replicas = replica_count < MYSQL_ROUTER_REPLICAS ?
+                 replica_count : MYSQL_ROUTER_REPLICAS;
+  for (int r = 0; r < num_replicas; r++) {
+    this->replica_conns[r] = replica_conns[r];
+    replica_host[r] = -1;
+  }
+  next_replica = 0;
+  transaction = false;
+  user = NULL;
+  password = NULL;
+  db = NULL;
+  reads = 0;
+  replica_reads = 0;
+  writes = 0;
+}
+
+
+/*
+  begin - Set the login used for all connections
+
+  The connections are opened when they are first needed.
+
+  user[in]        user name
+  password[in]    user password
+  db[in]          (optional) default database
+*/
+void MySQL_Router::begin(char *user, char *password, char *db) {
+  this->user = user;
+  this->password = password;
+  this->db = db;
+}
+
+
+/*
+  route - Get the connection a statement should run on
+
+  The statement is only looked at, run it with a cursor on the
+  connection returned:
+
+    MySQL_Cursor cur(router.route(query));
+    cur.execute(query);
+
+  query[in]       SQL statement
+  progmem[in]     True if the string is in program memory
+
+  Returns MySQL_Connection * - connection, NULL = no server reachable
+*/
+MySQL_Connection *MySQL_Router::route(const char *query, boolean progmem) {
+  MySQL_Group_Commit *group = primary_conn->get_group_commit();
+  MySQL_Connection *conn;
+
+  track_transaction(query, progmem);
+  if (!transaction && !(group && group->is_open()) &&
+      is_read(query, progmem)) {
+    reads++;
+    conn = replica();
+    if (conn) {
+      replica_reads++;
+      return conn;
+    }
+  } else {
+    writes++;
+  }
+  return primary();
+}
+
+
+/*
+  primary - Get the connection to the primary
+
+  The connection is opened (or opened again on the next server of the
+  list) if needed.
+
+  Returns MySQL_Connection * - connection, NULL = no primary reachable
+*/
+MySQL_Connection *MySQL_Router::primary() {
+  if (!primary_conn->connected())
+    transaction = false;    // it ended with the connection
+  if (!open(primary_conn, MYSQL_HOST_PRIMARY, 0, &primary_host))
+    return NULL;
+  return primary_conn;
+}
+
+
+/*
+  replica - Get the next connection to a replica
+
+  The replica connections are used in turn; each prefers a different
+  replica server.
+
+  Returns MySQL_Connection * - connection, NULL = no replica reachable
+*/
+MySQL_Connection *MySQL_Router::replica() {
+  for (int r = 0; r < num_replicas; r++) {
+    int slot = next_replica;
+    next_replica = (next_replica + 1) % num_replicas;
+    if (open(replica_conns[slot], MYSQL_HOST_REPLICA, slot,
+             &replica_host[slot]))
+      return replica_conns[slot];
+  }
+  return NULL;
+}
+
+
+/*
+  close - Close all connections
+*/
+void MySQL_Router::close() {
+  primary_conn->close();
+  for (int r = 0; r < num_replicas; r++)
+    replica_conns[r]->close();
+  transaction = false;
+}
+
+
+/*
+  is_read - Check if a statement may run on a replica
+
+  query[in]       SQL statement
+  progmem[in]     True if the string is in program memory
+
+  Returns boolean - True for SELECT, SHOW, DESCRIBE and EXPLAIN that do
+                    not lock rows
+*/
+boolean MySQL_Router::is_read(const char *query, boolean progmem) {
+  char word[10];  // one longer than the read words
+  const char *rest = mysql_first_word(query, progmem, word, sizeof(word));
+  boolean read = false;
+
+  for (unsigned int i = 0; i < sizeof(READ_WORDS) / sizeof(READ_WORDS[0]);
+       i++) {
+    if (strcmp_P(word, READ_WORDS[i]) == 0)
+      read = true;
+  }
+  if (!read)
+    return false;
+
+  // Look for a locking clause (upper or lower case)
+  for (; (progmem ? pgm_read_byte_near(rest) : *rest) != 0x00; rest++) {
+    for (unsigned int i = 0;
+         i < sizeof(LOCKING_READS) / sizeof(LOCKING_READS[0]); i++) {
+      const char *text = LOCKING_READS[i];
+      int n = 0;
+      char c;
+      for (;; n++) {
+        char t = pgm_read_byte_near(text + n);
+        if (t == 0x00)
+          return false;
+        c = progmem ? pgm_read_byte_near(rest + n) : rest[n];
+        if (c >= 'a' && c <= 'z')
+          c -= 'a' - 'A';
+        if (c != t)
+          break;
+      }
+    }
+  }
+  return true;
+}
+
+
+/*
+  open - Open a connection unless it is open
+
+  conn[in]        connection
+  role[in]        MYSQL_HOST_PRIMARY or MYSQL_HOST_REPLICA
+  start[in]       server of the role to try first
+  host[out]       server connected to
+
+  Returns boolean - True = connection open
+*/
+boolean MySQL_Router::open(MySQL_Connection *conn, byte role, int start,
+                           int *host) {
+  if (conn->connected())
+    return true;
+  *host = hosts->connect(conn, user, password, db, role, start);
+  return *host >= 0;
+}
+
+
+/*
+  track_transaction - Follow explicit transactions on the primary
+
+  query[in]       SQL statement
+  progmem[in]     True if the string is in program memory
+*/
+void MySQL_Router::track_transaction(const char *query, boolean progmem) {
+  char word[9];
+  const char *rest = mysql_first_word(query, progmem, word, sizeof(word));
+
+  if (strcmp(word, "BEGIN") == 0) {
+    transaction = true;
+  } else if (strcmp(word, "START") == 0) {
+    mysql_first_word(rest, progmem, word, sizeof(word));
+    if (strcmp(word, "TRANSACT") == 0)  // cut to fit
+      transaction = true;
+  } else if (strcmp(word, "COMMIT") == 0 || strcmp(word, "ROLLBACK") == 0) {
+    transaction = false;
+  }
+}
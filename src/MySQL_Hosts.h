@@ -0,0 +1,142 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Hosts.h - Server lists with failover and read/write routing
+
+  This header file defines a list of servers to connect to instead of a
+  single address, and a router that splits statements between them.
+
+  MySQL_Hosts keeps up to MYSQL_HOSTS_MAX servers, each given by address
+  or by name, as the primary (writes) or a replica (reads). connect()
+  tries the servers of a role in order and uses the first that answers,
+  so when the primary fails over to a standby listed after it the node
+  follows without being reflashed. A server that cannot be reached is
+  skipped for MYSQL_HOST_RETRY_MS, doubled after each further failure
+  (up to MYSQL_HOST_RETRY_MAX_MS), so a dead server does not cost a
+  connect timeout on every attempt.
+
+  Names are resolved with a function of the sketch (the DNS client of
+  the board, see set_resolver()) and the address is kept for dns_ttl_ms.
+  The address of a server that cannot be reached is resolved again on
+  the next attempt, and an old address is used if the DNS server does
+  not answer.
+
+  MySQL_Router holds a connection to the primary and optionally some to
+  replicas. route() returns the connection a statement should run on:
+  SELECT, SHOW, DESCRIBE and EXPLAIN go to the replicas in turn, all
+  other statements, reads that lock rows (FOR UPDATE, FOR SHARE, LOCK IN
+  SHARE MODE) and every statement of an open transaction go to the
+  primary. Reads fall back to the primary when no replica can be
+  reached. Use primary() for reads that must see the latest writes
+  (replicas lag a little) or need the session (LAST_INSERT_ID()).
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_HOSTS_H
+#define MYSQL_HOSTS_H
+
+#include <MySQL_Connection.h>
+#include <MySQL_Group_Commit.h>
+
+#define MYSQL_HOSTS_MAX          4         // servers in a list
+#define MYSQL_ROUTER_REPLICAS    3         // replica connections of a router
+#define MYSQL_DNS_TTL_MS         300000UL  // default time to keep an address
+#define MYSQL_HOST_RETRY_MS      5000UL    // skip a failed server this long
+#define MYSQL_HOST_RETRY_MAX_MS  300000UL  // ... doubled up to this long
+
+// Roles of the servers
+#define MYSQL_HOST_PRIMARY   0
+#define MYSQL_HOST_REPLICA   1
+
+// Resolves a server name, returns true with the address
+typedef boolean (*mysql_resolver)(const char *name, IPAddress *address,
+                                  void *arg);
+
+// Structure for one server of a list.
+typedef struct {
+  const char *name;         // name to resolve, NULL = address given
+  uint32_t address;         // address (0 = not resolved)
+  uint16_t port;
+  byte role;                // MYSQL_HOST_PRIMARY or MYSQL_HOST_REPLICA
+  byte failures;            // failed connects in a row
+  unsigned long resolved;   // millis() when the name was resolved
+  unsigned long down_until; // millis() before which it is skipped
+} mysql_host;
+
+class MySQL_Hosts {
+  public:
+    MySQL_Hosts(unsigned long dns_ttl_ms=MYSQL_DNS_TTL_MS);
+    int add(IPAddress address, int port=3306, byte role=MYSQL_HOST_PRIMARY);
+    int add(const char *name, int port=3306, byte role=MYSQL_HOST_PRIMARY);
+    void set_resolver(mysql_resolver resolver, void *arg=NULL);
+    int connect(MySQL_Connection *conn, char *user, char *password,
+                char *db=NULL, byte role=MYSQL_HOST_PRIMARY, int start=0);
+    boolean resolve(int host, IPAddress *address);
+    boolean is_up(int host);
+    void failed(int host);
+    void succeeded(int host);
+    int count() { return num_hosts; }
+    int count(byte role);
+    const mysql_host *get_host(int host) { return &hosts[host]; }
+    unsigned long get_failovers() { return failovers; }
+
+  private:
+    mysql_host hosts[MYSQL_HOSTS_MAX];
+    int num_hosts;
+    unsigned long dns_ttl;
+    mysql_resolver resolver;
+    void *resolver_arg;
+    unsigned long failovers;  // connects that skipped the first server
+};
+
+class MySQL_Router {
+  public:
+    MySQL_Router(MySQL_Hosts *host_list, MySQL_Connection *primary_conn,
+                 MySQL_Connection **replica_conns=NULL, int replica_count=0);
+    void begin(char *user, char *password, char *db=NULL);
+    MySQL_Connection *route(const char *query, boolean progmem=false);
+    MySQL_Connection *primary();
+    MySQL_Connection *replica();
+    void close();
+    boolean in_transaction() { return transaction; }
+    unsigned long get_reads() { return reads; }
+    unsigned long get_replica_reads() { return replica_reads; }
+    unsigned long get_writes() { return writes; }
+    static boolean is_read(const char *query, boolean progmem=false);
+
+  private:
+    boolean open(MySQL_Connection *conn, byte role, int start, int *host);
+    void track_transaction(const char *query, boolean progmem);
+
+    MySQL_Hosts *hosts;
+    MySQL_Connection *primary_conn;
+    MySQL_Connection *replica_conns[MYSQL_ROUTER_REPLICAS];
+    int primary_host;                         // server of primary_conn
+    int replica_host[MYSQL_ROUTER_REPLICAS];  // server of each replica
+    int num_replicas;
+    int next_replica;
+    boolean transaction;      // START TRANSACTION or BEGIN seen
+    char *user;
+    char *password;
+    char *db;
+    unsigned long reads;
+    unsigned long replica_reads;
+    unsigned long writes;
+};
+
+#endif
@@ -0,0 +1,42 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Log.cpp - Logging with compile time levels
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#include <MySQL_Log.h>
+
+#if MYSQL_LOG_LEVEL > MYSQL_LOG_NONE
+Print *mysql_log_output = &Serial;
+#endif
+
+/*
+  mysql_print_P - Print a string stored in program memory
+
+  out[in]         where to print
+  msg[in]         PROGMEM string
+*/
+void mysql_print_P(Print *out, const char *msg) {
+  char pos;
+
+  while ((pos = pgm_read_byte(msg))) {
+    out->print(pos);
+    msg++;
+  }
+}
@@ -0,0 +1,127 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Log.h - Logging with compile time levels
+
+  This header file defines the messages the connector writes. Each message
+  has a level and messages above MYSQL_LOG_LEVEL are removed by the
+  preprocessor, so they cost neither time nor flash. With MYSQL_LOG_NONE
+  the connector does not reference Serial at all.
+
+  Set the level here (or with a build flag such as -DMYSQL_LOG_LEVEL=0):
+
+    MYSQL_LOG_NONE    no messages
+    MYSQL_LOG_ERROR   errors (see also MySQL_Packet::get_last_error())
+    MYSQL_LOG_WARN    errors and connection retries
+    MYSQL_LOG_INFO    the above and connect/disconnect (default)
+    MYSQL_LOG_DEBUG   everything
+
+  Messages are written to Serial unless another Print is set with
+  mysql_log_set_output(), e.g. Serial1, a File or a Print subclass that
+  forwards the text elsewhere. Each message ends with a new line.
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_LOG_H
+#define MYSQL_LOG_H
+
+#include <Arduino.h>
+
+#define MYSQL_LOG_NONE    0
+#define MYSQL_LOG_ERROR   1
+#define MYSQL_LOG_WARN    2
+#define MYSQL_LOG_INFO    3
+#define MYSQL_LOG_DEBUG   4
+
+#ifndef MYSQL_LOG_LEVEL
+  #define MYSQL_LOG_LEVEL MYSQL_LOG_INFO
+#endif
+
+// A string in program memory (PROGMEM) to log
+typedef struct {
+  const char *text;
+} mysql_log_P;
+
+// A string of a given length (not null terminated) to log
+typedef struct {
+  const char *text;
+  int len;
+} mysql_log_N;
+
+void mysql_print_P(Print *out, const char *msg);
+
+#if MYSQL_LOG_LEVEL > MYSQL_LOG_NONE
+extern Print *mysql_log_output;
+
+inline void mysql_log_set_output(Print *out) { mysql_log_output = out; }
+
+inline void mysql_log_item(Print *out, mysql_log_P msg) {
+  mysql_print_P(out, msg.text);
+}
+
+inline void mysql_log_item(Print *out, mysql_log_N msg) {
+  out->write((const uint8_t *)msg.text, msg.len);
+}
+
+template <typename T> void mysql_log_item(Print *out, T value) {
+  out->print(value);
+}
+
+inline void mysql_log_items(Print *out) {
+  out->println();
+}
+
+template <typename T, typename... R>
+void mysql_log_items(Print *out, T first, R... rest) {
+  mysql_log_item(out, first);
+  mysql_log_items(out, rest...);
+}
+
+template <typename... T> void mysql_log(T... items) {
+  if (mysql_log_output)
+    mysql_log_items(mysql_log_output, items...);
+}
+#else
+inline void mysql_log_set_output(Print *out) { (void)out; }
+#endif
+
+#if MYSQL_LOG_LEVEL >= MYSQL_LOG_ERROR
+  #define MYSQL_LOG_E(...) mysql_log(__VA_ARGS__)
+#else
+  #define MYSQL_LOG_E(...) do {} while (0)
+#endif
+#if MYSQL_LOG_LEVEL >= MYSQL_LOG_WARN
+  #define MYSQL_LOG_W(...) mysql_log(__VA_ARGS__)
+#else
+  #define MYSQL_LOG_W(...) do {} while (0)
+#endif
+#if MYSQL_LOG_LEVEL >= MYSQL_LOG_INFO
+  #define MYSQL_LOG_I(...) mysql_log(__VA_ARGS__)
+#else
+  #define MYSQL_LOG_I(...) do {} while (0)
+#endif
+#if MYSQL_LOG_LEVEL >= MYSQL_LOG_DEBUG
+  #define MYSQL_LOG_D(...) mysql_log(__VA_ARGS__)
+#else
+  #define MYSQL_LOG_D(...) do {} while (0)
+#endif
+
+// Wraps a PROGMEM string for the MYSQL_LOG_* macros
+#define MYSQL_P(msg)  mysql_log_P{msg}
+
+#endif
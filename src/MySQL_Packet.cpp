@@ -30,11 +30,84 @@
   Version 1.2.0 Created by Dr. Charles A. Bell, March 2020.
 */
 #include <Arduino.h>
+#include <limits.h>
 #include <MySQL_Packet.h>
 #include <MySQL_Encrypt_Sha1.h>
 
-#define MYSQL_DATA_TIMEOUT  3000   // Wifi client wait in milliseconds
-#define MYSQL_WAIT_INTERVAL 300    // WiFi client wait interval
+#define MYSQL_DATA_TIMEOUT  3000   // Wait before the first RTT sample (ms)
+#define MYSQL_WAIT_INTERVAL 300    // Maximum client wait interval (ms)
+#define MYSQL_MAX_BACKOFF   4      // Timeout doubles at most this many times
+
+/*
+  session_hash - Add bytes to the FNV-1a hash of a session state
+
+  h[in]           hash so far
+  data[in]        bytes to add
+  len[in]         number of bytes
+
+  Returns unsigned long - the new hash
+*/
+static unsigned long session_hash(unsigned long h, const byte *data,
+                                  int len) {
+  for (int i = 0; i < len; i++) {
+    h ^= data[i];
+    h *= 16777619UL;
+  }
+  return h & 0xffffffffUL;
+}
+
+
+/*
+  used_database - Find the database a command switches to
+
+  COM_INIT_DB and a USE statement change the default database, and with
+  it what the same query returns.
+
+  packet[in]      command packet including the 4 byte header
+  len[in]         number of bytes in the packet
+  db_len[out]     length of the database name
+
+  Returns const byte * - the database name, NULL if the command does not
+                         change it
+*/
+static const byte *used_database(const byte *packet, int len, int *db_len) {
+  int i = 5;
+  int start;
+
+  if (packet[4] == 0x02) {  // COM_INIT_DB
+    *db_len = len - 5;
+    return &packet[5];
+  }
+  if (packet[4] != 0x03)    // COM_QUERY
+    return NULL;
+  while (i < len && (packet[i] == ' ' || packet[i] == '\t' ||
+                     packet[i] == '\r' || packet[i] == '\n'))
+    i++;
+  // Upper case letters have bit 5 clear
+  if (!(i + 3 < len && (packet[i] & 0xdf) == 'U' &&
+        (packet[i+1] & 0xdf) == 'S' && (packet[i+2] & 0xdf) == 'E' &&
+        (packet[i+3] == ' ' || packet[i+3] == '\t' ||
+         packet[i+3] == '\r' || packet[i+3] == '\n' ||
+         packet[i+3] == '`')))
+    return NULL;
+  i += 3;
+  while (i < len && (packet[i] == ' ' || packet[i] == '\t' ||
+                     packet[i] == '\r' || packet[i] == '\n'))
+    i++;
+  if (i < len && packet[i] == '`') {
+    start = ++i;
+    while (i < len && packet[i] != '`')
+      i++;
+  } else {
+    start = i;
+    while (i < len && packet[i] != ' ' && packet[i] != '\t' &&
+           packet[i] != '\r' && packet[i] != '\n' && packet[i] != ';')
+      i++;
+  }
+  *db_len = i - start;
+  return &packet[start];
+}
+
 
 /*
   Constructor
@@ -43,29 +116,97 @@
 */
 MySQL_Packet::MySQL_Packet(Client *client_instance) {
   buffer = NULL;
+  server_version = NULL;
   client = client_instance;
+  server_capabilities = 0;
+  client_flags = MYSQL_CLIENT_FLAGS;
+  server_status = 0;
+  source = NULL;
+  source_len = 0;
+  source_pos = 0;
+  capture = NULL;
+  capture_len = 0;
+  capture_size = 0;
+  capture_limit = 0;
+  out_len = 0;
+  in_head = 0;
+  in_len = 0;
+  in_held = 0;
+  payload_left = 0;
+  reset_read_stats();
+  reset_write_stats();
+  clear_error();
+  waiter = NULL;
+  ssl_requested = false;
+  srtt8 = 0;
+  rttvar4 = 0;
+  rtt_samples = 0;
+  request_time = 0;
+  awaiting_reply = false;
+  query_queued = false;
+  awaiting_query = false;
+  server_key = 0;
+  login_key = 0;
+  session = 0;
+  timeout_backoff = 0;
+  timeout_min = MYSQL_TIMEOUT_MIN;
+  timeout_max = MYSQL_TIMEOUT_MAX;
 }
 
 /*
   show_error
 
-  Print the curent error message.
+  Print a message stored in program memory to the log output (see
+  MySQL_Log.h). Nothing is printed with MYSQL_LOG_NONE.
 
   msg[in]    Message to print
   EOL[in]    True if we print EOLN character
 */
 void MySQL_Packet::show_error(const char *msg, bool EOL) {
-#ifdef DEBUG
-  char pos;
-  while ((pos = pgm_read_byte(msg))) {
-    Serial.print(pos);
-    msg++;
-  }
+#if MYSQL_LOG_LEVEL > MYSQL_LOG_NONE
+  if (!mysql_log_output)
+    return;
+  mysql_print_P(mysql_log_output, msg);
   if (EOL)
-    Serial.println();
+    mysql_log_output->println();
 #endif
 }
 
+
+/*
+  set_error - Save a client side error as the last error
+
+  The error is also logged at MYSQL_LOG_ERROR.
+
+  code[in]   error code (MYSQL_CR_*)
+  msg[in]    error message stored in program memory
+*/
+void MySQL_Packet::set_error(int code, const char *msg) {
+  int i;
+
+  last_error.code = code;
+  last_error.sql_state[0] = 0x00;
+  for (i = 0; i < MYSQL_ERROR_MESSAGE_SIZE-1; i++) {
+    last_error.message[i] = pgm_read_byte(msg+i);
+    if (last_error.message[i] == 0x00)
+      break;
+  }
+  last_error.message[i] = 0x00;
+  MYSQL_LOG_E(MYSQL_P(msg));
+}
+
+
+/*
+  clear_error - Forget the last error
+
+  This happens when the next command is sent to the server.
+*/
+void MySQL_Packet::clear_error() {
+  last_error.code = 0;
+  last_error.sql_state[0] = 0x00;
+  last_error.message[0] = 0x00;
+}
+
 /*
   send_authentication_packet
 
@@ -97,33 +238,17 @@ void MySQL_Packet::show_error(const char *msg, bool EOL) {
 void MySQL_Packet::send_authentication_packet(char *user, char *password,
                                               char *db)
 {
-  if (buffer != NULL)
-    free(buffer);
-
-  buffer = (byte *)malloc(256);
+  free_buffer();
+  buffer = (byte *)mysql_malloc(256, MYSQL_ALLOC_COMMAND);
+  if (buffer == NULL) {
+    set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+    return;
+  }
 
   int size_send = 4;
 
-  // client flags
-  buffer[size_send] = byte(0x0D);
-  buffer[size_send+1] = byte(0xa6);
-  buffer[size_send+2] = byte(0x03);
-  buffer[size_send+3] = byte(0x00);
-  size_send += 4;
-
-  // max_allowed_packet
-  buffer[size_send] = 0;
-  buffer[size_send+1] = 0;
-  buffer[size_send+2] = 0;
-  buffer[size_send+3] = 1;
-  size_send += 4;
-
-  // charset - default is 8
-  buffer[size_send] = byte(0x08);
-  size_send += 1;
-  for(int i = 0; i < 24; i++)
-    buffer[size_send+i] = 0x00;
-  size_send += 23;
+  // client flags, max_allowed_packet, charset and filler
+  size_send += store_login_header(&buffer[size_send]);
 
   // user name
   memcpy((char *)&buffer[size_send], user, strlen(user));
@@ -131,7 +256,12 @@ void MySQL_Packet::send_authentication_packet(char *user, char *password,
   buffer[size_send-1] = 0x00;
 
   // password - see scramble password
-  byte *scramble = (uint8_t *)malloc(20);
+  byte *scramble = (uint8_t *)mysql_malloc(20, MYSQL_ALLOC_HANDSHAKE);
+  if (scramble == NULL) {
+    free_buffer();
+    set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+    return;
+  }
   if (scramble_password(password, scramble)) {
     buffer[size_send] = 0x14;
     size_send += 1;
@@ -140,7 +270,7 @@ void MySQL_Packet::send_authentication_packet(char *user, char *password,
     size_send += 20;
     buffer[size_send] = 0x00;
   }
-  free(scramble);
+  mysql_free(scramble);
 
   if (db) {
     memcpy((char *)&buffer[size_send], db, strlen(db));
@@ -154,11 +284,78 @@ void MySQL_Packet::send_authentication_packet(char *user, char *password,
   // Write packet size
   int p_size = size_send - 4;
   store_int(&buffer[0], p_size, 3);
-  buffer[3] = byte(0x01);
+  // The SSL request packet takes sequence number 1
+  buffer[3] = byte(ssl_requested ? 0x02 : 0x01);
 
-  // Write the packet
-  client->write((uint8_t*)buffer, size_send);
-  client->flush();
+  // Queue the packet, it is sent when we read the server's reply
+  write_packet(buffer, size_send);
+}
+
+
+/*
+  send_ssl_request - Ask the server to switch the connection to TLS
+
+  This is sent instead of the authentication packet once the handshake
+  packet has been read. The server then expects the TLS handshake and
+  the authentication packet is sent over the encrypted connection. The
+  SSL request packet is the start of the authentication packet.
+
+  Bytes                        Name
+  -----                        ----
+  4                            client_flags (with CLIENT_SSL)
+  4                            max_packet_size
+  1                            charset_number
+  23                           (filler) always 0x00...
+*/
+void MySQL_Packet::send_ssl_request() {
+  byte packet[4+32];
+
+  ssl_requested = true;
+  store_login_header(&packet[4]);
+  store_int(&packet[0], 32, 3);
+  packet[3] = byte(0x01);
+  write_packet(packet, sizeof(packet));
+  flush_packets();
+  // The server answers with the TLS handshake, not a packet
+  awaiting_reply = false;
+}
+
+
+/*
+  store_login_header - Store the start of the authentication packet
+
+  CLIENT_DEPRECATE_EOF is only sent if the server supports it and
+  CLIENT_SSL once an SSL request was sent.
+
+  buff[in]        where to store the 32 bytes
+
+  Returns integer - number of bytes stored
+*/
+int MySQL_Packet::store_login_header(byte *buff) {
+  unsigned long flags = client_flags;
+
+  if (!(server_capabilities & MYSQL_CLIENT_DEPRECATE_EOF))
+    flags &= ~MYSQL_CLIENT_DEPRECATE_EOF;
+  if (ssl_requested)
+    flags |= MYSQL_CLIENT_SSL;
+
+  // client flags
+  buff[0] = byte(flags);
+  buff[1] = byte(flags >> 8);
+  buff[2] = byte(flags >> 16);
+  buff[3] = byte(flags >> 24);
+
+  // max_allowed_packet
+  buff[4] = 0;
+  buff[5] = 0;
+  buff[6] = 0;
+  buff[7] = 1;
+
+  // charset - default is 8
+  buff[8] = byte(0x08);
+  for (int i = 9; i < 32; i++)
+    buff[i] = 0x00;
+  return 32;
 }
 
 
@@ -216,9 +413,12 @@ boolean MySQL_Packet::scramble_password(char *password, byte *pwd_hash) {
   wait_for_bytes - Wait until data is available for reading
 
   This method is used to permit the connector to respond to servers
-  that have high latency or execute long queries. The timeout is
-  set by MYSQL_DATA_TIMEOUT. Adjust this value to match the performance of
-  your server and network.
+  that have high latency or execute long queries. The timeout adapts to
+  the round trip times measured on this connection (see get_timeout())
+  within the bounds set by set_timeout_bounds(), so a dead link on a LAN
+  is detected quickly while a slow cellular link is given time. Before
+  the first measurement, and for the first reply to a statement (which
+  includes its execution time), at least MYSQL_DATA_TIMEOUT is used.
 
   It is also used to read how many bytes in total are available from the
   server. Thus, it can be used to know how large a data burst is from
@@ -230,26 +430,133 @@ boolean MySQL_Packet::scramble_password(char *password, byte *pwd_hash) {
 */
 int MySQL_Packet::wait_for_bytes(int bytes_need)
 {
-  const long wait_till = millis() + MYSQL_DATA_TIMEOUT;
+  const unsigned long started = millis();
+  unsigned long timeout = get_timeout();
+  unsigned long interval;
   int num = 0;
-  long now = 0;
+  boolean timed_out = false;
+
+  if (awaiting_query && timeout < MYSQL_DATA_TIMEOUT)
+    timeout = MYSQL_DATA_TIMEOUT < timeout_max ? MYSQL_DATA_TIMEOUT
+                                               : timeout_max;
+
+  // Poll a few times per round trip
+  interval = rtt_samples ? (srtt8 >> 5) : (timeout >> 4);
+  if (interval < 1)
+    interval = 1;
+  else if (interval > MYSQL_WAIT_INTERVAL)
+    interval = MYSQL_WAIT_INTERVAL;
 
   do
   {
-    now = millis();
+#if MYSQL_IN_BUFFER_SIZE > 0
+    if (in_len < bytes_need)
+      fill_input();
+    num = in_len;
+    if (num < bytes_need && in_len + in_held == MYSQL_IN_BUFFER_SIZE)
+      num += client->available();
+#else
     num = client->available();
-    if (num < bytes_need)
-      delay(MYSQL_WAIT_INTERVAL);
-    else
+#endif
+    if (num >= bytes_need)
       break;
-  } while (now < wait_till);
-
-  if (num == 0 && now >= wait_till)
-    client->stop();
+    timed_out = millis() - started >= timeout;
+    if (!timed_out)
+      idle(interval);
+  } while (!timed_out);
+
+  if (timed_out) {
+    // No sample from a request that timed out (Karn), back off instead
+    awaiting_reply = false;
+    awaiting_query = false;
+    if (timeout_backoff < MYSQL_MAX_BACKOFF)
+      timeout_backoff++;
+    if (num == 0)
+      client->stop();
+  }
 
   return num;
 }
 
+
+/*
+  idle - Wait for the server
+
+  Sleeps with delay() unless a MySQL_Wait was set with set_wait(), which
+  may return early when the client has data to read.
+
+  ms[in]          milliseconds to wait at most
+*/
+void MySQL_Packet::idle(unsigned long ms) {
+  if (waiter)
+    waiter->wait(ms);
+  else
+    delay(ms);
+}
+
+
+/*
+  set_timeout_bounds - Set the range of the adaptive read timeout
+
+  min_ms[in]      shortest timeout in milliseconds
+  max_ms[in]      longest timeout in milliseconds
+*/
+void MySQL_Packet::set_timeout_bounds(unsigned long min_ms,
+                                      unsigned long max_ms) {
+  timeout_min = min_ms;
+  timeout_max = max_ms < min_ms ? min_ms : max_ms;
+}
+
+
+/*
+  get_timeout - Current read timeout
+
+  The timeout is computed like TCP's retransmission timeout: smoothed
+  round trip time plus four times its variation, at least the lower
+  bound, doubled after each timeout and at most the upper bound.
+
+  Returns unsigned long - timeout in milliseconds
+*/
+unsigned long MySQL_Packet::get_timeout() {
+  unsigned long timeout = MYSQL_DATA_TIMEOUT;
+
+  if (rtt_samples)
+    timeout = (srtt8 >> 3) + rttvar4;
+  if (timeout < timeout_min)
+    timeout = timeout_min;
+  timeout <<= timeout_backoff;
+  if (timeout > timeout_max)
+    timeout = timeout_max;
+  return timeout;
+}
+
+
+/*
+  rtt_sample - Update the round trip time estimates
+
+  The time from sending a request to the arrival of the reply's header
+  is smoothed as in TCP (RFC 6298) with gains of 1/8 and 1/4. Replies
+  to queries (COM_QUERY) are not sampled since they include the time the
+  server spent executing the statement.
+
+  rtt[in]         measured round trip time in milliseconds
+*/
+void MySQL_Packet::rtt_sample(unsigned long rtt) {
+  if (rtt_samples == 0) {
+    srtt8 = rtt << 3;
+    rttvar4 = rtt << 1;
+  } else {
+    long delta = (long)rtt - (long)(srtt8 >> 3);
+    srtt8 += delta;
+    if (delta < 0)
+      delta = -delta;
+    rttvar4 += delta - (long)(rttvar4 >> 2);
+  }
+  rtt_samples++;
+  timeout_backoff = 0;
+}
+
+
 /*
   read_packet - Read a packet from the server and store it in the buffer
 
@@ -268,46 +575,738 @@ int MySQL_Packet::wait_for_bytes(int bytes_need)
 void MySQL_Packet::read_packet() {
   byte local[4];
 
-  if (buffer) {
-    free(buffer);
-    buffer = NULL;
-  }
+  drop_payload();
+  free_buffer();
 
-  // Read packet header
-  if (wait_for_bytes(4) < 4) {
-    show_error(READ_TIMEOUT, true);
+  if (source) {
+    read_source_packet();
     return;
   }
-  for (int i = 0; i < 4; i++)
-    local[i] = client->read();
 
-  // Get packet length
-  packet_len = local[0];
-  packet_len += (local[1] << 8);
-  packet_len += ((uint32_t)local[2] << 16);
+  if (!wait_for_header())
+    return;
+  packets_read++;
+  switch (frame_in_place()) {
+    case 1:
+      if (capture_limit > 0)
+        capture_packet();
+      return;
+    case -1:
+      return;
+  }
+  if (!read_header(local))
+    return;
 
   // We must wait for slow arriving packets for Ethernet shields only.
 /*
   if (wait_for_bytes(packet_len) < packet_len) {
-    show_error(READ_TIMEOUT, true);
+    set_error(MYSQL_CR_SERVER_LOST, READ_TIMEOUT);
     return;
   }
 */
   // Check for valid packet.
   if (packet_len < 0) {
-    show_error(PACKET_ERROR, true);
+    set_error(MYSQL_CR_MALFORMED_PACKET, PACKET_ERROR);
     packet_len = 0;
   }
-  buffer = (byte *)malloc(packet_len+4);
+  buffer = (byte *)mysql_malloc(packet_len+4, MYSQL_ALLOC_READ_PACKET);
   if (buffer == NULL) {
-    show_error(MEMORY_ERROR, true);
+    // Drop the payload so the next packet can still be read
+    read_bytes(NULL, packet_len);
+    set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
     return;
   }
   for (int i = 0; i < 4; i++)
     buffer[i] = local[i];
 
-  for (int i = 4; i < packet_len+4; i++)
-    buffer[i] = client->read();
+  if (!read_bytes(buffer+4, packet_len)) {
+    mysql_free(buffer);
+    buffer = NULL;
+    return;
+  }
+
+  if (capture_limit > 0)
+    capture_packet();
+}
+
+
+/*
+  wait_for_header - Wait for the header of the next packet
+
+  Sends any queued packets first since the server cannot answer what it
+  has not received.
+
+  Returns boolean - True = header available, False = timeout
+*/
+boolean MySQL_Packet::wait_for_header() {
+  flush_packets();
+
+  if (wait_for_bytes(4) < 4) {
+    set_error(MYSQL_CR_SERVER_LOST, READ_TIMEOUT);
+    return false;
+  }
+  if (awaiting_reply) {
+    rtt_sample(millis() - request_time);
+    awaiting_reply = false;
+  }
+  awaiting_query = false;
+  return true;
+}
+
+
+/*
+  read_header - Read the header of the next packet from the server
+
+  Sets packet_len.
+
+  header[out]     the 4 header bytes
+
+  Returns boolean - True = header read, False = timeout
+*/
+boolean MySQL_Packet::read_header(byte *header) {
+  if (!wait_for_header() || !read_bytes(header, 4))
+    return false;
+
+  // Get packet length
+  packet_len = header[0];
+  packet_len += (header[1] << 8);
+  packet_len += ((uint32_t)header[2] << 16);
+  return true;
+}
+
+
+/*
+  read_bytes - Read the payload of a packet
+
+  The rest of a long packet may still be on its way, so this waits
+  whenever the client has nothing to read.
+
+  dest[out]       where to store the bytes, NULL to drop them
+  len[in]         number of bytes
+
+  Returns boolean - True = all bytes read, False = timeout
+*/
+boolean MySQL_Packet::read_bytes(byte *dest, int len) {
+  int num;
+
+  while (len > 0) {
+    num = read_input(dest, len);
+    if (num > 0) {
+      if (dest)
+        dest += num;
+      len -= num;
+    } else if (wait_for_bytes(1) < 1) {
+      set_error(MYSQL_CR_SERVER_LOST, READ_TIMEOUT);
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/*
+  skip_packet - Read a packet from the server without keeping it
+
+  This is used to drain result sets that are not read. The payload of
+  row and column packets is read in chunks and dropped without
+  allocating memory. Packets that end a result (EOF and Error) are kept
+  in the buffer as read_packet() does so their status can be parsed.
+  Cached and captured results are read with read_packet().
+
+  Returns integer - first byte of the payload (packet type),
+                    -1 = timeout
+*/
+int MySQL_Packet::skip_packet() {
+  byte header[4];
+  byte type;
+
+  if (source || capture_limit > 0) {
+    read_packet();
+    return buffer ? buffer[4] : -1;
+  }
+  drop_payload();
+  free_buffer();
+  if (!read_header(header))
+    return -1;
+  packets_read++;
+  if (packet_len == 0)
+    return 0;
+  if (!read_bytes(&type, 1))
+    return -1;
+
+  // Keep the packets that end a result
+  if (type == MYSQL_ERROR_PACKET ||
+      (type == MYSQL_EOF_PACKET && packet_len < 0xffffff)) {
+    buffer = (byte *)mysql_malloc(packet_len+4, MYSQL_ALLOC_SKIP_PACKET);
+    if (buffer == NULL) {
+      read_bytes(NULL, packet_len-1);
+      set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+      return -1;
+    }
+    for (int i = 0; i < 4; i++)
+      buffer[i] = header[i];
+    buffer[4] = type;
+    if (!read_bytes(buffer+5, packet_len-1)) {
+      mysql_free(buffer);
+      buffer = NULL;
+      return -1;
+    }
+    return type;
+  }
+
+  if (!read_bytes(NULL, packet_len-1))
+    return -1;
+  return type;
+}
+
+
+/*
+  open_packet - Start reading a packet in pieces
+
+  Only the header and the first byte of the payload are read; the rest
+  is read with read_payload() in chunks of the caller's size, so a packet
+  holding a long value needs no buffer of its size. Packets that fit the
+  read buffer are used in place and cached or captured results are read
+  with read_packet(); read_payload() then copies from the buffer. The
+  packets that end a result (EOF and Error) are kept in the buffer as
+  skip_packet() does.
+
+  The unread rest of the packet is dropped by the next read.
+
+  Returns integer - first byte of the payload (packet type),
+                    -1 = timeout
+*/
+int MySQL_Packet::open_packet() {
+  byte header[4];
+  byte type;
+
+  payload_left = 0;
+  if (source || capture_limit > 0) {
+    read_packet();
+  } else {
+    drop_payload();
+    free_buffer();
+    if (!wait_for_header())
+      return -1;
+    packets_read++;
+    switch (frame_in_place()) {
+      case 1:
+        break;
+      case -1:
+        return -1;
+      default:
+        if (!read_header(header))
+          return -1;
+        if (packet_len == 0)
+          return 0;
+        if (!read_bytes(&type, 1))
+          return -1;
+        if (type == MYSQL_ERROR_PACKET ||
+            (type == MYSQL_EOF_PACKET && packet_len < 0xffffff)) {
+          buffer = (byte *)mysql_malloc(packet_len+4, MYSQL_ALLOC_READ_PACKET);
+          if (buffer == NULL) {
+            set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+            return -1;
+          }
+          for (int i = 0; i < 4; i++)
+            buffer[i] = header[i];
+          buffer[4] = type;
+          if (!read_bytes(buffer+5, packet_len-1)) {
+            mysql_free(buffer);
+            buffer = NULL;
+            return -1;
+          }
+          return type;
+        }
+        payload_left = packet_len - 1;
+        return type;
+    }
+  }
+  if (buffer == NULL)
+    return -1;
+  if (packet_len == 0)
+    return 0;
+  payload_left = packet_len - 1;
+  return buffer[4];
+}
+
+
+/*
+  read_payload - Read the next bytes of the packet from open_packet()
+
+  dest[out]       where to store the bytes, NULL to drop them
+  len[in]         bytes wanted
+
+  Returns integer - bytes read (fewer at the end of the packet,
+                    0 at its end), -1 = timeout
+*/
+int MySQL_Packet::read_payload(byte *dest, int len) {
+  if (len > payload_left)
+    len = payload_left;
+  if (len <= 0)
+    return 0;
+  if (buffer) {
+    if (dest)
+      memcpy(dest, buffer + packet_len + 4 - payload_left, len);
+  } else if (!read_bytes(dest, len)) {
+    payload_left = 0;
+    return -1;
+  }
+  payload_left -= len;
+  return len;
+}
+
+
+/*
+  drop_payload - Drop the unread rest of the packet from open_packet()
+*/
+void MySQL_Packet::drop_payload() {
+  if (payload_left > 0 && buffer == NULL)
+    read_bytes(NULL, payload_left);
+  payload_left = 0;
+}
+
+
+/*
+  free_buffer - Release the current packet
+
+  The buffer is freed, or given back to the read buffer when the packet
+  was used in place.
+*/
+void MySQL_Packet::free_buffer() {
+  if (in_held) {
+    in_held = 0;
+  } else if (buffer) {
+    mysql_free(buffer);
+  }
+  buffer = NULL;
+}
+
+
+/*
+  frame_in_place - Use the next packet where it is in the read buffer
+
+  The packet must fit in the read buffer. When it would run past the end
+  the unread bytes are moved to the front first, unless they wrap.
+
+  Returns integer - 1 = packet is in buffer, 0 = it must be copied,
+                    -1 = timeout
+*/
+int MySQL_Packet::frame_in_place() {
+#if MYSQL_IN_BUFFER_SIZE > 0
+  int len;
+
+  if (in_len < 4 || in_head + 4 > MYSQL_IN_BUFFER_SIZE)
+    return 0;
+  len = in_buffer[in_head];
+  len += (in_buffer[in_head+1] << 8);
+  len += ((uint32_t)in_buffer[in_head+2] << 16);
+  if (len > MYSQL_IN_BUFFER_SIZE - 4)
+    return 0;
+  if (in_head + 4 + len > MYSQL_IN_BUFFER_SIZE) {
+    if (in_head + in_len > MYSQL_IN_BUFFER_SIZE)
+      return 0;
+    memmove(in_buffer, in_buffer + in_head, in_len);
+    in_head = 0;
+  }
+  if (wait_for_bytes(len + 4) < len + 4) {
+    set_error(MYSQL_CR_SERVER_LOST, READ_TIMEOUT);
+    return -1;
+  }
+  buffer = in_buffer + in_head;
+  packet_len = len;
+  in_held = len + 4;
+  in_head += in_held;
+  in_len -= in_held;
+  if (in_head == MYSQL_IN_BUFFER_SIZE)
+    in_head = 0;
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+
+/*
+  fill_input - Read what the client has into the read buffer
+
+  Reads until the buffer is full or the client has nothing more. The free
+  space may wrap around the end of the buffer. The packet used in place
+  is not overwritten.
+*/
+void MySQL_Packet::fill_input() {
+#if MYSQL_IN_BUFFER_SIZE > 0
+  int tail;
+  int space;
+  int num;
+
+  if (in_len == 0 && in_held == 0)
+    in_head = 0;
+  for (;;) {
+    tail = in_head + in_len;
+    if (tail >= MYSQL_IN_BUFFER_SIZE)
+      tail -= MYSQL_IN_BUFFER_SIZE;
+    space = MYSQL_IN_BUFFER_SIZE - in_len - in_held;
+    if (space > MYSQL_IN_BUFFER_SIZE - tail)
+      space = MYSQL_IN_BUFFER_SIZE - tail;
+    if (space <= 0)
+      return;
+    num = client->available();
+    if (num <= 0)
+      return;
+    if (num > space)
+      num = space;
+    num = client->read(in_buffer + tail, num);
+    if (num <= 0)
+      return;
+    client_reads++;
+    in_len += num;
+  }
+#endif
+}
+
+
+/*
+  read_input - Take bytes from the read buffer (or the client)
+
+  Long payloads are read from the client straight into place once the
+  read buffer is empty.
+
+  dest[out]       where to store the bytes, NULL to drop them
+  len[in]         bytes wanted
+
+  Returns integer - bytes taken, 0 or less if none are available
+*/
+int MySQL_Packet::read_input(byte *dest, int len) {
+  int num;
+
+#if MYSQL_IN_BUFFER_SIZE > 0
+  if (in_len == 0) {
+    if (dest && in_held == 0 && len >= MYSQL_IN_BUFFER_SIZE) {
+      num = client->read(dest, len);
+      if (num > 0)
+        client_reads++;
+      return num;
+    }
+    fill_input();
+    if (in_len == 0)
+      return 0;
+  }
+  num = MYSQL_IN_BUFFER_SIZE - in_head;
+  if (num > in_len)
+    num = in_len;
+  if (num > len)
+    num = len;
+  if (dest)
+    memcpy(dest, in_buffer + in_head, num);
+  in_head += num;
+  if (in_head == MYSQL_IN_BUFFER_SIZE)
+    in_head = 0;
+  in_len -= num;
+#else
+  byte scratch[32];
+
+  if (dest == NULL) {
+    dest = scratch;
+    if (len > (int)sizeof(scratch))
+      len = sizeof(scratch);
+  }
+  num = client->read(dest, len);
+  if (num > 0)
+    client_reads++;
+#endif
+  return num;
+}
+
+
+/*
+  set_packet_source - Read the following packets from memory
+
+  The packets (including their headers) are copied and returned by
+  read_packet() in order instead of packets from the server. This is
+  used to return cached result sets through the normal cursor methods.
+  The client is used again once all packets were read.
+
+  data[in]        packets as saved by end_capture()
+  len[in]         number of bytes
+*/
+void MySQL_Packet::set_packet_source(const byte *data, int len) {
+  mysql_free(source);
+  source = NULL;
+  if (len <= 0)
+    return;
+  source = (byte *)mysql_malloc(len, MYSQL_ALLOC_SOURCE);
+  if (source == NULL) {
+    set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+    return;
+  }
+  memcpy(source, data, len);
+  source_len = len;
+  source_pos = 0;
+}
+
+
+/*
+  read_source_packet - Read the next packet from the memory source
+*/
+void MySQL_Packet::read_source_packet() {
+  packet_len = source[source_pos];
+  packet_len += (source[source_pos+1] << 8);
+  packet_len += ((uint32_t)source[source_pos+2] << 16);
+
+  buffer = (byte *)mysql_malloc(packet_len+4, MYSQL_ALLOC_SOURCE);
+  if (buffer == NULL) {
+    set_error(MYSQL_CR_OUT_OF_MEMORY, MEMORY_ERROR);
+  } else {
+    memcpy(buffer, &source[source_pos], packet_len+4);
+  }
+  source_pos += packet_len+4;
+  if (source_pos >= source_len) {
+    mysql_free(source);
+    source = NULL;
+  }
+}
+
+
+/*
+  start_capture - Keep a copy of the packets read from now on
+
+  limit[in]       maximum number of bytes to capture. The capture is
+                  cancelled if the packets do not fit. Limits above
+                  INT_MAX (32767 bytes on AVR) are lowered to it.
+*/
+void MySQL_Packet::start_capture(unsigned long limit) {
+  cancel_capture();
+  capture_limit = limit > (unsigned long)INT_MAX ? INT_MAX : (int)limit;
+}
+
+
+/*
+  end_capture - Stop capturing and return the captured packets
+
+  len[out]        number of bytes captured
+
+  Returns byte * - captured packets (free with mysql_free()) or NULL
+*/
+byte *MySQL_Packet::end_capture(int *len) {
+  byte *data = capture;
+
+  *len = capture_len;
+  if (capture_limit == 0 || capture_len == 0) {
+    mysql_free(data);
+    data = NULL;
+  } else if (capture_len < capture_size) {
+    byte *shrunk = (byte *)mysql_realloc(data, capture_len,
+                                         MYSQL_ALLOC_CAPTURE);
+    if (shrunk)
+      data = shrunk;
+  }
+  capture = NULL;
+  capture_len = 0;
+  capture_size = 0;
+  capture_limit = 0;
+  return data;
+}
+
+
+/*
+  cancel_capture - Stop capturing and discard the captured packets
+*/
+void MySQL_Packet::cancel_capture() {
+  mysql_free(capture);
+  capture = NULL;
+  capture_len = 0;
+  capture_size = 0;
+  capture_limit = 0;
+}
+
+
+/*
+  capture_packet - Append the packet in the buffer to the capture
+*/
+void MySQL_Packet::capture_packet() {
+  long need;
+
+  if (buffer == NULL)
+    return;
+  need = (long)capture_len + packet_len + 4;
+  if (need > capture_limit) {
+    cancel_capture();
+    return;
+  }
+  if (need > capture_size) {
+    long size = capture_size ? capture_size * 2L : 128;
+    if (size < need)
+      size = need;
+    if (size > capture_limit)
+      size = capture_limit;
+    byte *grown = (byte *)mysql_realloc(capture, size, MYSQL_ALLOC_CAPTURE);
+    if (grown == NULL) {
+      cancel_capture();
+      return;
+    }
+    capture = grown;
+    capture_size = size;
+  }
+  memcpy(&capture[capture_len], buffer, packet_len+4);
+  capture_len = need;
+}
+
+
+/*
+  write_packet - Queue a packet for sending to the server
+
+  Consecutive packets are coalesced in the outgoing buffer so that, for
+  example, a batch of queries leaves in one TCP segment instead of one
+  segment per packet. The buffer is sent by flush_packets() which is
+  called when the buffer is full, before reading a reply (read_packet())
+  or on request. Packets larger than the buffer are written directly.
+
+  packet[in]      Packet including the 4 byte header
+  len[in]         Number of bytes in the packet
+*/
+void MySQL_Packet::write_packet(const byte *packet, int len) {
+  packets_sent++;
+  // A new command starts with sequence number 0
+  if (len > 3 && packet[3] == 0) {
+    const byte *db;
+    int db_len;
+
+    clear_error();
+    if (len > 4 && packet[4] == 0x03)
+      query_queued = true;
+    if (len > 4 && (db = used_database(packet, len, &db_len)) != NULL)
+      use_database((const char *)db, db_len);
+  }
+#if MYSQL_OUT_BUFFER_SIZE > 0
+  if (out_len + len > MYSQL_OUT_BUFFER_SIZE)
+    flush_packets();
+  if (len < MYSQL_OUT_BUFFER_SIZE) {
+    memcpy(&out_buffer[out_len], packet, len);
+    out_len += len;
+    return;
+  }
+#endif
+  client->write((uint8_t*)packet, len);
+  client->flush();
+  segments_sent++;
+  bytes_sent += len;
+  request_time = millis();
+  awaiting_reply = !query_queued;
+  awaiting_query = query_queued;
+  query_queued = false;
+}
+
+
+/*
+  flush_packets - Send all queued packets to the server
+*/
+void MySQL_Packet::flush_packets() {
+#if MYSQL_OUT_BUFFER_SIZE > 0
+  if (out_len == 0)
+    return;
+  client->write((uint8_t*)out_buffer, out_len);
+  client->flush();
+  segments_sent++;
+  bytes_sent += out_len;
+  out_len = 0;
+  request_time = millis();
+  awaiting_reply = !query_queued;
+  awaiting_query = query_queued;
+  query_queued = false;
+#endif
+}
+
+
+/*
+  clear_packets - Drop queued packets and unread input
+
+  Used when a new connection starts on the client.
+*/
+void MySQL_Packet::clear_packets() {
+  out_len = 0;
+  query_queued = false;
+  awaiting_query = false;
+  payload_left = 0;
+  free_buffer();
+  in_head = 0;
+  in_len = 0;
+}
+
+
+/*
+  start_session - Name the session state after a successful login
+
+  Two sessions with the same server, user and default database answer a
+  query the same way, so they share one key across connections and
+  reconnects (see MySQL_Cache). Session variables set by a statement are
+  not part of the key.
+
+  server[in]      IP address of the server
+  port[in]        port number of the server
+  user[in]        user name
+  db[in]          (optional) default database
+*/
+void MySQL_Packet::start_session(IPAddress server, int port, const char *user,
+                                 const char *db) {
+  byte addr[6];
+
+  for (int i = 0; i < 4; i++)
+    addr[i] = server[i];
+  addr[4] = byte(port & 0xff);
+  addr[5] = byte(port >> 8);
+  server_key = session_hash(2166136261UL, addr, 6);
+  change_session(user, db);
+}
+
+
+/*
+  change_session - Rename the session state after COM_CHANGE_USER
+
+  user[in]        user name
+  db[in]          (optional) default database
+*/
+void MySQL_Packet::change_session(const char *user, const char *db) {
+  // The terminating zero keeps "ab" + "c" apart from "a" + "bc"
+  login_key = session_hash(server_key, (const byte *)user, strlen(user) + 1);
+  use_database(db, db ? strlen(db) : 0);
+}
+
+
+/*
+  use_database - Rename the session state after the default database
+                 changed
+
+  db[in]          database name
+  len[in]         length of the name
+*/
+void MySQL_Packet::use_database(const char *db, int len) {
+  session = session_hash(login_key, (const byte *)db, len);
+}
+
+
+/*
+  reset_write_stats - Reset the packet, segment and byte counters
+
+  The counters show how well writes are coalesced: packets_sent is the
+  number of packets queued, segments_sent the number of client writes.
+*/
+void MySQL_Packet::reset_write_stats() {
+  packets_sent = 0;
+  segments_sent = 0;
+  bytes_sent = 0;
+}
+
+
+/*
+  reset_read_stats - Reset the packet and client read counters
+
+  packets_read is the number of packets read from the server,
+  client_reads the number of client reads they took.
+*/
+void MySQL_Packet::reset_read_stats() {
+  packets_read = 0;
+  client_reads = 0;
 }
 
 
@@ -344,8 +1343,10 @@ void MySQL_Packet::parse_handshake_packet() {
     i++;
   } while (buffer[i-1] != 0x00);
 
-  server_version = (char *)malloc(i-5);
-  strncpy(server_version, (char *)&buffer[5], i-5);
+  mysql_free(server_version);
+  server_version = (char *)mysql_malloc(i-5, MYSQL_ALLOC_HANDSHAKE);
+  if (server_version)   // only logged, so it may be missing
+    strncpy(server_version, (char *)&buffer[5], i-5);
 
   // Capture the first 8 characters of seed
   i += 4; // Skip thread id
@@ -353,6 +1354,10 @@ void MySQL_Packet::parse_handshake_packet() {
     seed[j] = buffer[i+j];
   }
 
+  // Capture the server capabilities (lower and upper two bytes)
+  server_capabilities = (unsigned int)read_int(i+9, 2);
+  server_capabilities |= (unsigned long)(unsigned int)read_int(i+14, 2) << 16;
+
   // Capture rest of seed
   i += 27; // skip ahead
   for (int j = 0; j < 12; j++) {
@@ -361,11 +1366,11 @@ void MySQL_Packet::parse_handshake_packet() {
 }
 
 /*
-  parse_error_packet - Display the error returned from the server
+  parse_error_packet - Save the error returned from the server
 
-  This method parses an error packet from the server and displays the
-  error code and text via Serial.print. The error packet is defined
-  as follows.
+  This method parses an error packet from the server, saves the error
+  code, SQLSTATE and text as the last error (see get_last_error()) and
+  logs it at MYSQL_LOG_ERROR. The error packet is defined as follows.
 
   Note: the error packet is already stored in the buffer since this
         packet is not an expected response.
@@ -379,18 +1384,28 @@ void MySQL_Packet::parse_handshake_packet() {
   n                           message
 */
 void MySQL_Packet::parse_error_packet() {
-#ifdef DEBUG
-  Serial.print("Error: ");
-  Serial.print(read_int(5, 2));
-  Serial.print(" = ");
+  int offset = 7;
+  int len;
 
   if (!buffer)
     return;
 
-  for (int i = 0; i < packet_len-9; i++)
-    Serial.print((char)buffer[i+13]);
-  Serial.println(".");
-#endif
+  last_error.code = read_int(5, 2);
+  last_error.sql_state[0] = 0x00;
+  if (buffer[offset] == '#') {
+    memcpy(last_error.sql_state, &buffer[offset+1], 5);
+    last_error.sql_state[5] = 0x00;
+    offset += 6;
+  }
+  len = packet_len + 4 - offset;
+  if (len < 0)
+    len = 0;
+  MYSQL_LOG_E("Error: ", last_error.code, " = ",
+              mysql_log_N{(const char *)&buffer[offset], len}, ".");
+  if (len > MYSQL_ERROR_MESSAGE_SIZE-1)
+    len = MYSQL_ERROR_MESSAGE_SIZE-1;
+  memcpy(last_error.message, &buffer[offset], len);
+  last_error.message[len] = 0x00;
 }
 
 
@@ -417,13 +1432,67 @@ int MySQL_Packet::get_packet_type() {
 }
 
 
+/*
+  is_eof_packet - Check if the buffer holds the packet ending a result set
+
+  This is an EOF packet, or an Ok packet with the EOF header when
+  CLIENT_DEPRECATE_EOF was negotiated. A row whose first value starts
+  with the same byte is told apart by its length.
+
+  Returns boolean - True if the packet ends the column definitions or rows
+*/
+boolean MySQL_Packet::is_eof_packet() {
+  if (!buffer || buffer[4] != MYSQL_EOF_PACKET)
+    return false;
+  return packet_len < (eof_deprecated() ? 0xffffff : 9);
+}
+
+
+/*
+  parse_server_status - Read the server status from an Ok or EOF packet
+
+  The status flags tell, for example, whether more result sets follow
+  the current one (MYSQL_SERVER_MORE_RESULTS_EXISTS) as is the case for
+  stored procedure calls. The EOF packet is defined as follows.
+
+   Bytes                       Name
+   -----                       ----
+   1                           field_count, always = 0xfe
+   2                           warning_count
+   2                           server_status
+
+  See get_packet_type() for the Ok packet. With CLIENT_DEPRECATE_EOF the
+  result set ends with an Ok packet that has the EOF header (0xfe).
+
+  Returns integer - server status flags, also saved in server_status
+*/
+int MySQL_Packet::parse_server_status() {
+  int offset = 5;
+
+  if (!buffer)
+    return 0;
+
+  if (buffer[4] == MYSQL_EOF_PACKET && !eof_deprecated()) {
+    offset += 2;  // skip warning count
+  } else {
+    offset += get_lcb_len(offset);  // skip affected rows
+    offset += get_lcb_len(offset);  // skip insert id
+  }
+  if (offset + 2 > packet_len + 4)
+    return 0;
+  server_status = read_int(offset, 2);
+  return server_status;
+}
+
+
 /*
   get_lcb_len - Retrieves the length of a length coded binary value
 
   This reads the first byte from the offset into the buffer and returns
-  the number of bytes (size) that the integer consumes. It is used in
-  conjunction with read_int() to read length coded binary integers
-  from the buffer.
+  the number of bytes (size) that the length coded binary consumes,
+  including the first byte. It is used in conjunction with read_lcb_int()
+  to skip over length coded binary integers and string headers in the
+  buffer.
 
   Returns integer - number of bytes integer consumes
 */
@@ -432,18 +1501,14 @@ int MySQL_Packet::get_lcb_len(int offset) {
     return 0;
 
   int read_len = buffer[offset];
-  if (read_len > 250) {
-    // read type:
-    byte type = buffer[offset+1];
-    if (type == 0xfc)
-      read_len = 2;
-    else if (type == 0xfd)
-      read_len = 3;
-    else if (type == 0xfe)
-      read_len = 8;
-  } else {
+  if (read_len == 0xfc)
+    read_len = 3;
+  else if (read_len == 0xfd)
+    read_len = 4;
+  else if (read_len == 0xfe)
+    read_len = 9;
+  else
     read_len = 1;
-  }
   return read_len;
 }
 
@@ -465,12 +1530,13 @@ int MySQL_Packet::read_int(int offset, int size) {
     return -1;
   if (size == 0)
      new_size = get_lcb_len(offset);
-  if (size == 1)
+  else
+     new_size = size;
+  if (new_size == 1)
      return buffer[offset];
-  new_size = size;
   int shifter = (new_size - 1) * 8;
   for (int i = new_size; i > 0; i--) {
-    value += (buffer[i-1] << shifter);
+    value += (buffer[offset+i-1] << shifter);
     shifter -= 8;
   }
   return value;
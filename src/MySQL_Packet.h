@@ -44,11 +44,110 @@
     #include <Ethernet.h>
 #endif
 
+#include <MySQL_Log.h>
+#include <MySQL_Alloc.h>
+
 #define MYSQL_OK_PACKET     0x00
 #define MYSQL_EOF_PACKET    0xfe
 #define MYSQL_ERROR_PACKET  0xff
-#define MYSQL_VERSION_STR   "1.2.0"
-#define DEBUG
+#define MYSQL_LOCAL_INFILE_PACKET  0xfb
+#define MYSQL_VERSION_STR   "1.3.0"
+
+// Bounds of the adaptive read timeout in milliseconds
+#ifndef MYSQL_TIMEOUT_MIN
+  #define MYSQL_TIMEOUT_MIN   300
+#endif
+#ifndef MYSQL_TIMEOUT_MAX
+  #define MYSQL_TIMEOUT_MAX   30000
+#endif
+
+// Capability flags sent in the authentication packet
+#define MYSQL_CLIENT_LONG_PASSWORD      0x00000001UL
+#define MYSQL_CLIENT_LONG_FLAG          0x00000004UL
+#define MYSQL_CLIENT_CONNECT_WITH_DB    0x00000008UL
+#define MYSQL_CLIENT_LOCAL_FILES        0x00000080UL
+#define MYSQL_CLIENT_PROTOCOL_41        0x00000200UL
+#define MYSQL_CLIENT_INTERACTIVE        0x00000400UL
+#define MYSQL_CLIENT_SSL                0x00000800UL
+#define MYSQL_CLIENT_TRANSACTIONS       0x00002000UL
+#define MYSQL_CLIENT_SECURE_CONNECTION  0x00008000UL
+#define MYSQL_CLIENT_MULTI_STATEMENTS   0x00010000UL
+#define MYSQL_CLIENT_MULTI_RESULTS      0x00020000UL
+#define MYSQL_CLIENT_DEPRECATE_EOF      0x01000000UL
+#define MYSQL_CLIENT_FLAGS  (MYSQL_CLIENT_LONG_PASSWORD | \
+                             MYSQL_CLIENT_LONG_FLAG | \
+                             MYSQL_CLIENT_CONNECT_WITH_DB | \
+                             MYSQL_CLIENT_PROTOCOL_41 | \
+                             MYSQL_CLIENT_INTERACTIVE | \
+                             MYSQL_CLIENT_TRANSACTIONS | \
+                             MYSQL_CLIENT_SECURE_CONNECTION | \
+                             MYSQL_CLIENT_MULTI_STATEMENTS | \
+                             MYSQL_CLIENT_MULTI_RESULTS | \
+                             MYSQL_CLIENT_DEPRECATE_EOF)
+
+// Server status flags (Ok and EOF packets)
+#define MYSQL_SERVER_MORE_RESULTS_EXISTS  0x0008
+
+// Size of the outgoing write buffer used to coalesce packets into a single
+// client write (TCP segment). Set to 0 to write each packet immediately.
+#ifndef MYSQL_OUT_BUFFER_SIZE
+  #if defined(__AVR__)
+    #define MYSQL_OUT_BUFFER_SIZE 0
+  #else
+    #define MYSQL_OUT_BUFFER_SIZE 1460
+  #endif
+#endif
+
+// Size of the incoming read buffer. Bytes are read from the client in
+// blocks and packets that fit are used in place, so many small rows are
+// framed from one client read. Set to 0 to read each packet separately.
+#ifndef MYSQL_IN_BUFFER_SIZE
+  #if defined(__AVR__)
+    #define MYSQL_IN_BUFFER_SIZE 0
+  #else
+    #define MYSQL_IN_BUFFER_SIZE 2048
+  #endif
+#endif
+
+// Client error codes (the numbers used by the MySQL client library)
+#define MYSQL_CR_UNKNOWN_ERROR          2000
+#define MYSQL_CR_CONN_HOST_ERROR        2003
+#define MYSQL_CR_SERVER_GONE_ERROR      2006
+#define MYSQL_CR_OUT_OF_MEMORY          2008
+#define MYSQL_CR_SERVER_LOST            2013
+#define MYSQL_CR_COMMANDS_OUT_OF_SYNC   2014
+#define MYSQL_CR_SSL_CONNECTION_ERROR   2026
+#define MYSQL_CR_MALFORMED_PACKET       2027
+
+// Bytes kept of the last error message (including the terminator)
+#ifndef MYSQL_ERROR_MESSAGE_SIZE
+  #if defined(__AVR__)
+    #define MYSQL_ERROR_MESSAGE_SIZE 40
+  #else
+    #define MYSQL_ERROR_MESSAGE_SIZE 128
+  #endif
+#endif
+
+// Structure for the last error (see get_last_error()).
+typedef struct {
+  int code;           // server error number or MYSQL_CR_*, 0 = no error
+  char sql_state[6];  // SQLSTATE of a server error, empty otherwise
+  char message[MYSQL_ERROR_MESSAGE_SIZE];  // truncated to fit
+} mysql_error;
+
+/*
+  MySQL_Wait - Waits for the server on behalf of a connection
+
+  The connector sleeps with delay() between polls of the client. A driver
+  that runs many connections in one thread (see MySQL_Epoll.h) implements
+  wait() to run the other connections until this one has data to read or
+  the time is up.
+*/
+class MySQL_Wait {
+  public:
+    virtual ~MySQL_Wait() {}
+    virtual void wait(unsigned long ms) = 0;
+};
 
 const char MEMORY_ERROR[] PROGMEM = "Memory error.";
 const char PACKET_ERROR[] PROGMEM = "Packet error.";
@@ -60,16 +159,38 @@ class MySQL_Packet {
     int packet_len;         // length of current packet
     Client *client;         // instance of client class (e.g. EthernetClient)
     char *server_version;   // save server version from handshake
+    unsigned long server_capabilities;  // capability flags from handshake
+    unsigned long client_flags;         // capability flags we sent
+    int server_status;      // status flags from the last Ok or EOF packet
 
     MySQL_Packet(Client *client_instance);
     boolean complete_handshake(char *user, char *password);
     void send_authentication_packet(char *user, char *password,
                                     char *db=NULL);
     void parse_handshake_packet();
+    void send_ssl_request();
     boolean scramble_password(char *password, byte *pwd_hash);
     void read_packet();
+    int skip_packet();
+    int open_packet();
+    int read_payload(byte *dest, int len);
+    void free_buffer();
+    void write_packet(const byte *packet, int len);
+    void flush_packets();
+    void clear_packets();
     int get_packet_type();
+    int parse_server_status();
+    boolean eof_deprecated() {
+      return (client_flags & server_capabilities &
+              MYSQL_CLIENT_DEPRECATE_EOF) != 0;
+    }
+    boolean is_eof_packet();
     void parse_error_packet();
+    void set_error(int code, const char *msg);
+    void clear_error();
+    const mysql_error *get_last_error() { return &last_error; }
+    void set_last_error(const mysql_error *error) { last_error = *error; }
+    int get_error_code() { return last_error.code; }
     int get_lcb_len(int offset);
     int read_int(int offset, int size=0);
     void store_int(byte *buff, long value, int size);
@@ -77,9 +198,90 @@ class MySQL_Packet {
     int wait_for_bytes(int bytes_count);
     void show_error(const char *msg, bool EOL = false);
     void print_packet();
+    unsigned long get_packets_sent() { return packets_sent; }
+    unsigned long get_segments_sent() { return segments_sent; }
+    unsigned long get_bytes_sent() { return bytes_sent; }
+    void reset_write_stats();
+    unsigned long get_packets_read() { return packets_read; }
+    unsigned long get_client_reads() { return client_reads; }
+    void reset_read_stats();
+    void set_packet_source(const byte *data, int len);
+    void start_capture(unsigned long limit);
+    byte *end_capture(int *len);
+    void cancel_capture();
+    boolean capturing() { return capture_limit > 0; }
+    void set_timeout_bounds(unsigned long min_ms, unsigned long max_ms);
+    unsigned long get_timeout();
+    unsigned long get_srtt() { return srtt8 >> 3; }
+    unsigned long get_rttvar() { return rttvar4 >> 2; }
+    unsigned long get_rtt_samples() { return rtt_samples; }
+    unsigned long get_session() { return session; }
+    void set_wait(MySQL_Wait *w) { waiter = w; }
+    void idle(unsigned long ms);
+
+  protected:
+    MySQL_Wait *waiter;     // waits for the server, NULL = delay()
+    boolean ssl_requested;  // CLIENT_SSL sent, connection uses TLS
+
+    void start_session(IPAddress server, int port, const char *user,
+                       const char *db);
+    void change_session(const char *user, const char *db);
 
   private:
+    int store_login_header(byte *buff);
+    boolean wait_for_header();
+    boolean read_header(byte *header);
+    boolean read_bytes(byte *dest, int len);
+    void drop_payload();
+    int read_input(byte *dest, int len);
+    int frame_in_place();
+    void fill_input();
+    void rtt_sample(unsigned long rtt);
+    void read_source_packet();
+    void capture_packet();
+    void use_database(const char *db, int len);
+
     byte seed[20];
+    mysql_error last_error;
+    byte *source;           // packets read from memory (see MySQL_Cache)
+    int source_len;
+    int source_pos;
+    byte *capture;          // copy of the packets read while capturing
+    int capture_len;
+    int capture_size;
+    int capture_limit;
+#if MYSQL_OUT_BUFFER_SIZE > 0
+    byte out_buffer[MYSQL_OUT_BUFFER_SIZE];
+#endif
+    int out_len;
+#if MYSQL_IN_BUFFER_SIZE > 0
+    byte in_buffer[MYSQL_IN_BUFFER_SIZE];
+#endif
+    int in_head;              // first unread byte in in_buffer
+    int in_len;               // unread bytes in in_buffer
+    int in_held;              // bytes before in_head of the packet used
+                              // in place (buffer points there)
+    int payload_left;         // unread bytes of the packet from
+                              // open_packet()
+    unsigned long packets_read;
+    unsigned long client_reads;
+    unsigned long packets_sent;
+    unsigned long segments_sent;
+    unsigned long bytes_sent;
+    unsigned long srtt8;        // smoothed round trip time (ms * 8)
+    unsigned long rttvar4;      // round trip time variation (ms * 4)
+    unsigned long rtt_samples;
+    unsigned long request_time; // millis() when the last request was sent
+    boolean awaiting_reply;
+    boolean query_queued;       // a queued packet runs a statement
+    boolean awaiting_query;     // waiting for the reply to a statement
+    unsigned long server_key;   // hash of the server address and port
+    unsigned long login_key;    // server_key and the user name
+    unsigned long session;      // login_key and the default database
+                                // (see MySQL_Cache)
+    byte timeout_backoff;       // timeout doubles after each read timeout
+    unsigned long timeout_min;
+    unsigned long timeout_max;
 };
 
 #endif
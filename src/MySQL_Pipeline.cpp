@@ -0,0 +1,563 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Pipeline.cpp - Read from the server on a second core
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#include <Arduino.h>
+#include <MySQL_Pipeline.h>
+
+const char PIPELINE_MEMORY[] PROGMEM = "ERROR: No memory for the pipeline.";
+const char PIPELINE_TASK[] PROGMEM = "ERROR: Cannot start the pipeline task.";
+
+/*
+  The positions and flags shared by the task and the connection are read
+  and written atomically. Without a task everything runs in the caller.
+*/
+#if defined(MYSQL_PIPELINE_FREERTOS) || defined(MYSQL_PIPELINE_STD_THREAD)
+  #define PIPE_LOAD(var)        __atomic_load_n(&(var), __ATOMIC_SEQ_CST)
+  #define PIPE_STORE(var, val)  __atomic_store_n(&(var), (val), \
+                                                 __ATOMIC_SEQ_CST)
+#else
+  #define PIPE_LOAD(var)        (var)
+  #define PIPE_STORE(var, val)  ((var) = (val))
+#endif
+
+/*
+  Constructor
+
+  client_instance[in] client connected to the server
+*/
+MySQL_Pipeline::MySQL_Pipeline(Client *client_instance) {
+  client = client_instance;
+  ring = NULL;
+  ring_size = 0;
+  head = 0;
+  tail = 0;
+  written = 0;
+  packet_start = 0;
+  packet_end = 0;
+  active = 0;
+  running = 0;
+  full = 0;
+  waiting = 0;
+  reset_stats();
+#ifdef MYSQL_PIPELINE_FREERTOS
+  mutex = NULL;
+  data_ready = NULL;
+  space_ready = NULL;
+  task_done = 0;
+#endif
+}
+
+
+/*
+  Destructor
+*/
+MySQL_Pipeline::~MySQL_Pipeline() {
+  end();
+}
+
+
+/*
+  begin - Allocate the queue and start the I/O task
+
+  size[in]        bytes in the queue, rounded down to a power of two
+                  (64 at least). Use at least the largest row.
+
+  Returns boolean - True = started
+*/
+boolean MySQL_Pipeline::begin(int size) {
+  int bytes = 64;
+
+  if (ring)
+    return true;
+  while (bytes <= size / 2)
+    bytes *= 2;
+  ring = (byte *)mysql_malloc(bytes, MYSQL_ALLOC_PIPELINE);
+  if (ring == NULL) {
+    MYSQL_LOG_E(MYSQL_P(PIPELINE_MEMORY));
+    return false;
+  }
+  ring_size = bytes;
+  running = 1;
+#ifdef MYSQL_PIPELINE_FREERTOS
+  BaseType_t created = pdFAIL;
+
+  mutex = xSemaphoreCreateMutex();
+  data_ready = xSemaphoreCreateBinary();
+  space_ready = xSemaphoreCreateBinary();
+  task_done = 0;
+  if (mutex && data_ready && space_ready) {
+  #if portNUM_PROCESSORS > 1
+    // Run on the core the sketch does not use
+    created = xTaskCreatePinnedToCore(task_main, "mysql_io",
+                                      MYSQL_PIPELINE_STACK, this,
+                                      MYSQL_PIPELINE_PRIORITY, NULL,
+                                      xPortGetCoreID() == 0 ? 1 : 0);
+  #else
+    created = xTaskCreate(task_main, "mysql_io", MYSQL_PIPELINE_STACK, this,
+                          MYSQL_PIPELINE_PRIORITY, NULL);
+  #endif
+  }
+  if (created != pdPASS) {
+    MYSQL_LOG_E(MYSQL_P(PIPELINE_TASK));
+    task_done = 1;
+    end();
+    return false;
+  }
+#endif
+#ifdef MYSQL_PIPELINE_STD_THREAD
+  task = std::thread(&MySQL_Pipeline::run, this);
+#endif
+  return true;
+}
+
+
+/*
+  end - Close the connection, stop the I/O task and free the queue
+*/
+void MySQL_Pipeline::end() {
+  if (ring == NULL)
+    return;
+  stop();
+  PIPE_STORE(running, 0);
+  notify_space();
+#ifdef MYSQL_PIPELINE_FREERTOS
+  while (!PIPE_LOAD(task_done))
+    delay(1);
+  if (mutex)
+    vSemaphoreDelete(mutex);
+  if (data_ready)
+    vSemaphoreDelete(data_ready);
+  if (space_ready)
+    vSemaphoreDelete(space_ready);
+  mutex = NULL;
+  data_ready = NULL;
+  space_ready = NULL;
+#endif
+#ifdef MYSQL_PIPELINE_STD_THREAD
+  if (task.joinable())
+    task.join();
+#endif
+  mysql_free(ring);
+  ring = NULL;
+  ring_size = 0;
+}
+
+
+/*
+  connect - Connect the real client and start reading from it
+*/
+int MySQL_Pipeline::connect(IPAddress ip, uint16_t port) {
+  int result;
+
+  if (ring == NULL && !begin())
+    return 0;
+  lock();
+  PIPE_STORE(active, 0);
+  head = tail = written = packet_start = packet_end = 0;
+  PIPE_STORE(full, 0);
+  result = client->connect(ip, port);
+  if (result)
+    PIPE_STORE(active, 1);
+  unlock();
+  return result;
+}
+
+
+int MySQL_Pipeline::connect(const char *host, uint16_t port) {
+  int result;
+
+  if (ring == NULL && !begin())
+    return 0;
+  lock();
+  PIPE_STORE(active, 0);
+  head = tail = written = packet_start = packet_end = 0;
+  PIPE_STORE(full, 0);
+  result = client->connect(host, port);
+  if (result)
+    PIPE_STORE(active, 1);
+  unlock();
+  return result;
+}
+
+
+size_t MySQL_Pipeline::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+
+size_t MySQL_Pipeline::write(const uint8_t *buf, size_t size) {
+  size_t num;
+
+  lock();
+  num = client->write(buf, size);
+  unlock();
+  return num;
+}
+
+
+/*
+  available - Bytes of complete packets in the queue
+*/
+int MySQL_Pipeline::available() {
+  if (ring == NULL)
+    return 0;
+#if !defined(MYSQL_PIPELINE_FREERTOS) && !defined(MYSQL_PIPELINE_STD_THREAD)
+  while (pump())
+    ;
+#endif
+  return (int)(PIPE_LOAD(head) - tail);
+}
+
+
+int MySQL_Pipeline::read() {
+  uint8_t b;
+
+  if (read(&b, 1) < 1)
+    return -1;
+  return b;
+}
+
+
+/*
+  read - Take bytes from the queue
+
+  The I/O task is woken if it waits for space.
+*/
+int MySQL_Pipeline::read(uint8_t *buf, size_t size) {
+  int num = available();
+  int pos;
+  int first;
+
+  if (num <= 0)
+    return -1;
+  if ((size_t)num > size)
+    num = size;
+  pos = tail & (ring_size - 1);
+  first = ring_size - pos;
+  if (first > num)
+    first = num;
+  memcpy(buf, ring + pos, first);
+  if (num > first)
+    memcpy(buf + first, ring, num - first);
+  PIPE_STORE(tail, tail + num);
+  if (PIPE_LOAD(full)) {
+    PIPE_STORE(full, 0);
+    notify_space();
+  }
+  return num;
+}
+
+
+int MySQL_Pipeline::peek() {
+  if (available() <= 0)
+    return -1;
+  return ring[tail & (ring_size - 1)];
+}
+
+
+void MySQL_Pipeline::flush() {
+  lock();
+  client->flush();
+  unlock();
+}
+
+
+/*
+  stop - Close the real client and drop the queued bytes
+*/
+void MySQL_Pipeline::stop() {
+  lock();
+  PIPE_STORE(active, 0);
+  client->stop();
+  head = tail = written = packet_start = packet_end = 0;
+  PIPE_STORE(full, 0);
+  unlock();
+}
+
+
+/*
+  connected - Check the real client
+
+  Returns uint8_t - 1 while it is connected or bytes are queued
+*/
+uint8_t MySQL_Pipeline::connected() {
+  uint8_t result;
+
+  if (ring && PIPE_LOAD(head) != tail)
+    return 1;
+  lock();
+  result = client->connected();
+  unlock();
+  return result;
+}
+
+
+/*
+  wait - Wait until a packet is queued (see MySQL_Wait)
+
+  ms[in]          milliseconds to wait at most
+*/
+void MySQL_Pipeline::wait(unsigned long ms) {
+  if (available() > 0)
+    return;
+#if defined(MYSQL_PIPELINE_FREERTOS) || defined(MYSQL_PIPELINE_STD_THREAD)
+  if (!PIPE_LOAD(active)) {
+    delay(ms);
+    return;
+  }
+  PIPE_STORE(waiting, 1);
+  if (available() == 0)
+    wait_data(ms);
+  PIPE_STORE(waiting, 0);
+#else
+  delay(ms);
+#endif
+}
+
+
+/*
+  depth - Bytes of complete packets in the queue
+
+  Returns integer - bytes not read yet
+*/
+int MySQL_Pipeline::depth() {
+  if (ring == NULL)
+    return 0;
+  return (int)(PIPE_LOAD(head) - tail);
+}
+
+
+/*
+  reset_stats - Reset the statistics
+*/
+void MySQL_Pipeline::reset_stats() {
+  max_depth = 0;
+  packets = 0;
+  stalls = 0;
+}
+
+
+/*
+  pump - Read what the real client has into the queue
+
+  Called by the I/O task (or by available() without a task).
+
+  Returns boolean - True if bytes were read
+*/
+boolean MySQL_Pipeline::pump() {
+  int num = 0;
+  int space;
+  int pos;
+
+  lock();
+  if (PIPE_LOAD(active)) {
+    space = ring_size - (int)(written - PIPE_LOAD(tail));
+    if (space == 0) {
+      if (!PIPE_LOAD(full)) {
+        stalls++;
+        PIPE_STORE(full, 1);
+        // The connection may have read since tail was loaded
+        if ((int)(written - PIPE_LOAD(tail)) < ring_size)
+          PIPE_STORE(full, 0);
+      }
+    } else {
+      pos = written & (ring_size - 1);
+      if (space > ring_size - pos)
+        space = ring_size - pos;
+      num = client->available();
+      if (num > 0) {
+        num = client->read(ring + pos, num < space ? num : space);
+        if (num > 0) {
+          written += num;
+          frame();
+        }
+      }
+    }
+  }
+  unlock();
+  return num > 0;
+}
+
+
+/*
+  frame - Make the packets completed by the last read available
+
+  The header of each packet gives its end. A packet that cannot fit in
+  the queue is made available as it arrives.
+*/
+void MySQL_Pipeline::frame() {
+  unsigned long mask = ring_size - 1;
+  unsigned long len;
+
+  for (;;) {
+    if (packet_end == packet_start) {
+      if (written - packet_start < 4)
+        return;
+      len = ring[packet_start & mask];
+      len += (unsigned long)ring[(packet_start + 1) & mask] << 8;
+      len += (unsigned long)ring[(packet_start + 2) & mask] << 16;
+      packet_end = packet_start + 4 + len;
+      packets++;
+    }
+    if ((long)(written - packet_end) < 0) {
+      if (packet_end - packet_start > (unsigned long)ring_size)
+        publish(written);
+      return;
+    }
+    packet_start = packet_end;
+    publish(packet_start);
+  }
+}
+
+
+/*
+  publish - Make the queued bytes up to a position available
+
+  pos[in]         end of the bytes
+*/
+void MySQL_Pipeline::publish(unsigned long pos) {
+  int queued;
+
+  PIPE_STORE(head, pos);
+  queued = (int)(pos - PIPE_LOAD(tail));
+  if (queued > max_depth)
+    max_depth = queued;
+  if (PIPE_LOAD(waiting))
+    notify_data();
+}
+
+
+/*
+  run - Loop of the I/O task
+
+  Reads while the client has data and the queue has space, otherwise
+  sleeps until the connection reads or for a short time.
+*/
+void MySQL_Pipeline::run() {
+  while (PIPE_LOAD(running)) {
+    if (!pump())
+      wait_space();
+  }
+}
+
+
+#ifdef MYSQL_PIPELINE_FREERTOS
+void MySQL_Pipeline::task_main(void *arg) {
+  MySQL_Pipeline *pipeline = (MySQL_Pipeline *)arg;
+
+  pipeline->run();
+  PIPE_STORE(pipeline->task_done, 1);
+  vTaskDelete(NULL);
+}
+#endif
+
+
+void MySQL_Pipeline::lock() {
+#ifdef MYSQL_PIPELINE_FREERTOS
+  if (mutex)
+    xSemaphoreTake(mutex, portMAX_DELAY);
+#endif
+#ifdef MYSQL_PIPELINE_STD_THREAD
+  mutex.lock();
+#endif
+}
+
+
+void MySQL_Pipeline::unlock() {
+#ifdef MYSQL_PIPELINE_FREERTOS
+  if (mutex)
+    xSemaphoreGive(mutex);
+#endif
+#ifdef MYSQL_PIPELINE_STD_THREAD
+  mutex.unlock();
+#endif
+}
+
+
+/*
+  notify_data - Wake the connection waiting in wait()
+*/
+void MySQL_Pipeline::notify_data() {
+#ifdef MYSQL_PIPELINE_FREERTOS
+  xSemaphoreGive(data_ready);
+#endif
+#ifdef MYSQL_PIPELINE_STD_THREAD
+  { std::lock_guard<std::mutex> guard(signal_mutex); }
+  data_ready.notify_one();
+#endif
+}
+
+
+/*
+  notify_space - Wake the I/O task waiting for space
+*/
+void MySQL_Pipeline::notify_space() {
+#ifdef MYSQL_PIPELINE_FREERTOS
+  if (space_ready)
+    xSemaphoreGive(space_ready);
+#endif
+#ifdef MYSQL_PIPELINE_STD_THREAD
+  { std::lock_guard<std::mutex> guard(signal_mutex); }
+  space_ready.notify_one();
+#endif
+}
+
+
+/*
+  wait_data - Sleep until a packet is queued
+
+  ms[in]          milliseconds to wait at most
+*/
+void MySQL_Pipeline::wait_data(unsigned long ms) {
+#ifdef MYSQL_PIPELINE_FREERTOS
+  xSemaphoreTake(data_ready, pdMS_TO_TICKS(ms));
+#endif
+#ifdef MYSQL_PIPELINE_STD_THREAD
+  std::unique_lock<std::mutex> guard(signal_mutex);
+  data_ready.wait_for(guard, std::chrono::milliseconds(ms), [this] {
+    return PIPE_LOAD(head) != tail || !PIPE_LOAD(active);
+  });
+#endif
+}
+
+
+/*
+  wait_space - Sleep until the queue has space or the client may have data
+*/
+void MySQL_Pipeline::wait_space() {
+#ifdef MYSQL_PIPELINE_FREERTOS
+  if (PIPE_LOAD(full))
+    xSemaphoreTake(space_ready, pdMS_TO_TICKS(10));
+  else
+    vTaskDelay(1);
+#endif
+#ifdef MYSQL_PIPELINE_STD_THREAD
+  std::unique_lock<std::mutex> guard(signal_mutex);
+  if (PIPE_LOAD(full))
+    space_ready.wait_for(guard, std::chrono::milliseconds(10), [this] {
+      return !PIPE_LOAD(full) || !PIPE_LOAD(running);
+    });
+  else
+    space_ready.wait_for(guard,
+                         std::chrono::microseconds(MYSQL_PIPELINE_POLL_US));
+#endif
+}
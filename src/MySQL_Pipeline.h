@@ -0,0 +1,163 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Pipeline.h - Read from the server on a second core
+
+  This header file defines a Client class that wraps the real client
+  (e.g. WiFiClient) and reads from it in a task of its own: a FreeRTOS
+  task on the other core of the ESP32, a thread on host builds. The task
+  frames the packets coming from the server into a queue while the
+  sketch decodes the rows already received, so a large result set is
+  read at the speed of the network instead of network time plus parse
+  time.
+
+  The queue is a ring buffer with one writer (the I/O task) and one
+  reader (the connection), so it needs no lock. Packets are made
+  available once they are complete; a packet longer than the queue is
+  made available as it arrives. When the queue is full the task stops
+  reading and the server is held back by TCP flow control until the
+  sketch catches up.
+
+  Writes, connect() and stop() go to the real client directly, under a
+  lock shared with the task. Use the pipeline as the outermost client
+  (over TLS, not under it). begin() allocates the queue and starts the
+  task; the first connect() calls it if the sketch did not. Set the
+  pipeline as the wait of the connection too so the sketch sleeps until
+  the task has a packet instead of polling:
+
+    WiFiClient client;
+    MySQL_Pipeline pipeline(&client);
+    MySQL_Connection conn(&pipeline);
+    ...
+    pipeline.begin(16384);
+    conn.set_wait(&pipeline);
+
+  Boards without FreeRTOS or threads (AVR, ESP8266) read from the real
+  client when the connection asks for data, without overlap.
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_PIPELINE_H
+#define MYSQL_PIPELINE_H
+
+#include <MySQL_Packet.h>
+
+// Default size of the queue (rounded down to a power of two)
+#ifndef MYSQL_PIPELINE_SIZE
+  #if defined(__AVR__)
+    #define MYSQL_PIPELINE_SIZE  256
+  #else
+    #define MYSQL_PIPELINE_SIZE  8192
+  #endif
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32) && !defined(MYSQL_PIPELINE_NO_FREERTOS)
+  #define MYSQL_PIPELINE_FREERTOS
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/semphr.h>
+  #include <freertos/task.h>
+  #ifndef MYSQL_PIPELINE_STACK
+    #define MYSQL_PIPELINE_STACK     3072  // stack of the I/O task (bytes)
+  #endif
+  #ifndef MYSQL_PIPELINE_PRIORITY
+    #define MYSQL_PIPELINE_PRIORITY  1
+  #endif
+#elif !defined(ARDUINO) && !defined(MYSQL_PIPELINE_NO_STD_THREAD)
+  #define MYSQL_PIPELINE_STD_THREAD
+  #include <thread>
+  #include <mutex>
+  #include <condition_variable>
+  #ifndef MYSQL_PIPELINE_POLL_US
+    #define MYSQL_PIPELINE_POLL_US   100   // poll of an idle socket
+  #endif
+#endif
+
+class MySQL_Pipeline : public Client, public MySQL_Wait {
+  public:
+    MySQL_Pipeline(Client *client_instance);
+    ~MySQL_Pipeline();
+    boolean begin(int size=MYSQL_PIPELINE_SIZE);
+    void end();
+    int connect(IPAddress ip, uint16_t port);
+    int connect(const char *host, uint16_t port);
+    size_t write(uint8_t b);
+    size_t write(const uint8_t *buf, size_t size);
+    int available();
+    int read();
+    int read(uint8_t *buf, size_t size);
+    int peek();
+    void flush();
+    void stop();
+    uint8_t connected();
+    operator bool() { return connected(); }
+    using Print::write;
+    void wait(unsigned long ms);
+    int depth();
+    int get_size() { return ring_size; }
+    int get_max_depth() { return max_depth; }
+    unsigned long get_packets() { return packets; }
+    unsigned long get_stalls() { return stalls; }
+    void reset_stats();
+
+  private:
+    boolean pump();
+    void frame();
+    void publish(unsigned long pos);
+    void run();
+    void lock();
+    void unlock();
+    void notify_data();
+    void notify_space();
+    void wait_data(unsigned long ms);
+    void wait_space();
+#ifdef MYSQL_PIPELINE_FREERTOS
+    static void task_main(void *arg);
+#endif
+
+    Client *client;
+    byte *ring;
+    int ring_size;                 // a power of two
+    unsigned long head;            // end of the bytes made available
+    unsigned long tail;            // end of the bytes read
+    unsigned long written;         // end of the bytes in the queue
+    unsigned long packet_start;    // packet being framed
+    unsigned long packet_end;      // ... its end, = packet_start before
+                                   // its header is read
+    volatile byte active;          // the task reads from the client
+    volatile byte running;         // the task runs
+    byte full;                     // the task waits for space
+    byte waiting;                  // the connection waits for data
+    int max_depth;
+    unsigned long packets;
+    unsigned long stalls;          // times the queue was full
+#ifdef MYSQL_PIPELINE_FREERTOS
+    SemaphoreHandle_t mutex;
+    SemaphoreHandle_t data_ready;
+    SemaphoreHandle_t space_ready;
+    volatile byte task_done;
+#endif
+#ifdef MYSQL_PIPELINE_STD_THREAD
+    std::thread task;
+    std::mutex mutex;
+    std::mutex signal_mutex;
+    std::condition_variable data_ready;
+    std::condition_variable space_ready;
+#endif
+};
+
+#endif
@@ -0,0 +1,323 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Pool.cpp - Fixed size pool of connections to a MySQL Server
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#include <Arduino.h>
+#include <new>
+#include <MySQL_Pool.h>
+
+const char POOL_EXHAUSTED[] PROGMEM = "ERROR: No pooled connection available.";
+const char POOL_CONNECT[] PROGMEM = "ERROR: Pooled connection failed.";
+
+/*
+  Slot claims are lock-free on targets with atomics. AVR boards have a
+  single core and no preemptive tasks so a plain test-and-set is enough.
+*/
+#if defined(__AVR__)
+static boolean claim_slot(volatile byte *flag) {
+  if (*flag)
+    return false;
+  *flag = 1;
+  return true;
+}
+
+static void free_slot(volatile byte *flag) {
+  *flag = 0;
+}
+#else
+static boolean claim_slot(volatile byte *flag) {
+  byte expected = 0;
+  return __atomic_compare_exchange_n(flag, &expected, 1, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static void free_slot(volatile byte *flag) {
+  __atomic_store_n(flag, 0, __ATOMIC_RELEASE);
+}
+#endif
+
+
+#ifdef MYSQL_POOL_FREERTOS
+MySQL_Pool_Sync_FreeRTOS::MySQL_Pool_Sync_FreeRTOS(int permits) {
+  mutex = xSemaphoreCreateMutex();
+  free_count = xSemaphoreCreateCounting(permits, permits);
+}
+
+MySQL_Pool_Sync_FreeRTOS::~MySQL_Pool_Sync_FreeRTOS() {
+  vSemaphoreDelete(mutex);
+  vSemaphoreDelete(free_count);
+}
+
+void MySQL_Pool_Sync_FreeRTOS::lock() {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+}
+
+void MySQL_Pool_Sync_FreeRTOS::unlock() {
+  xSemaphoreGive(mutex);
+}
+
+boolean MySQL_Pool_Sync_FreeRTOS::acquire(unsigned long timeout_ms) {
+  return xSemaphoreTake(free_count, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+void MySQL_Pool_Sync_FreeRTOS::release() {
+  xSemaphoreGive(free_count);
+}
+#endif  // MYSQL_POOL_FREERTOS
+
+
+#ifdef MYSQL_POOL_STD_MUTEX
+boolean MySQL_Pool_Sync_Std::acquire(unsigned long timeout_ms) {
+  std::unique_lock<std::mutex> guard(count_mutex);
+  if (!count_changed.wait_for(guard, std::chrono::milliseconds(timeout_ms),
+                              [this] { return permits > 0; }))
+    return false;
+  permits--;
+  return true;
+}
+
+void MySQL_Pool_Sync_Std::release() {
+  {
+    std::lock_guard<std::mutex> guard(count_mutex);
+    permits++;
+  }
+  count_changed.notify_one();
+}
+#endif  // MYSQL_POOL_STD_MUTEX
+
+
+/*
+  Constructor
+
+  Creates one MySQL_Connection for each client. The clients must be
+  separate instances (e.g. one WiFiClient per pooled connection) and
+  must outlive the pool. The connections are allocated with
+  mysql_malloc(); if memory runs out the pool is smaller (see size()).
+
+  clients[in]     Array of client instances
+  size[in]        Number of clients (up to MYSQL_POOL_MAX)
+  sync[in]        (optional) synchronization for multi-task use. It must
+                  be created with size permits.
+*/
+MySQL_Pool::MySQL_Pool(Client **clients, int size, MySQL_Pool_Sync *sync) {
+  if (size > MYSQL_POOL_MAX)
+    size = MYSQL_POOL_MAX;
+  pool_size = size;
+  this->sync = sync;
+  for (int i = 0; i < MYSQL_POOL_MAX; i++) {
+    conns[i] = NULL;
+    in_use[i] = 0;
+    last_used[i] = 0;
+  }
+  for (int i = 0; i < size; i++) {
+    void *mem = mysql_malloc(sizeof(MySQL_Connection), MYSQL_ALLOC_POOL);
+    if (mem == NULL) {
+      MYSQL_LOG_E(MYSQL_P(MEMORY_ERROR));
+      pool_size = i;
+      break;
+    }
+    conns[i] = new (mem) MySQL_Connection(clients[i]);
+  }
+  port = 3306;
+  user = NULL;
+  password = NULL;
+  db = NULL;
+}
+
+
+/*
+  Destructor
+*/
+MySQL_Pool::~MySQL_Pool() {
+  close();
+  for (int i = 0; i < pool_size; i++) {
+    conns[i]->~MySQL_Connection();
+    mysql_free(conns[i]);
+  }
+}
+
+
+/*
+  begin - Store the server and credentials used by the pool
+
+  Connections are opened lazily by checkout() so a pool sized for the
+  worst case does not hold idle sessions on the server. The strings are
+  not copied and must remain valid while the pool is in use.
+
+  server[in]      IP address of the server as IPAddress type
+  port[in]        port number of the server
+  user[in]        user name
+  password[in]    (optional) user password
+  db[in]          (optional) default database
+*/
+void MySQL_Pool::begin(IPAddress server, int port, char *user,
+                       char *password, char *db)
+{
+  this->server = server;
+  this->port = port;
+  this->user = user;
+  this->password = password;
+  this->db = db;
+}
+
+
+/*
+  checkout - Get exclusive use of a pooled connection
+
+  This method waits up to timeout_ms for a connection to become free.
+  The connection is validated (and reopened if needed) before it is
+  returned. Return it to the pool with checkin() when done.
+
+  timeout_ms[in]  Time to wait for a free connection in milliseconds
+
+  Returns MySQL_Connection * - connection or NULL if none became free
+*/
+MySQL_Connection *MySQL_Pool::checkout(unsigned long timeout_ms) {
+  MySQL_Connection *conn = NULL;
+
+  if (sync) {
+    if (sync->acquire(timeout_ms))
+      conn = claim();
+  } else {
+    const unsigned long started = millis();
+    while ((conn = claim()) == NULL && millis() - started < timeout_ms)
+      delay(1);
+  }
+  if (conn == NULL && timeout_ms > 0 && pool_size > 0)
+    MYSQL_LOG_W(MYSQL_P(POOL_EXHAUSTED));
+  return conn;
+}
+
+
+/*
+  try_checkout - Get a pooled connection without waiting
+
+  Returns MySQL_Connection * - connection or NULL if all are in use
+*/
+MySQL_Connection *MySQL_Pool::try_checkout() {
+  return checkout(0);
+}
+
+
+/*
+  checkin - Return a connection to the pool
+
+  connection[in]  Connection obtained from checkout()
+*/
+void MySQL_Pool::checkin(MySQL_Connection *connection) {
+  for (int i = 0; i < pool_size; i++) {
+    if (conns[i] == connection && in_use[i]) {
+      last_used[i] = millis();
+      free_slot(&in_use[i]);
+      if (sync)
+        sync->release();
+      return;
+    }
+  }
+}
+
+
+/*
+  close - Close all connections that are not checked out
+*/
+void MySQL_Pool::close() {
+  for (int i = 0; i < pool_size; i++) {
+    if (claim_slot(&in_use[i])) {
+      conns[i]->close();
+      free_slot(&in_use[i]);
+    }
+  }
+}
+
+
+/*
+  available - Number of connections not checked out
+
+  The value is only a hint when other tasks use the pool.
+*/
+int MySQL_Pool::available() {
+  int num = 0;
+  for (int i = 0; i < pool_size; i++) {
+    if (!in_use[i])
+      num++;
+  }
+  return num;
+}
+
+
+/*
+  claim - Claim the first free and healthy slot
+
+  Free slots are claimed with a compare and swap so the fast path needs
+  no lock. A slot that fails validation is released again and the scan
+  goes on with the next one. When no slot is returned the permit taken
+  by checkout() is given back, also when the free slots were held for
+  a moment by another task (e.g. close()).
+
+  Returns MySQL_Connection * - claimed connection or NULL
+*/
+MySQL_Connection *MySQL_Pool::claim() {
+  for (int i = 0; i < pool_size; i++) {
+    if (!in_use[i] && claim_slot(&in_use[i])) {
+      if (validate(i))
+        return conns[i];
+      free_slot(&in_use[i]);
+    }
+  }
+  if (sync)
+    sync->release();
+  return NULL;
+}
+
+
+/*
+  validate - Make sure a claimed connection is usable
+
+  Connections that were never opened or were dropped are (re)opened.
+  Connections idle longer than MYSQL_POOL_IDLE_MS are pinged first
+  since the server may have timed them out.
+
+  slot[in]        Index of the claimed connection
+
+  Returns boolean - True = connection is ready for queries
+*/
+boolean MySQL_Pool::validate(int slot) {
+  MySQL_Connection *conn = conns[slot];
+  boolean healthy = conn->connected();
+
+  if (healthy && millis() - last_used[slot] >= MYSQL_POOL_IDLE_MS) {
+    healthy = conn->ping();
+    if (!healthy)
+      conn->close();
+  }
+  if (!healthy && user) {
+    // The authentication scramble uses the shared SHA1 instance.
+    if (sync)
+      sync->lock();
+    healthy = conn->connect(server, port, user, password, db);
+    if (sync)
+      sync->unlock();
+    if (!healthy)
+      MYSQL_LOG_E(MYSQL_P(POOL_CONNECT));
+  }
+  last_used[slot] = millis();
+  return healthy;
+}
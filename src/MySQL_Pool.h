@@ -0,0 +1,130 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Pool.h - Fixed size pool of connections to a MySQL Server
+
+  This header file defines a pool of MySQL_Connection instances that may
+  be shared by several tasks (ESP32 dual-core, FreeRTOS) or threads (host
+  builds). Each connection owns its own client (socket) and packet buffer
+  so a task that has checked out a connection may run queries in parallel
+  with the other tasks.
+
+  The waiting and locking primitives are supplied by a MySQL_Pool_Sync
+  instance. Implementations are provided for FreeRTOS and std::mutex.
+  Without one, the pool works for a single task and checkout() polls.
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_POOL_H
+#define MYSQL_POOL_H
+
+#include <MySQL_Connection.h>
+
+#define MYSQL_POOL_MAX        4       // Maximum number of pooled connections
+#define MYSQL_POOL_WAIT_MS    5000    // Default wait in checkout()
+#define MYSQL_POOL_IDLE_MS    30000   // Ping connections idle this long
+
+#if defined(ARDUINO_ARCH_ESP32) && !defined(MYSQL_POOL_NO_FREERTOS)
+  #define MYSQL_POOL_FREERTOS
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/semphr.h>
+#elif !defined(ARDUINO) && !defined(MYSQL_POOL_NO_STD_MUTEX)
+  #define MYSQL_POOL_STD_MUTEX
+  #include <mutex>
+  #include <condition_variable>
+#endif
+
+/*
+  MySQL_Pool_Sync - Synchronization used by the pool
+
+  lock()/unlock() protect the slow paths (opening a connection uses the
+  shared SHA1 instance). acquire()/release() count the free connections
+  so a blocked checkout() sleeps instead of spinning.
+*/
+class MySQL_Pool_Sync {
+  public:
+    virtual ~MySQL_Pool_Sync() {}
+    virtual void lock() = 0;
+    virtual void unlock() = 0;
+    virtual boolean acquire(unsigned long timeout_ms) = 0;
+    virtual void release() = 0;
+};
+
+#ifdef MYSQL_POOL_FREERTOS
+class MySQL_Pool_Sync_FreeRTOS : public MySQL_Pool_Sync {
+  public:
+    MySQL_Pool_Sync_FreeRTOS(int permits);
+    ~MySQL_Pool_Sync_FreeRTOS();
+    void lock();
+    void unlock();
+    boolean acquire(unsigned long timeout_ms);
+    void release();
+
+  private:
+    SemaphoreHandle_t mutex;
+    SemaphoreHandle_t free_count;
+};
+#endif
+
+#ifdef MYSQL_POOL_STD_MUTEX
+class MySQL_Pool_Sync_Std : public MySQL_Pool_Sync {
+  public:
+    MySQL_Pool_Sync_Std(int permits) : permits(permits) {}
+    void lock() { mutex.lock(); }
+    void unlock() { mutex.unlock(); }
+    boolean acquire(unsigned long timeout_ms);
+    void release();
+
+  private:
+    std::mutex mutex;
+    std::mutex count_mutex;
+    std::condition_variable count_changed;
+    int permits;
+};
+#endif
+
+class MySQL_Pool {
+  public:
+    MySQL_Pool(Client **clients, int size, MySQL_Pool_Sync *sync=NULL);
+    ~MySQL_Pool();
+    void begin(IPAddress server, int port, char *user, char *password,
+               char *db=NULL);
+    MySQL_Connection *checkout(unsigned long timeout_ms=MYSQL_POOL_WAIT_MS);
+    MySQL_Connection *try_checkout();
+    void checkin(MySQL_Connection *connection);
+    void close();
+    int size() { return pool_size; }
+    int available();
+
+  private:
+    MySQL_Connection *claim();
+    boolean validate(int slot);
+
+    MySQL_Connection *conns[MYSQL_POOL_MAX];
+    volatile byte in_use[MYSQL_POOL_MAX];
+    unsigned long last_used[MYSQL_POOL_MAX];
+    int pool_size;
+    MySQL_Pool_Sync *sync;
+    IPAddress server;
+    int port;
+    char *user;
+    char *password;
+    char *db;
+};
+
+#endif
@@ -0,0 +1,392 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Posix_Client.cpp - Client over a POSIX socket for host builds
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#include <MySQL_Posix_Client.h>
+
+#ifdef MYSQL_POSIX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#define RX_MASK  (MYSQL_POSIX_RX_SIZE - 1)
+
+#if (MYSQL_POSIX_RX_SIZE & RX_MASK) != 0
+  #error "MYSQL_POSIX_RX_SIZE must be a power of two"
+#endif
+
+/*
+  Constructor
+*/
+MySQL_Posix_Client::MySQL_Posix_Client() {
+  fd = -1;
+  in_progress = false;
+  peer_closed = false;
+  waiter = NULL;
+  rx_head = 0;
+  rx_tail = 0;
+  tx = NULL;
+  tx_len = 0;
+  tx_size = 0;
+  read_calls = 0;
+  write_calls = 0;
+}
+
+
+/*
+  Destructor
+*/
+MySQL_Posix_Client::~MySQL_Posix_Client() {
+  stop();
+  free(tx);
+}
+
+
+/*
+  connect - Open a TCP connection to a server
+
+  The socket is non-blocking with TCP_NODELAY set. While the connection
+  is being set up the thread sleeps in poll(), or the MySQL_Wait set with
+  set_wait() runs something else.
+
+  ip[in]          server IP address
+  port[in]        server port
+
+  Returns integer - 1 if connected, a negative value on failure
+*/
+int MySQL_Posix_Client::connect(IPAddress ip, uint16_t port) {
+  struct sockaddr_in addr;
+  const unsigned long started = millis();
+  int one = 1;
+  int err = 0;
+  socklen_t err_len = sizeof(err);
+
+  stop();
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = (uint32_t)ip;   // IPAddress keeps network order
+  if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    if (errno != EINPROGRESS) {
+      stop();
+      return -1;
+    }
+    in_progress = true;
+    while (in_progress) {
+      struct pollfd p = { fd, POLLOUT, 0 };
+      unsigned long waited = millis() - started;
+      if (waited >= MYSQL_POSIX_CONNECT_TIMEOUT) {
+        stop();
+        return -2;
+      }
+      if (waiter) {
+        waiter->wait(MYSQL_POSIX_CONNECT_TIMEOUT - waited);
+        poll(&p, 1, 0);
+      } else {
+        poll(&p, 1, MYSQL_POSIX_CONNECT_TIMEOUT - waited);
+      }
+      if (p.revents)
+        in_progress = false;
+    }
+  }
+  if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &err_len) < 0 || err) {
+    stop();
+    return -3;
+  }
+  return 1;
+}
+
+
+/*
+  connect - Open a TCP connection to a server by name
+
+  host[in]        server host name or IPv4 address
+  port[in]        server port
+
+  Returns integer - 1 if connected, a negative value on failure
+*/
+int MySQL_Posix_Client::connect(const char *host, uint16_t port) {
+  struct addrinfo hints, *found = NULL;
+  uint32_t address;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, NULL, &hints, &found) != 0 || found == NULL)
+    return -4;
+  address = ((struct sockaddr_in *)found->ai_addr)->sin_addr.s_addr;
+  freeaddrinfo(found);
+  return connect(IPAddress(address), port);
+}
+
+
+size_t MySQL_Posix_Client::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+
+/*
+  write - Send bytes to the server
+
+  Bytes the socket does not take now are kept and sent by the next write
+  or poll, so the caller never blocks.
+
+  buf[in]         bytes to send
+  size[in]        number of bytes
+
+  Returns size_t - size, or 0 if the connection is closed
+*/
+size_t MySQL_Posix_Client::write(const uint8_t *buf, size_t size) {
+  int left;
+
+  if (fd < 0)
+    return 0;
+  left = send_pending(buf, size);
+  if (left < 0)
+    return 0;
+  if (left > 0) {
+    if (tx_len + left > tx_size) {
+      size_t grown = tx_size ? tx_size : 256;
+      byte *bigger;
+      while (grown < tx_len + left)
+        grown *= 2;
+      bigger = (byte *)realloc(tx, grown);
+      if (bigger == NULL) {
+        stop();
+        return 0;
+      }
+      tx = bigger;
+      tx_size = grown;
+    }
+    memcpy(tx + tx_len, buf + size - left, left);
+    tx_len += left;
+  }
+  return size;
+}
+
+
+/*
+  available - Get the number of bytes received
+
+  Sends what is pending and receives what the socket has (one readv()).
+
+  Returns integer - bytes that can be read without waiting
+*/
+int MySQL_Posix_Client::available() {
+  if (tx_len)
+    send_pending(NULL, 0);
+  fill();
+  return (int)(rx_tail - rx_head);
+}
+
+
+int MySQL_Posix_Client::read() {
+  if (rx_tail == rx_head && fill() <= 0)
+    return -1;
+  return rx[rx_head++ & RX_MASK];
+}
+
+
+int MySQL_Posix_Client::read(uint8_t *buf, size_t size) {
+  size_t count = 0;
+
+  if (rx_tail == rx_head)
+    fill();
+  while (count < size && rx_head != rx_tail) {
+    size_t at = rx_head & RX_MASK;
+    size_t run = MYSQL_POSIX_RX_SIZE - at;
+    if (run > rx_tail - rx_head)
+      run = rx_tail - rx_head;
+    if (run > size - count)
+      run = size - count;
+    memcpy(buf + count, rx + at, run);
+    count += run;
+    rx_head += run;
+  }
+  return (int)count;
+}
+
+
+int MySQL_Posix_Client::peek() {
+  if (rx_tail == rx_head && fill() <= 0)
+    return -1;
+  return rx[rx_head & RX_MASK];
+}
+
+
+/*
+  flush - Send what is pending, waiting for the socket if needed
+*/
+void MySQL_Posix_Client::flush() {
+  while (fd >= 0 && tx_len) {
+    struct pollfd p = { fd, POLLOUT, 0 };
+    if (send_pending(NULL, 0) < 0 || !tx_len)
+      break;
+    if (waiter)
+      waiter->wait(MYSQL_POSIX_CONNECT_TIMEOUT);
+    else if (poll(&p, 1, MYSQL_POSIX_CONNECT_TIMEOUT) <= 0)
+      break;
+  }
+}
+
+
+void MySQL_Posix_Client::stop() {
+  if (fd >= 0)
+    close(fd);
+  fd = -1;
+  in_progress = false;
+  peer_closed = false;
+  rx_head = 0;
+  rx_tail = 0;
+  tx_len = 0;
+}
+
+
+/*
+  connected - Check the connection
+
+  Returns uint8_t - 1 while the connection is open or received bytes
+                    remain to be read
+*/
+uint8_t MySQL_Posix_Client::connected() {
+  if (fd < 0)
+    return 0;
+  if (!peer_closed)
+    fill();
+  return !peer_closed || rx_tail != rx_head;
+}
+
+
+/*
+  fill - Receive into the free part of the ring buffer
+
+  Returns integer - bytes received, 0 if none, -1 if the connection
+                    closed
+*/
+int MySQL_Posix_Client::fill() {
+  struct iovec parts[2];
+  size_t space = MYSQL_POSIX_RX_SIZE - (rx_tail - rx_head);
+  size_t at = rx_tail & RX_MASK;
+  int count = 1;
+  ssize_t got;
+
+  if (fd < 0 || peer_closed || in_progress || space == 0)
+    return (fd < 0 || peer_closed) ? -1 : 0;
+  parts[0].iov_base = rx + at;
+  parts[0].iov_len = MYSQL_POSIX_RX_SIZE - at;
+  if (parts[0].iov_len > space)
+    parts[0].iov_len = space;
+  if (parts[0].iov_len < space) {
+    parts[1].iov_base = rx;
+    parts[1].iov_len = space - parts[0].iov_len;
+    count = 2;
+  }
+  do {
+    got = readv(fd, parts, count);
+  } while (got < 0 && errno == EINTR);
+  read_calls++;
+  if (got > 0) {
+    rx_tail += got;
+    return (int)got;
+  }
+  if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+    peer_closed = true;
+    return -1;
+  }
+  return 0;
+}
+
+
+/*
+  send_pending - Send the kept bytes followed by new ones
+
+  buf[in]         new bytes (may be NULL)
+  size[in]        number of new bytes
+
+  Returns integer - new bytes not sent, -1 if the connection failed
+*/
+int MySQL_Posix_Client::send_pending(const uint8_t *buf, size_t size) {
+  struct iovec parts[2];
+  int count = 0;
+  ssize_t sent;
+  size_t sent_new;
+
+  if (fd < 0)
+    return -1;
+  if (in_progress)
+    return (int)size;
+  if (tx_len) {
+    parts[count].iov_base = tx;
+    parts[count++].iov_len = tx_len;
+  }
+  if (size) {
+    parts[count].iov_base = (void *)buf;
+    parts[count++].iov_len = size;
+  }
+  if (count == 0)
+    return 0;
+  do {
+#if defined(MSG_NOSIGNAL)
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = parts;
+    msg.msg_iovlen = count;
+    sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+#else
+    sent = writev(fd, parts, count);
+#endif
+  } while (sent < 0 && errno == EINTR);
+  write_calls++;
+  if (sent < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      return (int)size;
+    stop();
+    return -1;
+  }
+  if ((size_t)sent < tx_len) {
+    memmove(tx, tx + sent, tx_len - sent);
+    tx_len -= sent;
+    return (int)size;
+  }
+  sent_new = sent - tx_len;
+  tx_len = 0;
+  return (int)(size - sent_new);
+}
+
+#endif  // MYSQL_POSIX
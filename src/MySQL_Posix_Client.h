@@ -0,0 +1,102 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Posix_Client.h - Client over a POSIX socket for host builds
+
+  This header file defines a Client for Linux (and other POSIX) gateways
+  that run the connector natively instead of on a board. The socket is
+  non-blocking with TCP_NODELAY set: the connector already coalesces its
+  packets (MYSQL_OUT_BUFFER_SIZE) so Nagle would only delay the request.
+
+  Received bytes go to a ring buffer that is filled with one readv() per
+  poll (both free parts of the ring at once). Bytes the socket cannot
+  take yet are kept and sent ahead of the next write in one gather write
+  (writev(), or sendmsg() with MSG_NOSIGNAL where a closed socket would
+  raise SIGPIPE), so write() never blocks.
+
+  Set a MySQL_Wait (e.g. a MySQL_Epoll) with set_wait() to wait for the
+  socket to connect without blocking the thread.
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_POSIX_CLIENT_H
+#define MYSQL_POSIX_CLIENT_H
+
+#if !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+  #define MYSQL_POSIX
+#endif
+
+#ifdef MYSQL_POSIX
+
+#include <MySQL_Packet.h>
+
+// Size of the receive ring buffer (a power of two)
+#ifndef MYSQL_POSIX_RX_SIZE
+  #define MYSQL_POSIX_RX_SIZE   16384
+#endif
+#ifndef MYSQL_POSIX_CONNECT_TIMEOUT
+  #define MYSQL_POSIX_CONNECT_TIMEOUT  5000   // ms
+#endif
+
+class MySQL_Posix_Client : public Client {
+  public:
+    MySQL_Posix_Client();
+    ~MySQL_Posix_Client();
+
+    int connect(IPAddress ip, uint16_t port);
+    int connect(const char *host, uint16_t port);
+    size_t write(uint8_t b);
+    size_t write(const uint8_t *buf, size_t size);
+    int available();
+    int read();
+    int read(uint8_t *buf, size_t size);
+    int peek();
+    void flush();
+    void stop();
+    uint8_t connected();
+    operator bool() { return fd >= 0; }
+    using Print::write;
+
+    void set_wait(MySQL_Wait *w) { waiter = w; }
+    int get_fd() { return fd; }
+    boolean connecting() { return in_progress; }
+    size_t pending() { return tx_len; }
+    unsigned long get_read_calls() { return read_calls; }
+    unsigned long get_write_calls() { return write_calls; }
+
+  private:
+    int fill();
+    int send_pending(const uint8_t *buf, size_t size);
+
+    int fd;
+    boolean in_progress;      // non-blocking connect not finished
+    boolean peer_closed;      // server closed its side
+    MySQL_Wait *waiter;
+    byte rx[MYSQL_POSIX_RX_SIZE];
+    unsigned long rx_head;    // next byte to read
+    unsigned long rx_tail;    // next byte to receive
+    byte *tx;                 // bytes the socket did not take yet
+    size_t tx_len;
+    size_t tx_size;
+    unsigned long read_calls;
+    unsigned long write_calls;
+};
+
+#endif  // MYSQL_POSIX
+
+#endif
@@ -0,0 +1,160 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Row_Map.h - Map result set columns to the members of a struct
+
+  This header file defines the templates used by MySQL_Cursor::fetch_into()
+  to decode a row directly into a user struct. The struct's columns are
+  declared once with MYSQL_ROW_MAP:
+
+    struct Reading {
+      long id;
+      float value;
+      char name[16];
+    };
+
+    MYSQL_ROW_MAP(Reading,
+      MYSQL_COLUMN(Reading, id, "id"),
+      MYSQL_COLUMN(Reading, value, "value"),
+      MYSQL_COLUMN_AT(Reading, name, 2)
+    )
+
+  The conversion of each member is selected at compile time from its type
+  (integers up to 64 bits, bool, float, double and char arrays are
+  supported; other types do not compile). SQL NULL is decoded as 0,
+  false or an empty string.
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_ROW_MAP_H
+#define MYSQL_ROW_MAP_H
+
+#include <Arduino.h>
+#include <stdlib.h>
+
+// Kind of column a struct member can be decoded from
+#define MYSQL_KIND_INT     1   // integer columns only
+#define MYSQL_KIND_REAL    2   // integer, decimal and floating point columns
+#define MYSQL_KIND_STRING  3   // any column
+
+// Decodes one column value (value is NULL for SQL NULL) into an object
+typedef void (*mysql_decode_fn)(void *object, const char *value, int len);
+
+// Describes one mapped column
+typedef struct {
+  const char *name;      // column name or NULL to use index
+  int index;             // column index if name is NULL
+  byte kind;             // MYSQL_KIND_*
+  mysql_decode_fn decode;
+} mysql_column_map;
+
+long mysql_parse_long(const char *value, int len);
+long long mysql_parse_longlong(const char *value, int len);
+double mysql_parse_double(const char *value, int len);
+
+template <typename T> struct MySQL_Value_Int {
+  static const byte kind = MYSQL_KIND_INT;
+  static void decode(T *dst, const char *value, int len) {
+    *dst = value ? (T)mysql_parse_long(value, len) : 0;
+  }
+};
+
+template <typename T> struct MySQL_Value_Int64 {
+  static const byte kind = MYSQL_KIND_INT;
+  static void decode(T *dst, const char *value, int len) {
+    *dst = value ? (T)mysql_parse_longlong(value, len) : 0;
+  }
+};
+
+template <typename T> struct MySQL_Value_Real {
+  static const byte kind = MYSQL_KIND_REAL;
+  static void decode(T *dst, const char *value, int len) {
+    *dst = value ? (T)mysql_parse_double(value, len) : 0;
+  }
+};
+
+// Specialized for each supported member type
+template <typename T> struct MySQL_Value {
+  static_assert(sizeof(T) == 0, "MYSQL_COLUMN: the member type has no "
+                "conversion, use an integer, bool, float, double or char "
+                "array member");
+  static const byte kind = 0;
+  static void decode(T *, const char *, int) {}
+};
+template <> struct MySQL_Value<char> : MySQL_Value_Int<char> {};
+template <> struct MySQL_Value<signed char> : MySQL_Value_Int<signed char> {};
+template <> struct MySQL_Value<unsigned char> : MySQL_Value_Int<unsigned char> {};
+template <> struct MySQL_Value<short> : MySQL_Value_Int<short> {};
+template <> struct MySQL_Value<unsigned short> : MySQL_Value_Int<unsigned short> {};
+template <> struct MySQL_Value<int> : MySQL_Value_Int<int> {};
+template <> struct MySQL_Value<unsigned int> : MySQL_Value_Int<unsigned int> {};
+template <> struct MySQL_Value<long> : MySQL_Value_Int<long> {};
+template <> struct MySQL_Value<unsigned long> : MySQL_Value_Int<unsigned long> {};
+template <> struct MySQL_Value<long long> : MySQL_Value_Int64<long long> {};
+template <> struct MySQL_Value<unsigned long long>
+  : MySQL_Value_Int64<unsigned long long> {};
+template <> struct MySQL_Value<bool> {
+  static const byte kind = MYSQL_KIND_INT;
+  static void decode(bool *dst, const char *value, int len) {
+    *dst = value && mysql_parse_long(value, len) != 0;
+  }
+};
+template <> struct MySQL_Value<float> : MySQL_Value_Real<float> {};
+template <> struct MySQL_Value<double> : MySQL_Value_Real<double> {};
+
+template <size_t N> struct MySQL_Value<char[N]> {
+  static const byte kind = MYSQL_KIND_STRING;
+  static void decode(char (*dst)[N], const char *value, int len) {
+    if (!value)
+      len = 0;
+    if (len > (int)N - 1)
+      len = N - 1;
+    if (len > 0)
+      memcpy(*dst, value, len);
+    (*dst)[len] = 0x00;
+  }
+};
+
+template <typename S, typename T, T S::*member>
+void mysql_decode_member(void *object, const char *value, int len) {
+  MySQL_Value<T>::decode(&(((S *)object)->*member), value, len);
+}
+
+// Declares the columns of struct S, see MYSQL_COLUMN
+template <typename S> struct MySQL_Row_Map;
+
+#define MYSQL_ROW_MAP(S, ...) \
+  template <> struct MySQL_Row_Map<S> { \
+    static const mysql_column_map *columns(int *count) { \
+      static const mysql_column_map map[] = { __VA_ARGS__ }; \
+      *count = sizeof(map) / sizeof(map[0]); \
+      return map; \
+    } \
+  };
+
+// Map member of struct S to the column with the given name
+#define MYSQL_COLUMN(S, member, name) \
+  { name, -1, MySQL_Value<decltype(S::member)>::kind, \
+    &mysql_decode_member<S, decltype(S::member), &S::member> }
+
+// Map member of struct S to the column at the given index
+#define MYSQL_COLUMN_AT(S, member, index) \
+  { NULL, index, MySQL_Value<decltype(S::member)>::kind, \
+    &mysql_decode_member<S, decltype(S::member), &S::member> }
+
+#endif
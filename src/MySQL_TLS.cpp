@@ -0,0 +1,156 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_TLS.cpp - TLS backends and session cache for encrypted connections
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#include <MySQL_TLS.h>
+
+/*
+  Constructor
+
+  lifetime_ms[in]   saved sessions older than this are not offered
+                    (MySQL expires them after 300 seconds by default)
+*/
+MySQL_TLS_Cache::MySQL_TLS_Cache(unsigned long lifetime_ms) {
+  lifetime = lifetime_ms;
+  full = 0;
+  resumed = 0;
+  for (int i = 0; i < MYSQL_TLS_SESSIONS; i++) {
+    entries[i].address = 0;
+    entries[i].data = NULL;
+    entries[i].len = 0;
+  }
+}
+
+
+/*
+  Destructor
+*/
+MySQL_TLS_Cache::~MySQL_TLS_Cache() {
+  clear();
+}
+
+
+/*
+  find - Get the saved session of a server
+
+  server[in]      server IP address
+  port[in]        server port
+
+  Returns mysql_tls_session * - session or NULL if none (or expired)
+*/
+mysql_tls_session *MySQL_TLS_Cache::find(IPAddress server, int port) {
+  uint32_t address = (uint32_t)server;
+
+  for (int i = 0; i < MYSQL_TLS_SESSIONS; i++) {
+    mysql_tls_session *entry = &entries[i];
+    if (entry->data && entry->address == address && entry->port == port) {
+      if (millis() - entry->stored < lifetime)
+        return entry;
+      drop(entry);
+    }
+  }
+  return NULL;
+}
+
+
+/*
+  store - Save the session of a connection
+
+  The session replaces the server's previous one or the oldest entry.
+
+  server[in]      server IP address
+  port[in]        server port
+  tls[in]         backend of the connection
+
+  Returns boolean - True if the session was saved
+*/
+boolean MySQL_TLS_Cache::store(IPAddress server, int port, MySQL_TLS *tls) {
+  mysql_tls_session *entry = find(server, port);
+  byte *data;
+  int len = 0;
+
+  if (entry == NULL) {
+    entry = &entries[0];
+    for (int i = 0; i < MYSQL_TLS_SESSIONS; i++) {
+      if (entries[i].data == NULL) {
+        entry = &entries[i];
+        break;
+      }
+      if (entries[i].stored - entry->stored > 0x7fffffffUL)
+        entry = &entries[i];
+    }
+  }
+  drop(entry);
+  data = tls->save_session(&len);
+  if (data == NULL)
+    return false;
+  entry->len = len;
+  entry->address = (uint32_t)server;
+  entry->port = port;
+  entry->data = data;
+  entry->stored = millis();
+  return true;
+}
+
+
+/*
+  forget - Drop the saved session of a server
+
+  This is done when resuming the session failed.
+
+  server[in]      server IP address
+  port[in]        server port
+*/
+void MySQL_TLS_Cache::forget(IPAddress server, int port) {
+  drop(find(server, port));
+}
+
+
+/*
+  clear - Drop all saved sessions so the next connects do a full handshake
+*/
+void MySQL_TLS_Cache::clear() {
+  for (int i = 0; i < MYSQL_TLS_SESSIONS; i++)
+    drop(&entries[i]);
+}
+
+
+/*
+  count - Count a completed handshake
+
+  was_resumed[in]   True if the handshake resumed a session
+*/
+void MySQL_TLS_Cache::count(boolean was_resumed) {
+  if (was_resumed)
+    resumed++;
+  else
+    full++;
+}
+
+
+void MySQL_TLS_Cache::drop(mysql_tls_session *entry) {
+  if (entry == NULL)
+    return;
+  mysql_free(entry->data);
+  entry->data = NULL;
+  entry->len = 0;
+  entry->address = 0;
+}
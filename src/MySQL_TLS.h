@@ -0,0 +1,111 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_TLS.h - TLS backends and session cache for encrypted connections
+
+  This header file defines the interface a TLS library implements to
+  encrypt a connection (MySQL_Connection::set_tls()). The server switches
+  to TLS after its handshake packet: the connector sends an SSL request
+  packet over the plain client and the backend then runs the TLS
+  handshake over that client and returns the Client used for the rest of
+  the connection.
+
+  A full TLS handshake costs hundreds of milliseconds of CPU on small
+  boards. The backend can save the session after a connection and resume
+  it on the next one, which skips the certificate exchange and the key
+  agreement. MySQL_TLS_Cache keeps the saved sessions per server so
+  reconnects (and the connections of a MySQL_Pool) resume.
+
+  MySQL_TLS_Mbedtls.h is a backend for mbed TLS (ESP32).
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_TLS_H
+#define MYSQL_TLS_H
+
+#include <MySQL_Packet.h>
+
+#ifndef MYSQL_TLS_SESSIONS
+  #define MYSQL_TLS_SESSIONS  4   // servers a MySQL_TLS_Cache remembers
+#endif
+
+class MySQL_TLS {
+  public:
+    virtual ~MySQL_TLS() {}
+
+    /*
+      Run the TLS handshake over a connected transport.
+
+      transport[in]   plain client connected to the server
+      host[in]        server name to verify and send (SNI), may be NULL
+      session[in]     state saved by save_session() to resume, NULL for
+                      a full handshake
+      session_len[in] bytes in session
+
+      Returns Client * - the encrypted connection, NULL on failure. Its
+                         stop() must also stop the transport.
+    */
+    virtual Client *handshake(Client *transport, const char *host,
+                              const byte *session, int session_len) = 0;
+
+    /*
+      Save the state needed to resume the current session.
+
+      len[out]        bytes saved
+
+      Returns byte * - state allocated with mysql_malloc() at the
+                       MYSQL_ALLOC_TLS_SESSION site (the caller frees
+                       it), NULL if the session cannot be resumed
+    */
+    virtual byte *save_session(int *len) = 0;
+
+    // True if the last handshake resumed a session
+    virtual boolean resumed() = 0;
+};
+
+// Structure for one saved TLS session.
+typedef struct {
+  uint32_t address;         // server IP address (0 = free entry)
+  uint16_t port;            // server port
+  byte *data;               // state saved by the backend
+  int len;                  // bytes in data
+  unsigned long stored;     // millis() when saved
+} mysql_tls_session;
+
+class MySQL_TLS_Cache {
+  public:
+    MySQL_TLS_Cache(unsigned long lifetime_ms=300000UL);
+    ~MySQL_TLS_Cache();
+    mysql_tls_session *find(IPAddress server, int port);
+    boolean store(IPAddress server, int port, MySQL_TLS *tls);
+    void forget(IPAddress server, int port);
+    void clear();
+    unsigned long get_full() { return full; }
+    unsigned long get_resumed() { return resumed; }
+    void count(boolean was_resumed);
+
+  private:
+    void drop(mysql_tls_session *entry);
+
+    mysql_tls_session entries[MYSQL_TLS_SESSIONS];
+    unsigned long lifetime;
+    unsigned long full;       // connections with a full handshake
+    unsigned long resumed;    // connections that resumed a session
+};
+
+#endif
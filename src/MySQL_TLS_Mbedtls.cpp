@@ -0,0 +1,399 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_TLS_Mbedtls.cpp - TLS backend using mbed TLS
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#include <MySQL_TLS_Mbedtls.h>
+
+#if defined(ARDUINO_ARCH_ESP32) || defined(MYSQL_TLS_MBEDTLS)
+
+#include <mbedtls/net_sockets.h>
+#if MBEDTLS_VERSION_MAJOR < 3
+  #include <mbedtls/ssl_internal.h>
+#elif defined(MBEDTLS_USE_PSA_CRYPTO) || defined(MBEDTLS_SSL_PROTO_TLS1_3)
+  #include <psa/crypto.h>
+#endif
+
+const char TLS_PERS[] = "MySQL_Connector";
+const char TLS_NO_CA[] PROGMEM =
+  "TLS needs a CA certificate (or set_insecure()).";
+const char TLS_INSECURE[] PROGMEM =
+  "TLS server certificate is not verified.";
+
+/*
+  Constructor
+
+  ca_cert_pem[in]   PEM of the CA to verify the server certificate with
+                    (the string must stay valid). NULL needs
+                    set_insecure().
+*/
+MySQL_TLS_Mbedtls::MySQL_TLS_Mbedtls(const char *ca_cert_pem) {
+  transport = NULL;
+  ca_cert = ca_cert_pem;
+  insecure = false;
+  ready = false;
+  usable = false;
+  active = false;
+  was_resumed = false;
+  peeked = -1;
+}
+
+
+/*
+  Destructor
+*/
+MySQL_TLS_Mbedtls::~MySQL_TLS_Mbedtls() {
+  if (!ready)
+    return;
+  mbedtls_ssl_free(&ssl);
+  mbedtls_ssl_config_free(&conf);
+  mbedtls_x509_crt_free(&ca);
+  mbedtls_ctr_drbg_free(&drbg);
+  mbedtls_entropy_free(&entropy);
+}
+
+
+/*
+  set_insecure - Allow connections without verifying the server
+
+  Without a CA certificate the handshake fails unless this is set, as
+  anyone on the path could then pose as the server. Use it for testing
+  only; a warning is logged when the contexts are set up. Call it
+  before the first connect.
+
+  allow[in]         True = do not verify the server certificate
+*/
+void MySQL_TLS_Mbedtls::set_insecure(boolean allow) {
+  insecure = allow;
+}
+
+
+/*
+  setup - Set up the mbed TLS contexts on first use
+
+  A failed setup is not tried again.
+
+  Returns boolean - True = contexts ready
+*/
+boolean MySQL_TLS_Mbedtls::setup() {
+  if (ready)
+    return usable;
+
+  mbedtls_ssl_init(&ssl);
+  mbedtls_ssl_config_init(&conf);
+  mbedtls_x509_crt_init(&ca);
+  mbedtls_ctr_drbg_init(&drbg);
+  mbedtls_entropy_init(&entropy);
+  ready = true;
+
+#if MBEDTLS_VERSION_MAJOR >= 3 && \
+    (defined(MBEDTLS_USE_PSA_CRYPTO) || defined(MBEDTLS_SSL_PROTO_TLS1_3))
+  if (psa_crypto_init() != PSA_SUCCESS)
+    return false;
+#endif
+  if (mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy,
+                            (const unsigned char *)TLS_PERS,
+                            sizeof(TLS_PERS)) != 0)
+    return false;
+  if (mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT,
+                                  MBEDTLS_SSL_TRANSPORT_STREAM,
+                                  MBEDTLS_SSL_PRESET_DEFAULT) != 0)
+    return false;
+  if (ca_cert) {
+    if (mbedtls_x509_crt_parse(&ca, (const unsigned char *)ca_cert,
+                               strlen(ca_cert) + 1) != 0)
+      return false;
+    mbedtls_ssl_conf_ca_chain(&conf, &ca, NULL);
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+  } else if (insecure) {
+    MYSQL_LOG_W(MYSQL_P(TLS_INSECURE));
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE);
+  } else {
+    MYSQL_LOG_E(MYSQL_P(TLS_NO_CA));
+    return false;
+  }
+  mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+  mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+  usable = mbedtls_ssl_setup(&ssl, &conf) == 0;
+  return usable;
+}
+
+
+/*
+  handshake - Run the TLS handshake over a connected transport
+
+  See MySQL_TLS::handshake(). A session the server does not accept
+  any more falls back to a full handshake.
+*/
+Client *MySQL_TLS_Mbedtls::handshake(Client *transport_client,
+                                     const char *host, const byte *session,
+                                     int session_len) {
+  mbedtls_ssl_session saved;
+  unsigned long started = millis();
+  int ret = 0;
+
+  transport = transport_client;
+  active = false;
+  was_resumed = false;
+  peeked = -1;
+  if (!setup())
+    return NULL;
+  mbedtls_ssl_session_reset(&ssl);
+  if (host)
+    mbedtls_ssl_set_hostname(&ssl, host);
+  mbedtls_ssl_set_bio(&ssl, this, send_cb, recv_cb, NULL);
+
+  if (session && session_len > 0) {
+    mbedtls_ssl_session_init(&saved);
+    if (mbedtls_ssl_session_load(&saved, session, session_len) == 0)
+      mbedtls_ssl_set_session(&ssl, &saved);
+    mbedtls_ssl_session_free(&saved);
+  }
+
+#if MBEDTLS_VERSION_MAJOR < 3
+  // Step through the handshake to see if the server resumed the session
+  while (ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+    ret = mbedtls_ssl_handshake_step(&ssl);
+    if (ssl.handshake && ssl.handshake->resume)
+      was_resumed = true;
+#else
+  while ((ret = mbedtls_ssl_handshake(&ssl)) != 0) {
+#endif
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+      if (millis() - started >= MYSQL_TLS_TIMEOUT)
+        break;
+      delay(1);
+    } else if (ret != 0) {
+      break;
+    }
+  }
+  if (ret != 0)
+    return NULL;
+  active = true;
+  return this;
+}
+
+
+/*
+  save_session - Save the current session (session ID or ticket)
+
+  See MySQL_TLS::save_session().
+*/
+byte *MySQL_TLS_Mbedtls::save_session(int *len) {
+  mbedtls_ssl_session current;
+  size_t size = 0;
+  byte *session = NULL;
+
+  *len = 0;
+  if (!active)
+    return NULL;
+  // mbed TLS exports a session only once, so size and save it together
+  mbedtls_ssl_session_init(&current);
+  if (mbedtls_ssl_get_session(&ssl, &current) == 0) {
+    mbedtls_ssl_session_save(&current, NULL, 0, &size);
+    if (size > 0)
+      session = (byte *)mysql_malloc(size, MYSQL_ALLOC_TLS_SESSION);
+    if (session &&
+        mbedtls_ssl_session_save(&current, session, size, &size) != 0) {
+      mysql_free(session);
+      session = NULL;
+    }
+  }
+  mbedtls_ssl_session_free(&current);
+  if (session)
+    *len = (int)size;
+  return session;
+}
+
+
+int MySQL_TLS_Mbedtls::connect(IPAddress ip, uint16_t port) {
+  if (transport == NULL || !transport->connect(ip, port))
+    return 0;
+  return handshake(transport, NULL, NULL, 0) != NULL;
+}
+
+int MySQL_TLS_Mbedtls::connect(const char *host, uint16_t port) {
+  if (transport == NULL || !transport->connect(host, port))
+    return 0;
+  return handshake(transport, host, NULL, 0) != NULL;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+int MySQL_TLS_Mbedtls::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+  if (transport == NULL || !transport->connect(ip, port, timeout))
+    return 0;
+  return handshake(transport, NULL, NULL, 0) != NULL;
+}
+
+int MySQL_TLS_Mbedtls::connect(const char *host, uint16_t port,
+                               int32_t timeout) {
+  if (transport == NULL || !transport->connect(host, port, timeout))
+    return 0;
+  return handshake(transport, host, NULL, 0) != NULL;
+}
+#endif
+
+size_t MySQL_TLS_Mbedtls::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t MySQL_TLS_Mbedtls::write(const uint8_t *buf, size_t size) {
+  unsigned long started = millis();
+  size_t sent = 0;
+  int ret;
+
+  while (active && sent < size) {
+    ret = mbedtls_ssl_write(&ssl, buf + sent, size - sent);
+    if (ret > 0) {
+      sent += ret;
+    } else if ((ret == MBEDTLS_ERR_SSL_WANT_WRITE ||
+                ret == MBEDTLS_ERR_SSL_WANT_READ) &&
+               millis() - started < MYSQL_TLS_TIMEOUT) {
+      delay(1);
+    } else {
+      break;
+    }
+  }
+  return sent;
+}
+
+
+/*
+  available - Bytes that can be read without waiting
+
+  Records that arrived on the transport are decrypted first.
+*/
+int MySQL_TLS_Mbedtls::available() {
+  int num;
+  int ret;
+
+  if (!active)
+    return 0;
+  num = mbedtls_ssl_get_bytes_avail(&ssl);
+  while (num == 0 && transport->available() > 0) {
+    ret = mbedtls_ssl_read(&ssl, NULL, 0);
+    num = mbedtls_ssl_get_bytes_avail(&ssl);
+    if (ret != 0 && ret != MBEDTLS_ERR_SSL_WANT_READ
+#ifdef MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET
+        && ret != MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET
+#endif
+        )
+      break;
+  }
+  return num + (peeked >= 0 ? 1 : 0);
+}
+
+int MySQL_TLS_Mbedtls::read() {
+  uint8_t b;
+
+  if (read(&b, 1) == 1)
+    return b;
+  return -1;
+}
+
+int MySQL_TLS_Mbedtls::read(uint8_t *buf, size_t size) {
+  int num = 0;
+  int ret;
+
+  if (size == 0)
+    return 0;
+  if (peeked >= 0) {
+    buf[num++] = (uint8_t)peeked;
+    peeked = -1;
+    if (size == 1 || available() == 0)
+      return num;
+  }
+  if (!active)
+    return num ? num : -1;
+  ret = mbedtls_ssl_read(&ssl, buf + num, size - num);
+  if (ret > 0)
+    return num + ret;
+  if (ret == 0 || ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY)
+    stop();
+  return num ? num : -1;
+}
+
+int MySQL_TLS_Mbedtls::peek() {
+  uint8_t b;
+
+  if (peeked < 0 && available() > 0 && read(&b, 1) == 1)
+    peeked = b;
+  return peeked;
+}
+
+void MySQL_TLS_Mbedtls::flush() {
+  if (transport)
+    transport->flush();
+}
+
+
+/*
+  stop - Close the TLS session and the transport
+*/
+void MySQL_TLS_Mbedtls::stop() {
+  if (active) {
+    active = false;
+    mbedtls_ssl_close_notify(&ssl);
+  }
+  peeked = -1;
+  if (transport)
+    transport->stop();
+}
+
+uint8_t MySQL_TLS_Mbedtls::connected() {
+  if (!active)
+    return 0;
+  return transport->connected() || mbedtls_ssl_get_bytes_avail(&ssl) > 0;
+}
+
+
+/*
+  send_cb, recv_cb - Move TLS records over the transport without blocking
+*/
+int MySQL_TLS_Mbedtls::send_cb(void *ctx, const unsigned char *buf,
+                               size_t len) {
+  MySQL_TLS_Mbedtls *tls = (MySQL_TLS_Mbedtls *)ctx;
+  int num;
+
+  if (!tls->transport->connected())
+    return MBEDTLS_ERR_NET_CONN_RESET;
+  num = tls->transport->write(buf, len);
+  return num > 0 ? num : MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+int MySQL_TLS_Mbedtls::recv_cb(void *ctx, unsigned char *buf, size_t len) {
+  MySQL_TLS_Mbedtls *tls = (MySQL_TLS_Mbedtls *)ctx;
+  int avail = tls->transport->available();
+  int num;
+
+  if (avail <= 0)
+    return tls->transport->connected() ? MBEDTLS_ERR_SSL_WANT_READ :
+                                         MBEDTLS_ERR_NET_CONN_RESET;
+  if ((size_t)avail < len)
+    len = avail;
+  num = tls->transport->read(buf, len);
+  if (num <= 0)
+    return MBEDTLS_ERR_SSL_WANT_READ;
+  return num;
+}
+
+#endif  // ARDUINO_ARCH_ESP32 || MYSQL_TLS_MBEDTLS
@@ -0,0 +1,103 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_TLS_Mbedtls.h - TLS backend using mbed TLS
+
+  This header file defines a MySQL_TLS backend for mbed TLS, which is part
+  of the ESP32 core. It runs TLS over any Client (e.g. WiFiClient) and
+  saves sessions (including session tickets) so they can be resumed.
+
+  Give the PEM of the CA that signed the server certificate to verify
+  it. Without one the handshake fails unless set_insecure() allows an
+  unverified server (for testing only, a warning is logged).
+
+  Other boards with mbed TLS can use it by defining MYSQL_TLS_MBEDTLS.
+  mbed TLS 3 does not report whether the server resumed a session, so
+  there resumed() is always false and MySQL_TLS_Cache counts every
+  connect as a full handshake (sessions are still offered and resumed).
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_TLS_MBEDTLS_H
+#define MYSQL_TLS_MBEDTLS_H
+
+#if defined(ARDUINO_ARCH_ESP32) || defined(MYSQL_TLS_MBEDTLS)
+
+#include <MySQL_TLS.h>
+#include <mbedtls/version.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+
+#ifndef MYSQL_TLS_TIMEOUT
+  #define MYSQL_TLS_TIMEOUT  10000   // TLS handshake timeout (ms)
+#endif
+
+class MySQL_TLS_Mbedtls : public MySQL_TLS, public Client {
+  public:
+    MySQL_TLS_Mbedtls(const char *ca_cert_pem=NULL);
+    ~MySQL_TLS_Mbedtls();
+
+    Client *handshake(Client *transport_client, const char *host,
+                      const byte *session, int session_len);
+    byte *save_session(int *len);
+    boolean resumed() { return was_resumed; }
+    void set_insecure(boolean allow);
+
+    int connect(IPAddress ip, uint16_t port);
+    int connect(const char *host, uint16_t port);
+#if defined(ARDUINO_ARCH_ESP32)
+    int connect(IPAddress ip, uint16_t port, int32_t timeout);
+    int connect(const char *host, uint16_t port, int32_t timeout);
+#endif
+    size_t write(uint8_t b);
+    size_t write(const uint8_t *buf, size_t size);
+    int available();
+    int read();
+    int read(uint8_t *buf, size_t size);
+    int peek();
+    void flush();
+    void stop();
+    uint8_t connected();
+    operator bool() { return connected(); }
+    using Print::write;
+
+  private:
+    boolean setup();
+    static int send_cb(void *ctx, const unsigned char *buf, size_t len);
+    static int recv_cb(void *ctx, unsigned char *buf, size_t len);
+
+    Client *transport;        // client the TLS runs over
+    const char *ca_cert;      // PEM of the CA to verify the server with
+    boolean insecure;         // no CA: connect without verification
+    boolean ready;            // mbed TLS contexts initialized
+    boolean usable;           // and configured
+    boolean active;           // handshake done, connection open
+    boolean was_resumed;      // last handshake resumed a session
+    int peeked;               // byte returned by peek(), -1 = none
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt ca;
+};
+
+#endif  // ARDUINO_ARCH_ESP32 || MYSQL_TLS_MBEDTLS
+
+#endif
@@ -0,0 +1,471 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Trace.cpp - Record and replay the traffic of a MySQL connection
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#include <Arduino.h>
+#include <MySQL_Trace.h>
+
+const char TRACE_MAGIC[] PROGMEM = "MYTR";
+const char TRACE_MISMATCH[] PROGMEM =
+  "Replay differs from the trace at written byte ";
+
+/*
+  Constructor
+
+  client_instance[in]  Client used to talk to the server
+  trace_output[in]     Where the trace is written (e.g. an SD File)
+*/
+MySQL_Trace_Recorder::MySQL_Trace_Recorder(Client *client_instance,
+                                           Print *trace_output) {
+  client = client_instance;
+  trace = trace_output;
+  started = false;
+  last_time = 0;
+  read_time = 0;
+  arrived = 0;
+  arrived_time = 0;
+  later = 0;
+  later_time = 0;
+  read_len = 0;
+}
+
+int MySQL_Trace_Recorder::connect(IPAddress ip, uint16_t port) {
+  uint8_t payload[6];
+  int res = client->connect(ip, port);
+  if (res == 1) {
+    for (int i = 0; i < 4; i++)
+      payload[i] = ip[i];
+    payload[4] = (uint8_t)port;
+    payload[5] = (uint8_t)(port >> 8);
+    write_record(MYSQL_TRACE_CONNECT, payload, 6);
+  }
+  return res;
+}
+
+int MySQL_Trace_Recorder::connect(const char *host, uint16_t port) {
+  uint8_t payload[6] = {0, 0, 0, 0, (uint8_t)port, (uint8_t)(port >> 8)};
+  int res = client->connect(host, port);
+  if (res == 1)
+    write_record(MYSQL_TRACE_CONNECT, payload, 6);
+  return res;
+}
+
+size_t MySQL_Trace_Recorder::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t MySQL_Trace_Recorder::write(const uint8_t *buf, size_t size) {
+  flush_reads();
+  write_record(MYSQL_TRACE_WRITE, buf, size);
+  return client->write(buf, size);
+}
+
+/*
+  available - Bytes the server sent that were not read yet
+
+  The first poll that sees a byte stamps its arrival (see arrival()).
+*/
+int MySQL_Trace_Recorder::available() {
+  int num = client->available();
+  if (num > 0 && (unsigned long)num > arrived + later) {
+    unsigned long now = micros();
+    if (arrived == 0) {
+      arrived = num;
+      arrived_time = now;
+    } else {
+      if (later == 0)
+        later_time = now;
+      later = num - arrived;
+    }
+  }
+  return num;
+}
+
+int MySQL_Trace_Recorder::read() {
+  int b = client->read();
+  if (b >= 0) {
+    uint8_t c = (uint8_t)b;
+    record_read(&c, 1);
+  }
+  return b;
+}
+
+int MySQL_Trace_Recorder::read(uint8_t *buf, size_t size) {
+  int num = client->read(buf, size);
+  if (num > 0)
+    record_read(buf, num);
+  return num;
+}
+
+int MySQL_Trace_Recorder::peek() {
+  return client->peek();
+}
+
+void MySQL_Trace_Recorder::flush() {
+  client->flush();
+}
+
+void MySQL_Trace_Recorder::stop() {
+  flush_reads();
+  write_record(MYSQL_TRACE_STOP, NULL, 0);
+  trace->flush();
+  client->stop();
+}
+
+uint8_t MySQL_Trace_Recorder::connected() {
+  return client->connected();
+}
+
+MySQL_Trace_Recorder::operator bool() {
+  return (bool)*client;
+}
+
+
+/*
+  begin_trace - Write the trace header before the first record
+*/
+void MySQL_Trace_Recorder::begin_trace() {
+  for (int i = 0; i < 4; i++)
+    trace->write(pgm_read_byte(TRACE_MAGIC+i));
+  trace->write((uint8_t)MYSQL_TRACE_VERSION);
+  last_time = micros();
+  started = true;
+}
+
+
+/*
+  write_record - Append a record to the trace
+
+  type[in]        record type
+  payload[in]     record payload (may be NULL if len is 0)
+  len[in]         payload length
+*/
+void MySQL_Trace_Recorder::write_record(byte type, const uint8_t *payload,
+                                        size_t len) {
+  unsigned long now = micros();
+  if (!started)
+    begin_trace();
+  // Grouped reads are stamped with the arrival of their first byte
+  if (type == MYSQL_TRACE_READ)
+    now = read_time;
+  // Bytes may arrive before a write that is recorded ahead of them
+  if ((long)(now - last_time) < 0)
+    now = last_time;
+  trace->write(type);
+  write_varint(now - last_time);
+  write_varint(len);
+  if (len > 0)
+    trace->write(payload, len);
+  last_time = now;
+}
+
+
+void MySQL_Trace_Recorder::write_varint(unsigned long value) {
+  while (value >= 0x80) {
+    trace->write((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  trace->write((uint8_t)value);
+}
+
+
+/*
+  arrival - Arrival time of the next byte read
+
+  Bytes are stamped when available() first reported them, which is when
+  they arrived give or take one poll of the connector, not when they are
+  read. Bytes read without being polled for arrived by now.
+
+  len[in]         bytes being read
+
+  Returns unsigned long - micros() when the first of them arrived
+*/
+unsigned long MySQL_Trace_Recorder::arrival(size_t len) {
+  unsigned long stamp = arrived > 0 ? arrived_time : micros();
+
+  while (len > 0 && arrived > 0) {
+    if (len < arrived) {
+      arrived -= len;
+      break;
+    }
+    len -= arrived;
+    arrived = later;
+    arrived_time = later_time;
+    later = 0;
+  }
+  return stamp;
+}
+
+
+/*
+  record_read - Group bytes read from the server into read records
+
+  The connector reads most of the packet byte by byte, so the bytes are
+  collected until the buffer is full or the client writes again. A
+  record is stamped with the arrival of its first byte.
+*/
+void MySQL_Trace_Recorder::record_read(const uint8_t *buf, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    unsigned long stamp = arrival(1);
+    if (read_len == 0)
+      read_time = stamp;
+    read_buffer[read_len++] = buf[i];
+    if (read_len == MYSQL_TRACE_READ_BUFFER)
+      flush_reads();
+  }
+}
+
+
+void MySQL_Trace_Recorder::flush_reads() {
+  if (read_len == 0)
+    return;
+  write_record(MYSQL_TRACE_READ, read_buffer, read_len);
+  read_len = 0;
+}
+
+
+/*
+  Constructor
+
+  trace_input[in]    Trace written by MySQL_Trace_Recorder
+  speed_percent[in]  Replay speed: 100 = as recorded, 1000 = ten times
+                     faster, 0 = no delays at all
+*/
+MySQL_Trace_Replay::MySQL_Trace_Replay(Stream *trace_input,
+                                       int speed_percent) {
+  trace = trace_input;
+  speed = speed_percent;
+  header_read = false;
+  is_connected = false;
+  type = 0;
+  remaining = 0;
+  due = 0;
+  carry = 0;
+  bytes_ignored = 0;
+  bytes_written = 0;
+  mismatch = -1;
+}
+
+
+/*
+  connect - Replay the next connection in the trace
+
+  Records left over from the previous connection are skipped. The
+  records of the connection are due at the recorded times counted from
+  now.
+
+  Returns integer - 1 if the trace has another connection, 0 otherwise
+*/
+int MySQL_Trace_Replay::connect(IPAddress, uint16_t) {
+  while (type != MYSQL_TRACE_CONNECT) {
+    skip_payload();
+    if (!next_record())
+      return 0;
+  }
+  skip_payload();
+  type = 0;
+  due = micros();
+  carry = 0;
+  is_connected = true;
+  return 1;
+}
+
+int MySQL_Trace_Replay::connect(const char *, uint16_t port) {
+  return connect(IPAddress(0, 0, 0, 0), port);
+}
+
+
+/*
+  write - Consume bytes the connector sends to the server
+
+  The bytes are compared with the write records of the trace. Once the
+  recorded writes are consumed the following read records become
+  available, so replies never arrive before the request that caused them.
+  The first byte that differs from the trace, or is written where the
+  trace has none, is logged and its offset kept (see get_mismatch()): the
+  replies that follow were recorded for another request.
+*/
+size_t MySQL_Trace_Replay::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t MySQL_Trace_Replay::write(const uint8_t *buf, size_t size) {
+  size_t left = size;
+
+  while (left > 0) {
+    if (remaining == 0 && type != MYSQL_TRACE_STOP &&
+        type != MYSQL_TRACE_CONNECT && !next_record())
+      break;
+    if (type != MYSQL_TRACE_WRITE)
+      break;
+    while (remaining > 0 && left > 0) {
+      if (trace_byte() != buf[size - left] && mismatch < 0)
+        report_mismatch();
+      bytes_written++;
+      remaining--;
+      left--;
+    }
+  }
+  if (left > 0 && mismatch < 0)
+    report_mismatch();
+  bytes_ignored += left;
+  bytes_written += left;
+  return size;
+}
+
+
+/*
+  report_mismatch - Log the first written byte that differs from the trace
+*/
+void MySQL_Trace_Replay::report_mismatch() {
+  mismatch = (long)bytes_written;
+  MYSQL_LOG_W(MYSQL_P(TRACE_MISMATCH), mismatch, ".");
+}
+
+
+int MySQL_Trace_Replay::available() {
+  if (!is_connected)
+    return 0;
+  if (remaining == 0 && type != MYSQL_TRACE_STOP &&
+      type != MYSQL_TRACE_CONNECT && !next_record())
+    return 0;
+  if (type != MYSQL_TRACE_READ || (long)(micros() - due) < 0)
+    return 0;
+  return remaining > 0x7fff ? 0x7fff : (int)remaining;
+}
+
+int MySQL_Trace_Replay::read() {
+  if (available() <= 0)
+    return -1;
+  remaining--;
+  return trace_byte();
+}
+
+int MySQL_Trace_Replay::read(uint8_t *buf, size_t size) {
+  size_t num = 0;
+  int avail = available();
+
+  while (num < size && avail-- > 0) {
+    buf[num++] = (uint8_t)trace_byte();
+    remaining--;
+  }
+  return num;
+}
+
+int MySQL_Trace_Replay::peek() {
+  if (available() <= 0)
+    return -1;
+  return trace->peek();
+}
+
+
+/*
+  stop - Close the replayed connection
+
+  The rest of the connection's records are skipped when the next
+  connection is replayed.
+*/
+void MySQL_Trace_Replay::stop() {
+  is_connected = false;
+}
+
+uint8_t MySQL_Trace_Replay::connected() {
+  return is_connected;
+}
+
+
+/*
+  next_record - Read the header of the next record
+
+  The record becomes due the recorded delay (scaled by the speed) after
+  the previous record was due, so the due times follow the recording
+  however long the connector took to consume the previous records.
+
+  Returns boolean - True if a record was read
+*/
+boolean MySQL_Trace_Replay::next_record() {
+  unsigned long delta;
+  unsigned long len;
+  int b;
+
+  if (!header_read) {
+    for (int i = 0; i < 4; i++) {
+      if (trace_byte() != pgm_read_byte(TRACE_MAGIC+i)) {
+        type = 0;
+        return false;
+      }
+    }
+    if (trace_byte() != MYSQL_TRACE_VERSION) {
+      type = 0;
+      return false;
+    }
+    header_read = true;
+  }
+
+  b = trace_byte();
+  if (b < 0 || !read_varint(&delta) || !read_varint(&len)) {
+    type = 0;
+    remaining = 0;
+    return false;
+  }
+  type = (byte)b;
+  remaining = len;
+  if (speed <= 0) {
+    due = micros();
+    return true;
+  }
+  if (speed != 100) {
+    carry += (delta % speed) * 100;
+    delta = delta / speed * 100 + carry / speed;
+    carry %= speed;
+  }
+  due += delta;
+  return true;
+}
+
+
+boolean MySQL_Trace_Replay::read_varint(unsigned long *value) {
+  int shift = 0;
+  int b;
+
+  *value = 0;
+  do {
+    b = trace_byte();
+    if (b < 0)
+      return false;
+    *value |= (unsigned long)(b & 0x7f) << shift;
+    shift += 7;
+  } while (b & 0x80);
+  return true;
+}
+
+
+int MySQL_Trace_Replay::trace_byte() {
+  return trace->read();
+}
+
+
+void MySQL_Trace_Replay::skip_payload() {
+  while (remaining > 0) {
+    trace_byte();
+    remaining--;
+  }
+}
@@ -0,0 +1,136 @@
+/*
+  Copyright (c) 2012, 2016 Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+
+  MySQL_Trace.h - Record and replay the traffic of a MySQL connection
+
+  This header file defines two Client classes. MySQL_Trace_Recorder wraps
+  the real client (e.g. EthernetClient) and writes every byte exchanged
+  with the server to a trace (e.g. a File on an SD card). MySQL_Trace_Replay
+  plays a trace back to the connector without a server, at the recorded
+  speed or faster, so a captured session can be used to benchmark the
+  packet and result set code reproducibly.
+
+  Trace format: the 4 byte magic "MYTR" and a version byte followed by
+  records of
+
+  Bytes                        Name
+  -----                        ----
+  1                            type (MYSQL_TRACE_CONNECT, _WRITE, _READ, _STOP)
+  n (varint)                   microseconds since the previous record
+  n (varint)                   payload length
+  n                            payload
+
+  Varints use 7 bits per byte, least significant group first.
+
+  Change History:
+
+  Version 1.3.0 Created, October 2026.
+*/
+#ifndef MYSQL_TRACE_H
+#define MYSQL_TRACE_H
+
+#include <MySQL_Packet.h>
+
+#define MYSQL_TRACE_VERSION   1
+#define MYSQL_TRACE_CONNECT   'C'   // payload: IP address (4) and port (2)
+#define MYSQL_TRACE_WRITE     'W'   // bytes sent to the server
+#define MYSQL_TRACE_READ      'R'   // bytes received from the server
+#define MYSQL_TRACE_STOP      'S'   // connection closed, no payload
+
+#ifndef MYSQL_TRACE_READ_BUFFER
+  #define MYSQL_TRACE_READ_BUFFER 64  // reads are grouped in records this big
+#endif
+
+class MySQL_Trace_Recorder : public Client {
+  public:
+    MySQL_Trace_Recorder(Client *client_instance, Print *trace_output);
+    int connect(IPAddress ip, uint16_t port);
+    int connect(const char *host, uint16_t port);
+    size_t write(uint8_t b);
+    size_t write(const uint8_t *buf, size_t size);
+    int available();
+    int read();
+    int read(uint8_t *buf, size_t size);
+    int peek();
+    void flush();
+    void stop();
+    uint8_t connected();
+    operator bool();
+    using Print::write;
+
+  private:
+    void begin_trace();
+    void write_record(byte type, const uint8_t *payload, size_t len);
+    void write_varint(unsigned long value);
+    unsigned long arrival(size_t len);
+    void record_read(const uint8_t *buf, size_t len);
+    void flush_reads();
+
+    Client *client;
+    Print *trace;
+    boolean started;
+    unsigned long last_time;
+    unsigned long read_time;
+    unsigned long arrived;        // unread bytes seen by available()
+    unsigned long arrived_time;   // micros() when the first was seen
+    unsigned long later;          // unread bytes seen by later polls
+    unsigned long later_time;     // micros() when the first was seen
+    uint8_t read_buffer[MYSQL_TRACE_READ_BUFFER];
+    int read_len;
+};
+
+class MySQL_Trace_Replay : public Client {
+  public:
+    MySQL_Trace_Replay(Stream *trace_input, int speed_percent=100);
+    void set_speed(int speed_percent) { speed = speed_percent; }
+    int connect(IPAddress ip, uint16_t port);
+    int connect(const char *host, uint16_t port);
+    size_t write(uint8_t b);
+    size_t write(const uint8_t *buf, size_t size);
+    int available();
+    int read();
+    int read(uint8_t *buf, size_t size);
+    int peek();
+    void flush() {}
+    void stop();
+    uint8_t connected();
+    operator bool() { return connected(); }
+    unsigned long get_bytes_ignored() { return bytes_ignored; }
+    long get_mismatch() { return mismatch; }
+    using Print::write;
+
+  private:
+    boolean next_record();
+    boolean read_varint(unsigned long *value);
+    int trace_byte();
+    void skip_payload();
+    void report_mismatch();
+
+    Stream *trace;
+    int speed;
+    boolean header_read;
+    boolean is_connected;
+    byte type;              // type of the current record, 0 = none
+    unsigned long remaining;  // payload bytes left in the current record
+    unsigned long due;        // micros() when the current record is due
+    unsigned long carry;      // remainder of the scaled delays
+    unsigned long bytes_ignored;  // written bytes not in the trace
+    unsigned long bytes_written;  // bytes written since the replay started
+    long mismatch;            // offset of the first written byte that
+                              // differs from the trace, -1 = none
+};
+
+#endif